@@ -8,8 +8,12 @@
 #include <gflags/gflags.h>
 #include <json.hpp>
 #include <stdio.h>
+#include <fstream>
+#include "chess/alloc.h"
 #include "chess/board.h"
 #include "chess/game.h"
+#include "chess/ponder.h"
+#include "chess/trace.h"
 #include "cinder/ImageIo.h"
 #include "cinder/audio/audio.h"
 #include "cinder/gl/Texture.h"
@@ -26,12 +30,23 @@ using nlohmann::json;
 DECLARE_uint32(game_id);
 DECLARE_string(color);
 DECLARE_string(url);
+DECLARE_string(trace);
+DECLARE_bool(ponder);
+DECLARE_bool(auto_reply);
 
 ci::audio::VoiceRef err_sound;
 std::string kFont = "Arial Bold";
 size_t kFontSize = 60;
+// The colors of the board's squares.
+const cinder::Color kLightColor = cinder::Color::white();
+const cinder::Color kDarkColor = {.4867f, .5843f, .17725f};
+// The color of a selected square.
+const cinder::Color kSelectedColor = {.859f, .850f, .100f};
+// The color of the squares of a hinted move.
+const cinder::Color kHintColor = {.416f, .631f, .851f};
 
-MyApp::MyApp() : game_(game::Game(FLAGS_game_id)) {
+MyApp::MyApp()
+    : game_(game::Game(FLAGS_game_id)), ponderer_(&table_) {
   if (FLAGS_color == "black") {
     player_ = game_.black_;
     pov_ = piece::Color::kBlack;
@@ -48,6 +63,8 @@ MyApp::MyApp() : game_(game::Game(FLAGS_game_id)) {
   if (url_.empty()) {
     player_ = nullptr;
   }
+  trace::SetEnabled(!FLAGS_trace.empty());
+  ResetHint();
 }
 
 void MyApp::setup() {
@@ -57,8 +74,16 @@ void MyApp::setup() {
   err_sound = cinder::audio::Voice::create(err);
 }
 
-void MyApp::update() {
+void MyApp::cleanup() {
+  ponderer_.Stop();
+  if (!FLAGS_trace.empty()) {
+    std::ofstream out(FLAGS_trace);
+    trace::WriteChromeTrace(out);
+  }
+}
 
+void MyApp::update() {
+  CHESS_TRACE_SCOPE("MyApp::update");
   if (player_ != nullptr && !url_.empty()) {
     GetUpdate();
   }
@@ -80,6 +105,7 @@ void MyApp::update() {
   // If playing the move is successful
   auto m = turn_->PlayMove(origin_square_, destination_square_, &game_);
   if (game_.PlayTurn(m)) {
+    ResetHint();
     if (turn_ == game_.white_) {
       turn_ = game_.black_;
     } else {
@@ -96,6 +122,7 @@ void MyApp::update() {
 }
 
 void MyApp::draw() {
+  CHESS_TRACE_SCOPE("MyApp::draw");
   if (state_ != game::GameState::kIP) {
     DrawGameOver();
     return;
@@ -144,16 +171,21 @@ void MyApp::mouseDown(MouseEvent event) {
 }
 
 void MyApp::DrawBoard() {
+  CHESS_ALLOC_SCOPE("DrawBoard");
+  CHESS_TRACE_SCOPE("MyApp::DrawBoard");
   cinder::gl::clear();
   Rectf rect;
   for (size_t j = 0; j < board::kSize; j++) {
     for (size_t i = 0; i < board::kSize; i++) {
       const board::Square *s = game_.board_->At(i, j);
       // When the square is not selected, set it to the appropriate color.
-      cinder::gl::color(s->sq_color_);
+      cinder::gl::color((s->x_ + s->y_) % 2 == 0 ? kLightColor : kDarkColor);
+      if (hint_.from_ == s || hint_.to_ == s) {
+        cinder::gl::color(kHintColor);
+      }
       if (origin_square_ == s && !destination_square_) {
         // If the square is selected, highlight it yellow.
-        cinder::gl::color(board::yellow);
+        cinder::gl::color(kSelectedColor);
       }
       if (pov_ == piece::Color::kBlack) {
         rect = {static_cast<float>(s->x_ * kSquareSize),
@@ -184,6 +216,11 @@ void MyApp::ResetMoves() {
   destination_square_ = nullptr;
 }
 
+void MyApp::ResetHint() {
+  hint_.from_ = nullptr;
+  hint_.to_ = nullptr;
+}
+
 // CURL callback function for get request.
 size_t WriteCallBack(void *contents, size_t size, size_t nmemb, void *userp) {
   ((std::string *)userp)->append((char *)contents, size * nmemb);
@@ -219,6 +256,8 @@ void MyApp::DrawGameOver() {
 }
 
 void MyApp::GetUpdate() {
+  CHESS_ALLOC_SCOPE("GetUpdate");
+  CHESS_TRACE_SCOPE("MyApp::GetUpdate");
   std::string buffer;
   CURLcode res;
   CURL *curl;
@@ -233,7 +272,11 @@ void MyApp::GetUpdate() {
                      ());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallBack);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
-    res = curl_easy_perform(curl);
+    {
+      // Blocks the frame for up to the 5 second timeout.
+      CHESS_TRACE_SCOPE("GetUpdate/curl_easy_perform");
+      res = curl_easy_perform(curl);
+    }
     if (res != CURLE_OK) {
       std::cout << "Server Error" + std::to_string(res);
     }
@@ -268,6 +311,7 @@ void MyApp::GetUpdate() {
     }
     game_.PlayTurn(to_play);
     last_move_ = to_play;
+    AnswerReply(to_play);
     game::Move to_return;
     to_return.player_ = game_.white_;
     if (player_ == game_.white_) {
@@ -280,6 +324,7 @@ void MyApp::GetUpdate() {
 }
 
 void MyApp::PostUpdate(const game::Move move) {
+  CHESS_TRACE_SCOPE("MyApp::PostUpdate");
   std::stringstream move_stream;
   move_stream << move;
   CURLcode res;
@@ -295,13 +340,43 @@ void MyApp::PostUpdate(const game::Move move) {
     curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
     curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
     curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_0);
-    res = curl_easy_perform(curl);
+    {
+      CHESS_TRACE_SCOPE("PostUpdate/curl_easy_perform");
+      res = curl_easy_perform(curl);
+    }
     if (res != kRequestOK) {
       std::cout << "Error connecting to server.";
     }
     curl_easy_cleanup(curl);
     last_move_ = move;
   }
+  if (FLAGS_ponder) {
+    ponderer_.Start(game_);
+  }
+}
+
+void MyApp::AnswerReply(const game::Move& reply) {
+  CHESS_TRACE_SCOPE("MyApp::AnswerReply");
+  ponderer_.Stop();
+  ponder::Answer answer;
+  if (!ponderer_.Lookup(game::ToUci(reply), &answer)) {
+    return;
+  }
+  for (const game::Move& m : game_.LegalMoves(player_)) {
+    if (game::ToUci(m) != answer.move_) {
+      continue;
+    }
+    if (!FLAGS_auto_reply) {
+      hint_ = m;
+      return;
+    }
+    if (game_.PlayTurn(m)) {
+      turn_ = turn_ == game_.white_ ? game_.black_ : game_.white_;
+      PostUpdate(m);
+      state_ = game_.EvaluateBoard();
+    }
+    return;
+  }
 }
 }  // namespace myapp
 
@@ -6,6 +6,8 @@
 #include <cinder/app/App.h>
 #include <vector>
 #include <chess/game.h>
+#include <chess/ponder.h>
+#include <chess/tt.h>
 
 namespace myapp {
 
@@ -16,6 +18,9 @@ class MyApp : public cinder::app::App {
   // Constructor for the Cinder app
   MyApp();
   void setup() override;
+  // Stops pondering and writes the trace file if tracing was requested with
+  // --trace.
+  void cleanup() override;
   void update() override;
   void draw() override;
   // Activated when the player clicks a square
@@ -54,14 +59,28 @@ class MyApp : public cinder::app::App {
   // The state of the game. Choices are in progress, drawn, white wins and
   // black wins.
   game::GameState state_;
+  // Shared by the ponder searches, so a reply that was not predicted is
+  // still searched from a warm table.
+  tt::Table table_;
+  // Searches the opponent's position while they think, from when our move
+  // is posted until their reply arrives.
+  ponder::Ponderer ponderer_;
+  // The answer pondering found to the opponent's last reply, highlighted
+  // on the board. Its squares are nullptr when there is none.
+  game::Move hint_;
   // Resets the origin and destination squares to their original states
   // (nullptr).
   void ResetMoves();
   // Receives an update from the server and updates the instance variables to
   // reflect the new game state.
   void GetUpdate();
-  // Posts a legal move to the server.
+  // Posts a legal move to the server and starts pondering the opponent's
+  // reply.
   void PostUpdate(const game::Move move);
+  // Looks the opponent's reply up in what pondering found. On a hit, plays
+  // the answer with --auto_reply, or else shows it as a hint.
+  void AnswerReply(const game::Move& reply);
+  void ResetHint();
 };
 }  // namespace myapp
 
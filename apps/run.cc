@@ -25,6 +25,15 @@ DEFINE_string(color, "",
               "player mode.");
 DEFINE_string(url, "", "the http server url");
 DEFINE_uint32(game_id, 0, "the game id on the server.");
+DEFINE_string(trace, "",
+              "if set, record a trace of every frame and write it to this "
+              "file as Chrome trace JSON when the app exits.");
+DEFINE_bool(ponder, true,
+            "in a multiplayer game, search the opponent's likely replies "
+            "while they think.");
+DEFINE_bool(auto_reply, false,
+            "when the opponent plays a reply pondering predicted, play its "
+            "answer instead of highlighting it as a hint.");
 
 void ParseArgs(std::vector<std::string>* args) {
   gflags::SetUsageMessage(
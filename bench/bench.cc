@@ -0,0 +1,33 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <gflags/gflags.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "harness.h"
+#include "suite.h"
+
+DEFINE_string(filter, "", "only run benchmarks whose name contains this.");
+DEFINE_string(out, "", "file to write the JSON results to (default stdout).");
+DEFINE_uint32(samples, 30, "number of timed samples per benchmark.");
+DEFINE_double(min_time_ms, 300, "time budget per benchmark in milliseconds.");
+
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Benchmark the chess library. Pass --helpshort for "
+                          "options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  bench::Runner runner(FLAGS_samples, FLAGS_min_time_ms, FLAGS_filter);
+  bench::RunSuite(&runner);
+
+  const std::string results = runner.ToJson().dump(2);
+  if (FLAGS_out.empty()) {
+    std::cout << results << std::endl;
+  } else {
+    std::ofstream out(FLAGS_out);
+    out << results << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,175 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/bitbase.h>
+#include <chess/pool.h>
+#include <gflags/gflags.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+DEFINE_string(endgames, "KPK,KRK,KQK,KBNK,KRKP",
+              "comma-separated endgames to generate, with those their "
+              "captures and promotions lead to.");
+DEFINE_uint32(threads, 0, "generator threads, 0 for the hardware thread "
+              "count.");
+DEFINE_string(dir, ".", "the directory the bitbases are written to and "
+              "mapped back from.");
+DEFINE_uint64(probes, 1000000, "random probes timed per endgame.");
+
+namespace {
+
+auto Seconds(std::chrono::steady_clock::time_point start) -> double {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+auto TypeOf(char c) -> piece::PieceType {
+  switch (c) {
+    case 'K':
+      return piece::PieceType::kKing;
+    case 'Q':
+      return piece::PieceType::kQueen;
+    case 'R':
+      return piece::PieceType::kRook;
+    case 'B':
+      return piece::PieceType::kBishop;
+    case 'N':
+      return piece::PieceType::kKnight;
+    default:
+      return piece::PieceType::kPawn;
+  }
+}
+
+// Random placements of the endgame's pieces, pawns off the back ranks,
+// with a random side to move. Some are illegal, which probes as fast.
+struct Placement {
+  bitbase::PieceOn pieces_[bitbase::kMaxPieces];
+  bool white_to_move_;
+};
+
+auto RandomPlacements(const std::string& name, size_t n)
+    -> std::vector<Placement> {
+  std::mt19937_64 random(n);
+  std::vector<Placement> placements(n);
+  for (Placement& p : placements) {
+    piece::Color color = piece::Color::kBlack;
+    for (size_t i = 0; i < name.size(); i++) {
+      if (name[i] == 'K') {
+        color = color == piece::Color::kWhite ? piece::Color::kBlack
+                                              : piece::Color::kWhite;
+      }
+      const piece::PieceType type = TypeOf(name[i]);
+      const size_t square = type == piece::PieceType::kPawn
+                                ? 8 + random() % 48
+                                : random() % 64;
+      p.pieces_[i] = {type, color, square};
+    }
+    p.white_to_move_ = random() % 2 == 0;
+  }
+  return placements;
+}
+
+}  // namespace
+
+// Generates endgame bitbases, reporting the time each took, writes them,
+// maps them back and times random probes.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Generate endgame bitbases and time probing. Pass "
+                          "--helpshort for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  pool::ThreadPool workers(FLAGS_threads);
+  bitbase::Tables generated;
+  std::vector<bitbase::Report> reports;
+  std::stringstream names(FLAGS_endgames);
+  std::string name;
+  const auto start = std::chrono::steady_clock::now();
+  while (std::getline(names, name, ',')) {
+    generated.Generate(name, &workers, &reports);
+  }
+  const double total = Seconds(start);
+
+  std::cout << workers.Size() << " threads\n"
+            << std::setw(8) << "endgame" << std::setw(12) << "positions"
+            << std::setw(8) << "rounds" << std::setw(10) << "seconds"
+            << std::setw(12) << "Mpos/s" << std::setw(12) << "KiB"
+            << std::setw(10) << "wtm won" << "\n";
+  for (const bitbase::Report& r : reports) {
+    const bitbase::Bitbase* table = generated.Find(r.name_);
+    const bitbase::Counts& counts = table->Generated(true);
+    const uint64_t legal = counts.wins_ + counts.draws_ + counts.losses_;
+    std::cout << std::setw(8) << r.name_ << std::setw(12)
+              << 2 * r.positions_ << std::setw(8) << r.rounds_ << std::fixed
+              << std::setprecision(2) << std::setw(10) << r.seconds_
+              << std::setw(12) << 2 * r.positions_ / r.seconds_ / 1e6
+              << std::setw(12) << table->Bytes() / 1024 << std::setw(9)
+              << std::setprecision(1)
+              << (legal ? 100.0 * counts.wins_ / legal : 0) << "%\n";
+  }
+  std::cout << "generated in " << std::setprecision(2) << total << " s\n\n";
+
+  generated.Write(FLAGS_dir);
+  bitbase::Tables mapped;
+  const size_t loaded = mapped.Load(FLAGS_dir);
+  std::cout << "mapped " << loaded << " bitbases from " << FLAGS_dir
+            << "\n"
+            << std::setw(8) << "endgame" << std::setw(14) << "ns/probe"
+            << std::setw(14) << "ns/direct" << std::setw(14) << "mismatches"
+            << "\n";
+  for (const bitbase::Report& r : reports) {
+    const std::vector<Placement> placements =
+        RandomPlacements(r.name_, FLAGS_probes);
+    const size_t n = r.name_.size();
+    size_t mismatches = 0;
+    for (size_t i = 0; i < placements.size() && i < 10000; i++) {
+      const Placement& p = placements[i];
+      mismatches += mapped.Probe(p.pieces_, n, p.white_to_move_) !=
+                    generated.Probe(p.pieces_, n, p.white_to_move_);
+    }
+    const auto probe_start = std::chrono::steady_clock::now();
+    uint64_t wins = 0;
+    for (const Placement& p : placements) {
+      wins += mapped.Probe(p.pieces_, n, p.white_to_move_) ==
+              bitbase::Wdl::kWin;
+    }
+    const double seconds = Seconds(probe_start);
+
+    // The same positions probed on the bitbase itself, the pieces already
+    // in its order: both kings, then the others.
+    const bitbase::Bitbase* table = mapped.Find(r.name_);
+    const size_t black_king = r.name_.find('K', 1);
+    std::vector<size_t> squares;
+    squares.reserve(n * placements.size());
+    for (const Placement& p : placements) {
+      squares.push_back(p.pieces_[0].square_);
+      squares.push_back(p.pieces_[black_king].square_);
+      for (size_t i = 1; i < n; i++) {
+        if (i != black_king) {
+          squares.push_back(p.pieces_[i].square_);
+        }
+      }
+    }
+    const auto direct_start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < placements.size(); i++) {
+      wins += table->Probe(&squares[i * n], placements[i].white_to_move_) ==
+              bitbase::Wdl::kWin;
+    }
+    const double direct = Seconds(direct_start);
+    std::cout << std::setw(8) << r.name_ << std::setw(14)
+              << std::setprecision(1)
+              << seconds * 1e9 / static_cast<double>(placements.size())
+              << std::setw(14)
+              << direct * 1e9 / static_cast<double>(placements.size())
+              << std::setw(14) << mismatches << "\n";
+    // Keeps the probes from being optimized away.
+    if (wins > 2 * placements.size()) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,260 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <json.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+#include "suite.h"
+
+DEFINE_string(baseline, "bench/baseline.json",
+              "the stored baseline results to compare against.");
+DEFINE_string(current, "",
+              "compare this chess_bench JSON file instead of running the "
+              "benchmarks.");
+DEFINE_string(filter, "", "only run benchmarks whose name contains this.");
+DEFINE_uint32(samples, 30, "number of timed samples per benchmark.");
+DEFINE_double(min_time_ms, 300, "time budget per benchmark in milliseconds.");
+DEFINE_double(alpha, 0.01,
+              "significance level of the Mann-Whitney test for a slowdown.");
+DEFINE_double(threshold, 0.05,
+              "relative slowdown of a tracked benchmark that fails the run, "
+              "unless the baseline sets its own threshold.");
+DEFINE_bool(update_baseline, false,
+            "write the current results to --baseline, keeping its "
+            "thresholds, instead of comparing.");
+
+namespace bench {
+
+using nlohmann::json;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Outcome of comparing one benchmark against its baseline.
+struct Comparison {
+  string name;
+  double baseline_ns;
+  double current_ns;
+  double change;
+  double p_value;
+  double baseline_allocs;
+  double current_allocs;
+  bool tracked;
+  bool regressed;
+};
+
+auto Median(vector<double> values) -> double {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t mid = values.size() / 2;
+  if (values.size() % 2 == 1) {
+    return values[mid];
+  }
+  return (values[mid - 1] + values[mid]) / 2;
+}
+
+// One-sided Mann-Whitney U test. Returns the p-value of the hypothesis that
+// values drawn from current tend to be larger than values from baseline,
+// using the normal approximation with tie and continuity corrections.
+auto MannWhitneyGreater(const vector<double>& current,
+                        const vector<double>& baseline) -> double {
+  const size_t n1 = current.size();
+  const size_t n2 = baseline.size();
+  if (n1 == 0 || n2 == 0) {
+    return 1;
+  }
+  // (value, belongs to current) pairs ranked together.
+  vector<std::pair<double, bool>> all;
+  for (double v : current) {
+    all.emplace_back(v, true);
+  }
+  for (double v : baseline) {
+    all.emplace_back(v, false);
+  }
+  std::sort(all.begin(), all.end());
+  const double n = static_cast<double>(all.size());
+  double rank_sum = 0;
+  double tie_term = 0;
+  for (size_t i = 0; i < all.size();) {
+    size_t j = i;
+    // Sorted, so a value not above all[i]'s is tied with it.
+    while (j < all.size() && !(all[i].first < all[j].first)) {
+      j++;
+    }
+    // Tied values share the average of their ranks (1-based).
+    double rank = (static_cast<double>(i + j) + 1) / 2;
+    double ties = static_cast<double>(j - i);
+    tie_term += ties * ties * ties - ties;
+    for (size_t k = i; k < j; k++) {
+      if (all[k].second) {
+        rank_sum += rank;
+      }
+    }
+    i = j;
+  }
+  const double m1 = static_cast<double>(n1);
+  const double m2 = static_cast<double>(n2);
+  const double u = rank_sum - m1 * (m1 + 1) / 2;
+  const double mean = m1 * m2 / 2;
+  const double variance =
+      m1 * m2 / 12 * ((n + 1) - tie_term / (n * (n - 1)));
+  if (variance <= 0) {
+    return u > mean ? 0 : 1;
+  }
+  const double z = (u - mean - 0.5) / std::sqrt(variance);
+  return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+// Returns the threshold of the first baseline threshold key contained in the
+// name, or a negative number if the benchmark is not tracked.
+auto ThresholdFor(const string& name, const json& thresholds) -> double {
+  for (auto it = thresholds.begin(); it != thresholds.end(); ++it) {
+    if (name.find(it.key()) != string::npos) {
+      return it.value().is_number() ? it.value().get<double>()
+                                    : FLAGS_threshold;
+    }
+  }
+  return -1;
+}
+
+auto Compare(const json& baseline, const json& current)
+    -> vector<Comparison> {
+  std::map<string, json> base_by_name;
+  for (const json& b : baseline["benchmarks"]) {
+    base_by_name[b["name"].get<string>()] = b;
+  }
+  const json thresholds = baseline.value("thresholds", json::object());
+  vector<Comparison> comparisons;
+  for (const json& c : current["benchmarks"]) {
+    const string name = c["name"].get<string>();
+    auto base = base_by_name.find(name);
+    if (base == base_by_name.end()) {
+      continue;
+    }
+    const vector<double> base_samples =
+        base->second["samples_ns"].get<vector<double>>();
+    const vector<double> samples = c["samples_ns"].get<vector<double>>();
+    Comparison cmp;
+    cmp.name = name;
+    cmp.baseline_ns = Median(base_samples);
+    cmp.current_ns = Median(samples);
+    cmp.change = cmp.baseline_ns > 0 ? cmp.current_ns / cmp.baseline_ns - 1
+                                     : 0;
+    cmp.p_value = MannWhitneyGreater(samples, base_samples);
+    cmp.baseline_allocs = base->second["allocs_per_op"].get<double>();
+    cmp.current_allocs = c["allocs_per_op"].get<double>();
+    const double threshold = ThresholdFor(name, thresholds);
+    cmp.tracked = threshold >= 0;
+    // A slowdown only counts when it is both large and significant. The
+    // allocation counts are deterministic, so any real growth counts.
+    const bool slower = cmp.change > threshold && cmp.p_value < FLAGS_alpha;
+    const bool more_allocs =
+        cmp.current_allocs > cmp.baseline_allocs * (1 + threshold) + 0.5;
+    cmp.regressed = cmp.tracked && (slower || more_allocs);
+    comparisons.push_back(cmp);
+  }
+  return comparisons;
+}
+
+void PrintTable(const vector<Comparison>& comparisons) {
+  std::cout << std::left << std::setw(36) << "benchmark" << std::right
+            << std::setw(14) << "base ns" << std::setw(14) << "current ns"
+            << std::setw(10) << "change" << std::setw(10) << "p" << std::setw(12)
+            << "base alloc" << std::setw(12) << "cur alloc" << "  status\n";
+  std::cout << std::fixed;
+  for (const Comparison& c : comparisons) {
+    string status = "ok";
+    if (!c.tracked) {
+      status = "untracked";
+    } else if (c.regressed) {
+      status = "REGRESSED";
+    } else if (c.change < 0 && c.p_value > 1 - FLAGS_alpha) {
+      status = "improved";
+    }
+    std::cout << std::left << std::setw(36) << c.name << std::right
+              << std::setprecision(1) << std::setw(14) << c.baseline_ns
+              << std::setw(14) << c.current_ns << std::setw(9)
+              << c.change * 100 << "%" << std::setprecision(4)
+              << std::setw(10) << c.p_value << std::setprecision(2)
+              << std::setw(12) << c.baseline_allocs << std::setw(12)
+              << c.current_allocs << "  " << status << "\n";
+  }
+}
+
+auto ReadJson(const string& path, json* out) -> bool {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  try {
+    in >> *out;
+  } catch (nlohmann::json::parse_error& e) {
+    std::cerr << path << ": " << e.what() << "\n";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+}  // namespace bench
+
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Compare the chess library benchmarks against a "
+                          "stored baseline. Pass --helpshort for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  bench::json baseline;
+  const bool have_baseline = bench::ReadJson(FLAGS_baseline, &baseline);
+  if (!have_baseline && !FLAGS_update_baseline) {
+    std::cerr << "could not read baseline " << FLAGS_baseline << "\n";
+    return 2;
+  }
+
+  bench::json current;
+  if (!FLAGS_current.empty()) {
+    if (!bench::ReadJson(FLAGS_current, &current)) {
+      std::cerr << "could not read " << FLAGS_current << "\n";
+      return 2;
+    }
+  } else {
+    bench::Runner runner(FLAGS_samples, FLAGS_min_time_ms, FLAGS_filter);
+    bench::RunSuite(&runner);
+    current = runner.ToJson();
+  }
+
+  if (FLAGS_update_baseline) {
+    if (have_baseline && baseline.contains("thresholds")) {
+      current["thresholds"] = baseline["thresholds"];
+    }
+    std::ofstream out(FLAGS_baseline);
+    out << current.dump(1) << std::endl;
+    std::cout << "wrote " << FLAGS_baseline << "\n";
+    return 0;
+  }
+
+  const std::vector<bench::Comparison> comparisons =
+      bench::Compare(baseline, current);
+  bench::PrintTable(comparisons);
+  size_t regressions = 0;
+  for (const bench::Comparison& c : comparisons) {
+    regressions += c.regressed ? 1 : 0;
+  }
+  if (regressions > 0) {
+    std::cout << regressions << " tracked benchmark(s) regressed\n";
+    return 1;
+  }
+  std::cout << "no regressions\n";
+  return 0;
+}
@@ -0,0 +1,181 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "harness.h"
+
+#include <chess/alloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace {
+
+#ifndef CHESS_TRACK_ALLOCATIONS
+std::atomic<uint64_t> allocation_count(0);
+std::atomic<uint64_t> allocation_bytes(0);
+#endif
+
+// Returns the value at the given percentile (0 - 100) of sorted values.
+auto Percentile(const std::vector<double>& sorted, double percentile)
+    -> double {
+  if (sorted.empty()) {
+    return 0;
+  }
+  double rank = percentile / 100.0 * static_cast<double>(sorted.size() - 1);
+  size_t low = static_cast<size_t>(rank);
+  size_t high = std::min(low + 1, sorted.size() - 1);
+  double weight = rank - static_cast<double>(low);
+  return sorted[low] * (1 - weight) + sorted[high] * weight;
+}
+
+}  // namespace
+
+#ifndef CHESS_TRACK_ALLOCATIONS
+// Counting replacements of the global allocation functions, unless the
+// library already replaces them. The array forms forward to these by default.
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC cannot see that free matches the malloc in the replaced operator new.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+#endif
+
+namespace bench {
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+auto AllocationCount() -> uint64_t {
+#ifdef CHESS_TRACK_ALLOCATIONS
+  return alloc::TotalAllocations();
+#else
+  return allocation_count.load(std::memory_order_relaxed);
+#endif
+}
+
+auto AllocationBytes() -> uint64_t {
+#ifdef CHESS_TRACK_ALLOCATIONS
+  return alloc::TotalBytes();
+#else
+  return allocation_bytes.load(std::memory_order_relaxed);
+#endif
+}
+
+Runner::Runner(size_t samples, double min_time_ms, std::string filter)
+    : samples_(std::max<size_t>(samples, 1)),
+      min_time_ms_(min_time_ms),
+      filter_(std::move(filter)) {}
+
+void Runner::Run(const std::string& name,
+                 const std::function<void(size_t)>& op,
+                 const std::function<void(size_t)>& prepare) {
+  if (!filter_.empty() && name.find(filter_) == std::string::npos) {
+    return;
+  }
+  // Times one batch of the given size, excluding the prepare step.
+  auto time_batch = [&](size_t batch) -> double {
+    if (prepare) {
+      prepare(batch);
+    }
+    auto start = steady_clock::now();
+    for (size_t i = 0; i < batch; i++) {
+      op(i);
+    }
+    return duration<double, std::nano>(steady_clock::now() - start).count();
+  };
+
+  // Grow the batch until one sample takes its share of the time budget.
+  double sample_target_ns = min_time_ms_ * 1e6 / static_cast<double>(samples_);
+  size_t batch = 1;
+  while (time_batch(batch) < sample_target_ns && batch < (size_t(1) << 30)) {
+    batch *= 2;
+  }
+
+  Result result;
+  result.name = name;
+  result.iterations = 0;
+  uint64_t allocs = 0;
+  uint64_t bytes = 0;
+  for (size_t s = 0; s < samples_; s++) {
+    if (prepare) {
+      prepare(batch);
+    }
+    uint64_t allocs_before = AllocationCount();
+    uint64_t bytes_before = AllocationBytes();
+    auto start = steady_clock::now();
+    for (size_t i = 0; i < batch; i++) {
+      op(i);
+    }
+    double elapsed =
+        duration<double, std::nano>(steady_clock::now() - start).count();
+    allocs += AllocationCount() - allocs_before;
+    bytes += AllocationBytes() - bytes_before;
+    result.samples_ns.push_back(elapsed / static_cast<double>(batch));
+    result.iterations += batch;
+  }
+  if (prepare) {
+    // Release whatever the last prepare step set up.
+    prepare(0);
+  }
+
+  std::vector<double> sorted = result.samples_ns;
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0;
+  for (double sample : sorted) {
+    total += sample;
+  }
+  result.mean_ns = total / static_cast<double>(sorted.size());
+  result.min_ns = sorted.front();
+  result.max_ns = sorted.back();
+  result.p50_ns = Percentile(sorted, 50);
+  result.p90_ns = Percentile(sorted, 90);
+  result.p99_ns = Percentile(sorted, 99);
+  result.allocs_per_op =
+      static_cast<double>(allocs) / static_cast<double>(result.iterations);
+  result.bytes_per_op =
+      static_cast<double>(bytes) / static_cast<double>(result.iterations);
+  std::cerr << name << ": " << result.mean_ns << " ns/op, "
+            << result.allocs_per_op << " allocs/op\n";
+  results_.push_back(result);
+}
+
+auto Runner::Results() const -> const std::vector<Result>& {
+  return results_;
+}
+
+auto Runner::ToJson() const -> nlohmann::json {
+  nlohmann::json benchmarks = nlohmann::json::array();
+  for (const Result& r : results_) {
+    benchmarks.push_back({{"name", r.name},
+                          {"iterations", r.iterations},
+                          {"ns_per_op", r.mean_ns},
+                          {"min_ns", r.min_ns},
+                          {"max_ns", r.max_ns},
+                          {"p50_ns", r.p50_ns},
+                          {"p90_ns", r.p90_ns},
+                          {"p99_ns", r.p99_ns},
+                          {"allocs_per_op", r.allocs_per_op},
+                          {"bytes_per_op", r.bytes_per_op},
+                          {"samples_ns", r.samples_ns}});
+  }
+  return {{"context",
+           {{"samples", samples_}, {"min_time_ms", min_time_ms_}}},
+          {"benchmarks", benchmarks}};
+}
+
+}  // namespace bench
@@ -0,0 +1,74 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_BENCH_HARNESS_H_
+#define FINALPROJECT_BENCH_HARNESS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <json.hpp>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Keeps the compiler from optimizing away a value computed by a benchmark.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  const volatile char sink = *reinterpret_cast<const volatile char*>(&value);
+  (void)sink;
+#endif
+}
+
+// Number of calls to the global operator new and bytes requested since the
+// process started.
+auto AllocationCount() -> uint64_t;
+auto AllocationBytes() -> uint64_t;
+
+// Summary of one benchmark. All times are in nanoseconds per operation.
+struct Result {
+  std::string name;
+  // Total number of timed operations across all samples.
+  uint64_t iterations;
+  double mean_ns;
+  double min_ns;
+  double max_ns;
+  double p50_ns;
+  double p90_ns;
+  double p99_ns;
+  double allocs_per_op;
+  double bytes_per_op;
+  // The per-sample ns/op measurements the summary is computed from.
+  std::vector<double> samples_ns;
+};
+
+// Runs benchmarks as a number of timed batches (samples) and summarizes
+// them. A benchmark is a prepare function run untimed before each batch with
+// the batch size, and an operation run once per iteration with the index of
+// the iteration in the batch.
+class Runner {
+ public:
+  // Creates a runner taking the given number of samples per benchmark, each
+  // sample lasting roughly min_time_ms / samples milliseconds.
+  Runner(size_t samples, double min_time_ms, std::string filter);
+  // Runs the benchmark if its name matches the filter.
+  void Run(const std::string& name, const std::function<void(size_t)>& op,
+           const std::function<void(size_t)>& prepare = nullptr);
+  // The results of all benchmarks run so far.
+  auto Results() const -> const std::vector<Result>&;
+  // Serializes all results, ready to be written out as JSON.
+  auto ToJson() const -> nlohmann::json;
+
+ private:
+  size_t samples_;
+  double min_time_ms_;
+  std::string filter_;
+  std::vector<Result> results_;
+};
+
+}  // namespace bench
+
+#endif  // FINALPROJECT_BENCH_HARNESS_H_
@@ -0,0 +1,92 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/engine.h>
+#include <chess/game.h>
+#include <chess/mate.h>
+#include <chess/tt.h>
+#include <gflags/gflags.h>
+
+#include <iomanip>
+#include <iostream>
+
+DEFINE_uint32(hash_mb, 64, "mate solver and transposition table size in "
+              "megabytes.");
+DEFINE_uint64(alpha_beta_nodes, 2000000, "the nodes the alpha-beta search "
+              "may spend on each problem, 0 for no limit.");
+
+namespace {
+
+// A problem and the fewest moves the side to move mates in, as proven by
+// the solver: mate in moves_ and none in one move fewer.
+struct Problem {
+  const char* name;
+  size_t moves_;
+  const char* fen;
+};
+
+const Problem kProblems[] = {
+    {"rook-bishop", 3, "r5rk/5p1p/5R2/4B3/8/8/7P/7K w - - 0 1"},
+    {"krk-corner", 3, "7k/8/8/5K2/8/8/8/6R1 w - - 0 1"},
+    {"kqk-4", 4, "8/8/8/8/8/2k5/8/2K4Q w - - 0 1"},
+    {"kqk-5", 5, "8/8/8/8/1k6/8/8/2K4Q w - - 0 1"},
+    {"smothered", 6,
+     "r1k4r/ppp1bq1p/2n1N3/6B1/3p2Q1/8/PPP2PPP/R5K1 w - - 0 1"},
+    {"kqk-6", 6, "8/8/8/8/8/1k6/8/4K2Q w - - 0 1"},
+    {"krk-7", 7, "8/6k1/8/4K3/8/8/8/R7 w - - 0 1"},
+    {"kqk-7", 7, "4k3/8/8/8/8/8/8/4K2Q w - - 0 1"},
+    {"kqk-8", 8, "8/8/8/2k5/8/8/1Q6/4K3 w - - 0 1"},
+    {"krk-9", 9, "6k1/8/8/8/8/8/8/5RK1 w - - 0 1"},
+    {"kqk-9", 9, "8/8/8/3k4/8/8/8/KQ6 w - - 0 1"},
+    {"kqk-10", 10, "8/8/8/5k2/8/8/1Q6/K7 w - - 0 1"},
+};
+
+}  // namespace
+
+// Solves each problem with the proof-number solver, checks there is no
+// shorter mate, and compares with an alpha-beta search to the same depth.
+// The alpha-beta search runs without its pruning, which misses mates.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Measure the mate solver against alpha-beta. Pass "
+                          "--helpshort for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::cout << std::setw(12) << "problem" << std::setw(6) << "mate"
+            << std::setw(12) << "pn nodes" << std::setw(10) << "pn ms"
+            << std::setw(12) << "ab nodes" << std::setw(10) << "ab ms"
+            << std::setw(8) << "ab" << "\n";
+  engine::Options options;
+  options.null_move_ = false;
+  options.lmr_ = false;
+  options.futility_ = false;
+  options.reverse_futility_ = false;
+  int failures = 0;
+  for (const Problem& problem : kProblems) {
+    const game::Game game(problem.fen, 0);
+    mate::Solver solver(FLAGS_hash_mb);
+    const mate::Result shorter = solver.Solve(game, problem.moves_ - 1);
+    const mate::Result result = solver.Solve(game, problem.moves_);
+    if (!result.mate_ || shorter.mate_) {
+      failures++;
+    }
+
+    tt::Table table(FLAGS_hash_mb);
+    engine::Searcher searcher(game, &table, options);
+    engine::Limits limits;
+    limits.depth_ = 2 * problem.moves_ - 1;
+    limits.nodes_ = FLAGS_alpha_beta_nodes;
+    const engine::Result ab = searcher.Search(limits);
+    const bool ab_mate =
+        ab.score_ >= engine::kMateScore - static_cast<int>(limits.depth_);
+
+    std::cout << std::setw(12) << problem.name << std::setw(6)
+              << (result.mate_ && !shorter.mate_ ? std::to_string(
+                                                        problem.moves_)
+                                                  : "FAIL")
+              << std::setw(12) << result.nodes_ << std::setw(10)
+              << std::fixed << std::setprecision(1)
+              << result.seconds_ * 1000 << std::setw(12) << ab.nodes_
+              << std::setw(10) << ab.seconds_ * 1000 << std::setw(8)
+              << (ab_mate ? "mate" : "-") << std::endl;
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/game.h>
+#include <chess/mcts.h>
+#include <gflags/gflags.h>
+
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "positions.h"
+
+DEFINE_uint64(playouts, 20000, "playouts per search.");
+DEFINE_uint32(max_threads, 8, "the largest thread count; counts double "
+              "from 1 up to it.");
+DEFINE_uint32(memory_mb, 64, "the memory budget of the tree in megabytes.");
+DEFINE_uint32(reuse_moves, 4, "moves played with tree reuse from the start "
+              "position.");
+
+// Measures MCTS playouts per second as threads are added, the memory each
+// node takes, and how much of the tree is kept from one move to the next.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Measure Monte Carlo tree search. Pass "
+                          "--helpshort for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  mcts::Limits limits;
+  limits.playouts_ = FLAGS_playouts;
+  std::cout << FLAGS_playouts << " playouts per position, "
+            << sizeof(mcts::Node) << " bytes per node, "
+            << std::thread::hardware_concurrency() << " hardware threads\n"
+            << std::setw(8) << "threads" << std::setw(12) << "seconds"
+            << std::setw(14) << "playouts/s" << std::setw(12) << "nodes"
+            << std::setw(12) << "MB" << "\n";
+  for (size_t threads = 1; threads <= FLAGS_max_threads; threads *= 2) {
+    mcts::Options options;
+    options.threads_ = threads;
+    options.memory_mb_ = FLAGS_memory_mb;
+    double seconds = 0;
+    uint64_t playouts = 0;
+    size_t nodes = 0;
+    size_t bytes = 0;
+    for (const bench::Position& position : bench::kPositions) {
+      mcts::Searcher searcher(game::Game(position.fen, 0), options);
+      const mcts::Result result = searcher.Search(limits);
+      seconds += result.seconds_;
+      playouts += result.playouts_;
+      nodes += result.nodes_;
+      bytes += result.memory_bytes_;
+    }
+    std::cout << std::setw(8) << threads << std::setw(12) << std::fixed
+              << std::setprecision(3) << seconds << std::setw(14)
+              << static_cast<uint64_t>(playouts / seconds) << std::setw(12)
+              << nodes << std::setw(12) << std::setprecision(1)
+              << bytes / 1048576.0 << std::endl;
+  }
+
+  // Tree reuse: each move's search starts from the subtree of the move
+  // played, so part of its playouts are already done.
+  std::cout << "\n" << std::setw(8) << "move" << std::setw(10) << "played"
+            << std::setw(14) << "kept visits" << std::setw(12)
+            << "kept nodes" << "\n";
+  mcts::Options options;
+  options.memory_mb_ = FLAGS_memory_mb;
+  mcts::Searcher searcher(game::Game(0), options);
+  for (uint32_t move = 1; move <= FLAGS_reuse_moves; move++) {
+    const mcts::Result result = searcher.Search(limits);
+    if (result.pv_.empty()) {
+      break;
+    }
+    searcher.Advance(result.pv_[0]);
+    std::cout << std::setw(8) << move << std::setw(10) << result.pv_[0]
+              << std::setw(14) << searcher.RootVisits() << std::setw(12)
+              << searcher.Nodes() << std::endl;
+  }
+  return 0;
+}
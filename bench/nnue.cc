@@ -0,0 +1,108 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/game.h>
+#include <chess/nnue.h>
+#include <gflags/gflags.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "positions.h"
+
+DEFINE_string(network, "", "the network file to map. Empty for a random "
+              "network written to --random_path.");
+DEFINE_string(random_path, "nnue-bench.net", "where to write the random "
+              "network.");
+DEFINE_uint32(rounds, 200, "times every move of every position is played.");
+
+namespace {
+
+// The evaluations of one way to keep the accumulator.
+struct Run {
+  uint64_t evaluations_ = 0;
+  double seconds_ = 0;
+  // The sum of the evaluations, equal for both ways.
+  int64_t checksum_ = 0;
+};
+
+// Plays every legal move of every position, evaluates it and takes it
+// back, updating the accumulator from the position's or refreshing it.
+auto Measure(const nnue::Network& network, bool incremental) -> Run {
+  Run run;
+  for (const bench::Position& position : bench::kPositions) {
+    game::Game game(position.fen, 0);
+    const std::vector<game::Move> moves = game.LegalMoves(game.turn_);
+    nnue::Accumulator root;
+    network.Refresh(game, &root);
+    nnue::Accumulator child;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < FLAGS_rounds; round++) {
+      for (const game::Move& m : moves) {
+        game.PlayTurn(m);
+        if (incremental) {
+          network.Update(game, root, &child);
+        } else {
+          network.Refresh(game, &child);
+        }
+        run.checksum_ += network.Evaluate(child, game.turn_->color_);
+        game.UndoTurn();
+      }
+    }
+    run.seconds_ += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    run.evaluations_ += moves.size() * FLAGS_rounds;
+  }
+  return run;
+}
+
+void Print(const char* name, const Run& run) {
+  std::cout << std::setw(12) << name << std::setw(14) << run.evaluations_
+            << std::setw(10) << std::fixed << std::setprecision(3)
+            << run.seconds_ << std::setw(14)
+            << static_cast<uint64_t>(run.evaluations_ / run.seconds_)
+            << std::endl;
+}
+
+}  // namespace
+
+// Measures network evaluations per second with the accumulator updated
+// incrementally against refreshed from scratch, over every move of the
+// benchmark positions. Both include playing and taking back the move.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Measure NNUE evaluation speed. Pass --helpshort "
+                          "for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::string path = FLAGS_network;
+  if (path.empty()) {
+    path = FLAGS_random_path;
+    nnue::Network::WriteRandom(path, 1);
+  }
+  const std::unique_ptr<nnue::Network> network = nnue::Network::Load(path);
+  if (FLAGS_network.empty()) {
+    std::remove(path.c_str());
+  }
+
+  std::cout << "kernels " << nnue::Simd() << "\n"
+            << std::setw(12) << "accumulator" << std::setw(14) << "evals"
+            << std::setw(10) << "seconds" << std::setw(14) << "evals/s"
+            << std::endl;
+  const Run refresh = Measure(*network, false);
+  Print("refresh", refresh);
+  const Run incremental = Measure(*network, true);
+  Print("incremental", incremental);
+  std::cout << "speedup " << std::setprecision(2)
+            << refresh.seconds_ / incremental.seconds_ << ", checksum "
+            << incremental.checksum_ << std::endl;
+  if (incremental.checksum_ != refresh.checksum_) {
+    std::cerr << "refreshed evaluations sum to " << refresh.checksum_
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
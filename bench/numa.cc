@@ -0,0 +1,148 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/engine.h>
+#include <chess/game.h>
+#include <chess/numa.h>
+#include <chess/pool.h>
+#include <chess/tt.h>
+#include <gflags/gflags.h>
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "positions.h"
+
+DEFINE_uint32(depth, 6, "the depth every search is timed to.");
+DEFINE_uint32(max_threads, 0, "the largest thread count, 0 for every CPU "
+              "of the nodes searched on; counts double from 1 up to it.");
+DEFINE_uint32(hash_mb, 256, "transposition table size in megabytes.");
+DEFINE_uint32(runs, 3, "searches per position and setting; the fastest is "
+              "kept.");
+
+namespace {
+
+// Where the table's pages are put before searching.
+enum class Placement { kLocal, kInterleaved, kFirstTouch };
+
+auto Name(Placement placement) -> std::string {
+  switch (placement) {
+    case Placement::kLocal:
+      return "local";
+    case Placement::kInterleaved:
+      return "interleaved";
+    case Placement::kFirstTouch:
+      return "first-touch";
+  }
+  return "";
+}
+
+// Time to depth over the corpus with pinned threads, in a table placed
+// afresh. Returns false if the placement isn't possible here.
+auto TimeToDepth(const numa::Topology& topology, size_t threads,
+                 Placement placement, double* seconds, uint64_t* nodes)
+    -> bool {
+  tt::Table table(FLAGS_hash_mb);
+  switch (placement) {
+    case Placement::kLocal:
+      // Every page faulted in by this thread, so on its node.
+      table.Clear();
+      break;
+    case Placement::kInterleaved:
+      if (!table.Interleave(topology)) {
+        return false;
+      }
+      table.Clear();
+      break;
+    case Placement::kFirstTouch: {
+      // Each pinned worker faults in a share of the pages on its own node.
+      pool::ThreadPool placers(threads, topology);
+      table.Clear(&placers);
+      break;
+    }
+  }
+  engine::Options options;
+  options.topology_ = &topology;
+  engine::Limits limits;
+  limits.depth_ = FLAGS_depth;
+  *seconds = 0;
+  *nodes = 0;
+  for (const bench::Position& position : bench::kPositions) {
+    const game::Game game(position.fen, 0);
+    engine::Result best;
+    for (size_t run = 0; run < FLAGS_runs; run++) {
+      // Clearing again rewrites the pages where they already are.
+      table.Clear();
+      engine::ParallelSearcher searcher(game, threads, &table, options);
+      const engine::Result result = searcher.Search(limits);
+      if (run == 0 || result.seconds_ < best.seconds_) {
+        best = result;
+      }
+    }
+    *seconds += best.seconds_;
+    *nodes += best.nodes_;
+  }
+  return true;
+}
+
+}  // namespace
+
+// Measures how parallel search scales on one NUMA node against all of them,
+// with the transposition table placed on the searching thread's node,
+// interleaved over the nodes, or faulted in by the pinned workers.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Measure parallel search over NUMA nodes. Pass "
+                          "--helpshort for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  const numa::Topology machine = numa::Topology::Detect();
+  std::cout << machine.Nodes().size() << " NUMA nodes, " << machine.Cpus()
+            << " CPUs\n";
+  for (const numa::Node& node : machine.Nodes()) {
+    std::cout << "  node " << node.id_ << ":";
+    for (size_t cpu : node.cpus_) {
+      std::cout << " " << cpu;
+    }
+    std::cout << "\n";
+  }
+  std::cout << "depth " << FLAGS_depth << ", " << FLAGS_hash_mb
+            << " MB table\n"
+            << std::setw(7) << "nodes" << std::setw(9) << "threads"
+            << std::setw(13) << "table" << std::setw(10) << "seconds"
+            << std::setw(10) << "speedup" << std::setw(12) << "nps" << "\n";
+
+  std::vector<size_t> node_counts = {1};
+  if (machine.Nodes().size() > 1) {
+    node_counts.push_back(machine.Nodes().size());
+  }
+  // Speedups are against the first row's time.
+  bool have_baseline = false;
+  double baseline = 0;
+  for (size_t n : node_counts) {
+    const numa::Topology topology = machine.Restrict(n);
+    const size_t max_threads =
+        FLAGS_max_threads == 0 ? topology.Cpus() : FLAGS_max_threads;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+      for (Placement placement : {Placement::kLocal, Placement::kInterleaved,
+                                  Placement::kFirstTouch}) {
+        double seconds = 0;
+        uint64_t nodes = 0;
+        if (!TimeToDepth(topology, threads, placement, &seconds, &nodes)) {
+          continue;
+        }
+        if (!have_baseline) {
+          baseline = seconds;
+          have_baseline = true;
+        }
+        std::cout << std::setw(7) << n << std::setw(9) << threads
+                  << std::setw(13) << Name(placement) << std::setw(10)
+                  << std::fixed << std::setprecision(3) << seconds
+                  << std::setw(10) << std::setprecision(2)
+                  << baseline / seconds << std::setw(12)
+                  << static_cast<uint64_t>(nodes / seconds) << std::endl;
+      }
+    }
+  }
+  return 0;
+}
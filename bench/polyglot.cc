@@ -0,0 +1,118 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/polyglot.h>
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+DEFINE_uint64(games, 20000, "random games whose openings fill the book.");
+DEFINE_uint32(plies, 12, "plies of each game put in the book.");
+DEFINE_uint64(probes, 1000000, "probes timed.");
+DEFINE_string(book, "bench.bin", "the book file written and mapped back.");
+
+namespace {
+
+auto Seconds(std::chrono::steady_clock::time_point start) -> double {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+}  // namespace
+
+// Writes a book of random openings, maps it and times probing it for
+// positions in and out of the book.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Time Polyglot book probing. Pass --helpshort for "
+                          "options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::mt19937_64 random(1);
+  std::vector<polyglot::Entry> entries;
+  std::vector<uint64_t> in_book;
+  const auto build_start = std::chrono::steady_clock::now();
+  for (uint64_t g = 0; g < FLAGS_games; g++) {
+    game::Game game(0);
+    for (uint32_t ply = 0; ply < FLAGS_plies; ply++) {
+      const std::vector<game::Move> moves = game.LegalMoves(game.turn_);
+      if (moves.empty()) {
+        break;
+      }
+      const game::Move& m = moves[random() % moves.size()];
+      const uint64_t key = polyglot::Key(game);
+      entries.push_back({key, polyglot::Encode(m), 1, 0});
+      in_book.push_back(key);
+      game.PlayTurn(m);
+    }
+  }
+  // One entry a move, as in a real book, weighted by how often it was
+  // played.
+  std::sort(entries.begin(), entries.end(),
+            [](const polyglot::Entry& a, const polyglot::Entry& b) {
+              return a.key_ != b.key_ ? a.key_ < b.key_ : a.move_ < b.move_;
+            });
+  size_t kept = 0;
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (kept > 0 && entries[kept - 1].key_ == entries[i].key_ &&
+        entries[kept - 1].move_ == entries[i].move_) {
+      entries[kept - 1].weight_ = static_cast<uint16_t>(
+          std::min(0xFFFF, entries[kept - 1].weight_ + 1));
+    } else {
+      entries[kept] = entries[i];
+      entries[kept++].weight_ = 1;
+    }
+  }
+  entries.resize(kept);
+  polyglot::Book::Write(FLAGS_book, entries);
+  std::cout << entries.size() << " entries written in " << std::fixed
+            << std::setprecision(2) << Seconds(build_start) << " s\n";
+
+  const auto open_start = std::chrono::steady_clock::now();
+  std::unique_ptr<polyglot::Book> book = polyglot::Book::Open(FLAGS_book);
+  const double open = Seconds(open_start);
+  std::cout << "mapped " << book->Size() * 16 / 1024 << " KiB in "
+            << std::setprecision(1) << open * 1e6 << " us\n";
+
+  std::vector<uint64_t> hits(FLAGS_probes);
+  std::vector<uint64_t> misses(FLAGS_probes);
+  for (uint64_t i = 0; i < FLAGS_probes; i++) {
+    hits[i] = in_book[random() % in_book.size()];
+    misses[i] = random();
+  }
+  size_t found = 0;
+  const auto hit_start = std::chrono::steady_clock::now();
+  for (uint64_t key : hits) {
+    found += book->Probe(key).size();
+  }
+  const double hit = Seconds(hit_start);
+  const auto miss_start = std::chrono::steady_clock::now();
+  for (uint64_t key : misses) {
+    found += book->Probe(key).size();
+  }
+  const double miss = Seconds(miss_start);
+
+  // Hashing a position, which a probe from a game adds.
+  game::Game game(0);
+  uint64_t sum = 0;
+  const auto key_start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < FLAGS_probes; i++) {
+    sum += polyglot::Key(game);
+  }
+  const double key = Seconds(key_start);
+
+  const double n = static_cast<double>(FLAGS_probes);
+  std::cout << std::setw(16) << "ns/probe hit" << std::setw(16)
+            << "ns/probe miss" << std::setw(16) << "ns/key" << "\n"
+            << std::setw(16) << hit * 1e9 / n << std::setw(16)
+            << miss * 1e9 / n << std::setw(16) << key * 1e9 / n << "\n";
+  book.reset();
+  std::remove(FLAGS_book.c_str());
+  // Keeps the probes from being optimized away.
+  return found == 0 && sum == 1 ? 1 : 0;
+}
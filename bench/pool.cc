@@ -0,0 +1,62 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/game.h>
+#include <chess/perft.h>
+#include <chess/pool.h>
+#include <gflags/gflags.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+DEFINE_uint32(depth, 5, "the perft depth from the start position.");
+DEFINE_uint32(max_threads, 0, "the largest pool size; sizes double from 1 up "
+              "to it. 0 for the hardware thread count.");
+DEFINE_bool(pin, false, "pin each worker to a CPU.");
+
+namespace {
+
+auto Seconds(std::chrono::steady_clock::time_point start) -> double {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+}  // namespace
+
+// Measures the thread pool's scaling on a perft split from the start
+// position against the serial perft.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Measure the thread pool's perft scaling. Pass "
+                          "--helpshort for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  size_t max_threads = FLAGS_max_threads;
+  if (max_threads == 0) {
+    max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  const game::Game game(0);
+  auto start = std::chrono::steady_clock::now();
+  const uint64_t expected = perft::Perft(game, FLAGS_depth);
+  const double serial = Seconds(start);
+  std::cout << "perft " << FLAGS_depth << " = " << expected << ", serial "
+            << std::fixed << std::setprecision(3) << serial << " s\n"
+            << std::setw(8) << "threads" << std::setw(12) << "seconds"
+            << std::setw(10) << "speedup" << std::setw(12) << "efficiency"
+            << "\n";
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    pool::ThreadPool workers(threads, FLAGS_pin);
+    start = std::chrono::steady_clock::now();
+    const uint64_t nodes = perft::ParallelPerft(game, FLAGS_depth, &workers);
+    const double seconds = Seconds(start);
+    if (nodes != expected) {
+      std::cerr << "parallel perft counted " << nodes << std::endl;
+      return 1;
+    }
+    std::cout << std::setw(8) << threads << std::setw(12)
+              << std::setprecision(3) << seconds << std::setw(10)
+              << std::setprecision(2) << serial / seconds << std::setw(12)
+              << serial / seconds / threads << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_BENCH_POSITIONS_H_
+#define FINALPROJECT_BENCH_POSITIONS_H_
+
+#include <cstddef>
+
+namespace bench {
+
+// A named benchmark position and the phase of the game it represents.
+struct Position {
+  const char* name;
+  const char* phase;
+  const char* fen;
+};
+
+// Fixed corpus of positions every game benchmark is run against. Positions
+// only change together with the stored baselines.
+const Position kPositions[] = {
+    {"start", "opening",
+     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"},
+    {"italian", "opening",
+     "r1bqk1nr/pppp1ppp/2n5/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4"},
+    {"kiwipete", "middlegame",
+     "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+    {"qgd", "middlegame",
+     "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N2N2/PP2BPPP/R2QKB1R w KQ - 0 9"},
+    {"rook-ending", "endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+    {"krk", "endgame", "8/8/4k3/8/8/3K4/3R4/8 w - - 0 1"},
+};
+
+const size_t kNumPositions = sizeof(kPositions) / sizeof(kPositions[0]);
+
+// A tactical test position and its best move in the "xyxy" format.
+struct Tactic {
+  const char* name;
+  const char* fen;
+  const char* best_move;
+};
+
+// The first positions of Win at Chess (Reinfeld, 1958), each with a single
+// winning move.
+const Tactic kTactics[] = {
+    {"wac001", "2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1",
+     "6265"},
+    {"wac002", "8/7p/5k2/5p2/p1p2P2/Pr1pPK2/1P1R3P/8 b - - 0 1", "1211"},
+    {"wac003", "5rk1/1ppb3p/p1pb4/6q1/3P1p1r/2P1R2P/PP1BQ1P1/5RKN w - - 0 1",
+     "4262"},
+    {"wac004", "r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - 0 1",
+     "7576"},
+    {"wac005", "5k2/6pp/p1qN4/1p1p4/3P4/2PKP2Q/PP3r2/3R4 b - - 0 1", "2523"},
+    {"wac006", "7k/p7/1R5K/6r1/6p1/6P1/8/8 w - - 0 1", "1516"},
+    {"wac007", "rnbqkb1r/pppp1ppp/8/4P3/6n1/7P/PPPNPPP1/R1BQKBNR b KQkq - 0 1",
+     "6342"},
+    {"wac008", "r4q1k/p2bR1rp/2p2Q1N/5p2/5p2/2P5/PP3PPP/R5K1 w - - 0 1",
+     "4656"},
+    {"wac009", "3q1rk1/p4pp1/2pb3p/3p4/6Pr/1PNQ4/P1PB1PP1/4RRK1 b - - 0 1",
+     "3571"},
+    {"wac010", "2br2k1/2q3rn/p2NppQ1/2p1P3/Pp5R/4P3/1P3PPP/3R2K1 w - - 0 1",
+     "7376"},
+};
+
+}  // namespace bench
+
+#endif  // FINALPROJECT_BENCH_POSITIONS_H_
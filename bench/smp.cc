@@ -0,0 +1,72 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/engine.h>
+#include <chess/game.h>
+#include <chess/tt.h>
+#include <gflags/gflags.h>
+
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "positions.h"
+
+DEFINE_uint32(depth, 6, "the depth every search is timed to.");
+DEFINE_uint32(max_threads, 32, "the largest thread count; counts double "
+              "from 1 up to it.");
+DEFINE_uint32(hash_mb, 64, "transposition table size in megabytes.");
+DEFINE_uint32(runs, 3, "searches per position and thread count; the fastest "
+              "is kept.");
+
+// Measures Lazy SMP time-to-depth: how much sooner the searcher completes a
+// fixed depth over the benchmark corpus as threads are added.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Measure the parallel search speedup. Pass "
+                          "--helpshort for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::vector<size_t> counts;
+  for (size_t threads = 1; threads <= FLAGS_max_threads; threads *= 2) {
+    counts.push_back(threads);
+  }
+  std::cout << "depth " << FLAGS_depth << ", "
+            << std::thread::hardware_concurrency() << " hardware threads\n"
+            << std::setw(8) << "threads" << std::setw(12) << "seconds"
+            << std::setw(10) << "speedup" << std::setw(14) << "nodes"
+            << std::setw(12) << "nps" << "\n";
+
+  tt::Table table(FLAGS_hash_mb);
+  engine::Limits limits;
+  limits.depth_ = FLAGS_depth;
+  double baseline = 0;
+  for (size_t threads : counts) {
+    // Time to depth is the sum over positions of the fastest run, each run
+    // starting from an empty table.
+    double seconds = 0;
+    uint64_t nodes = 0;
+    for (const bench::Position& position : bench::kPositions) {
+      const game::Game game(position.fen, 0);
+      engine::Result best;
+      for (size_t run = 0; run < FLAGS_runs; run++) {
+        table.Clear();
+        engine::ParallelSearcher searcher(game, threads, &table);
+        const engine::Result result = searcher.Search(limits);
+        if (run == 0 || result.seconds_ < best.seconds_) {
+          best = result;
+        }
+      }
+      seconds += best.seconds_;
+      nodes += best.nodes_;
+    }
+    if (threads == 1) {
+      baseline = seconds;
+    }
+    std::cout << std::setw(8) << threads << std::setw(12) << std::fixed
+              << std::setprecision(3) << seconds << std::setw(10)
+              << std::setprecision(2) << baseline / seconds << std::setw(14)
+              << nodes << std::setw(12)
+              << static_cast<uint64_t>(nodes / seconds) << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,257 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "suite.h"
+
+#include <chess/board.h>
+#include <chess/engine.h>
+#include <chess/game.h>
+#include <chess/pawns.h>
+#include <chess/perft.h>
+#include <chess/piece.h>
+#include <chess/tt.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "positions.h"
+
+namespace bench {
+
+using board::Square;
+using game::Game;
+using game::Player;
+using std::unique_ptr;
+using std::vector;
+
+// Forwards to the private Game helpers the benchmarks measure directly.
+struct GameAccess {
+  static auto CheckPath(const Game& g, const Square* from, const Square* to)
+      -> bool {
+    return g.CheckPath(from, to);
+  }
+  static auto GetPiecesChecking(const Game& g, const Square* at, Player* p)
+      -> vector<const Square*> {
+    return g.GetPiecesChecking(at, p);
+  }
+  static auto CanCastle(const Game& g, Player* p, const Square* s) -> bool {
+    return g.CanCastle(p, s);
+  }
+};
+
+namespace {
+
+// A (from, to) pair of squares on a board.
+struct SquarePair {
+  const Square* from;
+  const Square* to;
+};
+
+// A pair of coordinates used by the piece level benchmarks.
+struct Coords {
+  size_t x_old;
+  size_t y_old;
+  size_t x_new;
+  size_t y_new;
+};
+
+auto MakePiece(piece::PieceType type) -> unique_ptr<piece::Piece> {
+  const piece::Color c = piece::Color::kWhite;
+  switch (type) {
+    case piece::PieceType::kPawn:
+      return unique_ptr<piece::Piece>(new piece::Pawn(c));
+    case piece::PieceType::kKnight:
+      return unique_ptr<piece::Piece>(new piece::Knight(c));
+    case piece::PieceType::kBishop:
+      return unique_ptr<piece::Piece>(new piece::Bishop(c));
+    case piece::PieceType::kRook:
+      return unique_ptr<piece::Piece>(new piece::Rook(c));
+    case piece::PieceType::kQueen:
+      return unique_ptr<piece::Piece>(new piece::Queen(c));
+    default:
+      return unique_ptr<piece::Piece>(new piece::King(c));
+  }
+}
+
+void RunPieceBenchmarks(Runner* runner) {
+  const vector<std::pair<piece::PieceType, std::string>> types = {
+      {piece::PieceType::kPawn, "Pawn"},     {piece::PieceType::kKnight, "Knight"},
+      {piece::PieceType::kBishop, "Bishop"}, {piece::PieceType::kRook, "Rook"},
+      {piece::PieceType::kQueen, "Queen"},   {piece::PieceType::kKing, "King"}};
+  for (const auto& type : types) {
+    unique_ptr<piece::Piece> p = MakePiece(type.first);
+    vector<Coords> all;
+    vector<Coords> valid;
+    for (size_t from = 0; from < board::kSize * board::kSize; from++) {
+      for (size_t to = 0; to < board::kSize * board::kSize; to++) {
+        if (from == to) {
+          continue;
+        }
+        Coords c = {from % board::kSize, from / board::kSize,
+                    to % board::kSize, to / board::kSize};
+        all.push_back(c);
+        if (p->CanMove(c.x_old, c.y_old, c.x_new, c.y_new)) {
+          valid.push_back(c);
+        }
+      }
+    }
+    runner->Run("piece/" + type.second + "/CanMove", [&](size_t i) {
+      const Coords& c = all[i % all.size()];
+      DoNotOptimize(p->CanMove(c.x_old, c.y_old, c.x_new, c.y_new));
+    });
+    runner->Run("piece/" + type.second + "/Path", [&](size_t i) {
+      const Coords& c = valid[i % valid.size()];
+      DoNotOptimize(p->Path(c.x_old, c.y_old, c.x_new, c.y_new));
+    });
+  }
+}
+
+void RunTableBenchmarks(Runner* runner) {
+  // 16 MB is well past the last level cache of most machines, so probes of
+  // random keys measure a memory access.
+  tt::Table table(16);
+  tt::Entry entry;
+  auto key = [](size_t i) { return (i + 1) * 0x9E3779B97F4A7C15ULL; };
+  runner->Run("tt/Store", [&](size_t i) { table.Store(key(i), entry); });
+  runner->Run("tt/Probe", [&](size_t i) {
+    tt::Entry found;
+    DoNotOptimize(table.Probe(key(i), &found));
+  });
+  runner->Run("tt/Hashfull", [&](size_t) { DoNotOptimize(table.Hashfull()); });
+}
+
+// Returns every legal move for the side to move in the "xyxy" string format
+// accepted by Game::GetMoveFromStr.
+auto LegalMoveStrings(Game* game) -> vector<std::string> {
+  vector<std::string> moves;
+  for (const game::Move& m : game->LegalMoves(game->turn_)) {
+    std::stringstream move;
+    move << m;
+    moves.push_back(move.str());
+  }
+  return moves;
+}
+
+void RunGameBenchmarks(Runner* runner, const Position& position) {
+  Game game(position.fen, 0);
+  const std::string prefix = std::string("game/") + position.name + "/";
+  Player* turn = game.turn_;
+
+  // Move validation inputs: every square pair starting at one of the side
+  // to move's pieces, and the subset the piece can geometrically make.
+  vector<SquarePair> pairs;
+  vector<SquarePair> geometric;
+  for (size_t from = 0; from < board::kSize * board::kSize; from++) {
+    const Square* f = game.board_->At(from % board::kSize, from / board::kSize);
+    if (f->IsEmpty() || f->piece_->color_ != turn->color_) {
+      continue;
+    }
+    for (size_t to = 0; to < board::kSize * board::kSize; to++) {
+      const Square* t = game.board_->At(to % board::kSize, to / board::kSize);
+      if (f == t) {
+        continue;
+      }
+      pairs.push_back({f, t});
+      if (f->piece_->CanMove(f->x_, f->y_, t->x_, t->y_)) {
+        geometric.push_back({f, t});
+      }
+    }
+  }
+  const vector<std::string> legal = LegalMoveStrings(&game);
+
+  runner->Run(prefix + "CanMove", [&](size_t i) {
+    const SquarePair& p = pairs[i % pairs.size()];
+    DoNotOptimize(game.CanMove(p.from, p.to, turn));
+  });
+  runner->Run(prefix + "CheckPath", [&](size_t i) {
+    const SquarePair& p = geometric[i % geometric.size()];
+    DoNotOptimize(GameAccess::CheckPath(game, p.from, p.to));
+  });
+  runner->Run(prefix + "GetPiecesChecking", [&](size_t i) {
+    Player* p = i % 2 == 0 ? game.white_ : game.black_;
+    DoNotOptimize(GameAccess::GetPiecesChecking(game, p->kingSquare_, p));
+  });
+  runner->Run(prefix + "LegalMoves",
+              [&](size_t) { DoNotOptimize(game.LegalMoves(turn)); });
+  runner->Run(prefix + "EvaluateBoard",
+              [&](size_t) { DoNotOptimize(game.EvaluateBoard()); });
+  const size_t back_row = turn == game.white_ ? 0 : board::kSize - 1;
+  runner->Run(prefix + "CanCastle", [&](size_t i) {
+    const Square* s = game.board_->At(i % 2 == 0 ? 6 : 2, back_row);
+    DoNotOptimize(GameAccess::CanCastle(game, turn, s));
+  });
+  runner->Run(prefix + "BoardCopy", [&](size_t) {
+    board::Board copy(*game.board_);
+    DoNotOptimize(copy);
+  });
+  runner->Run(prefix + "GameCopy", [&](size_t) {
+    Game copy(game);
+    DoNotOptimize(copy);
+  });
+  if (legal.empty()) {
+    return;
+  }
+  runner->Run(prefix + "GetMoveFromStr", [&](size_t i) {
+    DoNotOptimize(game.GetMoveFromStr(legal[i % legal.size()], turn));
+  });
+
+  // PlayTurn mutates the game, so every iteration plays on its own copy
+  // created in the untimed prepare step.
+  vector<unique_ptr<Game>> copies;
+  vector<game::Move> moves;
+  runner->Run(
+      prefix + "PlayTurn",
+      [&](size_t i) { DoNotOptimize(copies[i]->PlayTurn(moves[i])); },
+      [&](size_t batch) {
+        copies.clear();
+        moves.clear();
+        for (size_t i = 0; i < batch; i++) {
+          copies.emplace_back(new Game(game));
+          moves.push_back(copies.back()->GetMoveFromStr(
+              legal[i % legal.size()], copies.back()->turn_));
+        }
+      });
+}
+
+void RunPerftBenchmarks(Runner* runner, const Position& position) {
+  const Game game(position.fen, 0);
+  // Depth 2 keeps one operation in the low milliseconds for every position.
+  runner->Run(std::string("perft/") + position.name + "/2",
+              [&](size_t) { DoNotOptimize(perft::Perft(game, 2)); });
+}
+
+void RunSearchBenchmarks(Runner* runner, const Position& position) {
+  const Game game(position.fen, 0);
+  // The static evaluation reads the incrementally updated sums.
+  runner->Run(std::string("engine/") + position.name + "/Evaluate",
+              [&](size_t) { DoNotOptimize(engine::Evaluate(game)); });
+  // Pawn structure from scratch, against a table hit as in a search.
+  runner->Run(std::string("pawns/") + position.name + "/Compute",
+              [&](size_t) { DoNotOptimize(pawns::Compute(game).key_); });
+  pawns::Table table;
+  runner->Run(std::string("pawns/") + position.name + "/Probe", [&](size_t) {
+    DoNotOptimize(pawns::Evaluate(game, &table).mg_);
+  });
+  engine::Limits limits;
+  limits.depth_ = 3;
+  runner->Run(std::string("search/") + position.name + "/3", [&](size_t) {
+    engine::Searcher searcher(game);
+    DoNotOptimize(searcher.Search(limits).nodes_);
+  });
+}
+
+}  // namespace
+
+void RunSuite(Runner* runner) {
+  RunPieceBenchmarks(runner);
+  RunTableBenchmarks(runner);
+  for (size_t i = 0; i < kNumPositions; i++) {
+    RunGameBenchmarks(runner, kPositions[i]);
+    RunPerftBenchmarks(runner, kPositions[i]);
+    RunSearchBenchmarks(runner, kPositions[i]);
+  }
+}
+
+}  // namespace bench
+
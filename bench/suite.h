@@ -0,0 +1,16 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_BENCH_SUITE_H_
+#define FINALPROJECT_BENCH_SUITE_H_
+
+#include "harness.h"
+
+namespace bench {
+
+// Runs every library benchmark: piece move validation, the Game entry
+// points and perft over the position corpus.
+void RunSuite(Runner* runner);
+
+}  // namespace bench
+
+#endif  // FINALPROJECT_BENCH_SUITE_H_
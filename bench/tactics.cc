@@ -0,0 +1,119 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/engine.h>
+#include <chess/game.h>
+#include <chess/tt.h>
+#include <gflags/gflags.h>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "positions.h"
+
+DEFINE_uint32(depth, 4, "the depth each position is searched to.");
+DEFINE_uint32(hash_mb, 16, "transposition table size in megabytes.");
+DEFINE_string(stats_out, "", "if set, the search statistics of every "
+              "position are written to this file, one JSON object per "
+              "line.");
+
+namespace {
+
+// Searches every tactical position with the options and prints how many
+// were solved and the nodes spent per solved position. Writes the
+// statistics of each search to stats_out, if given.
+void Run(const char* name, const engine::Options& options,
+         std::ostream* stats_out) {
+  tt::Table table(FLAGS_hash_mb);
+  engine::Limits limits;
+  limits.depth_ = FLAGS_depth;
+  size_t solved = 0;
+  uint64_t nodes = 0;
+  uint64_t quiescence_nodes = 0;
+  double seconds = 0;
+  for (const bench::Tactic& tactic : bench::kTactics) {
+    table.Clear();
+    engine::Searcher searcher(game::Game(tactic.fen, 0), &table, options);
+    const engine::Result result = searcher.Search(limits);
+    if (!result.pv_.empty() && result.pv_[0] == tactic.best_move) {
+      solved++;
+    }
+    if (stats_out) {
+      *stats_out << "{\"search\":\"" << name << "\",\"position\":\""
+                 << tactic.name << "\",\"stats\":";
+      result.stats_.WriteJson(*stats_out);
+      *stats_out << "}\n";
+    }
+    nodes += result.nodes_;
+    quiescence_nodes += result.quiescence_nodes_;
+    seconds += result.seconds_;
+  }
+  std::cout << std::setw(14) << name << std::setw(8) << solved << "/"
+            << std::left << std::setw(5)
+            << sizeof(bench::kTactics) / sizeof(bench::kTactics[0])
+            << std::right << std::setw(12) << nodes << std::setw(12)
+            << quiescence_nodes << std::setw(16)
+            << (solved ? std::to_string(nodes / solved) : "-")
+            << std::setw(10) << std::fixed << std::setprecision(3) << seconds
+            << std::endl;
+}
+
+}  // namespace
+
+// Measures search techniques by the positions they solve, the nodes they
+// spend per solved position and their time to a fixed depth.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Measure tactical strength per node. Pass "
+                          "--helpshort for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::cout << "depth " << FLAGS_depth << "\n"
+            << std::setw(14) << "search" << std::setw(14) << "solved"
+            << std::setw(12) << "nodes" << std::setw(12) << "qnodes"
+            << std::setw(16) << "nodes/solved" << std::setw(10) << "seconds"
+            << "\n";
+  std::ofstream stats_file;
+  std::ostream* stats_out = nullptr;
+  if (!FLAGS_stats_out.empty()) {
+    stats_file.open(FLAGS_stats_out);
+    stats_out = &stats_file;
+  }
+  // Full width, then the default options, then each technique toggled
+  // alone from the defaults.
+  engine::Options plain;
+  plain.quiescence_ = false;
+  plain.null_move_ = false;
+  plain.lmr_ = false;
+  plain.futility_ = false;
+  plain.reverse_futility_ = false;
+  plain.razoring_ = false;
+  plain.aspiration_ = false;
+  Run("plain", plain, stats_out);
+  engine::Options quiescence = plain;
+  quiescence.quiescence_ = true;
+  Run("qs", quiescence, stats_out);
+  Run("default", engine::Options(), stats_out);
+  engine::Options options;
+  options.delta_margin_ = 0;
+  Run("-delta", options, stats_out);
+  options = engine::Options();
+  options.null_move_ = false;
+  Run("-null", options, stats_out);
+  options = engine::Options();
+  options.lmr_ = false;
+  Run("-lmr", options, stats_out);
+  options = engine::Options();
+  options.futility_ = false;
+  Run("-futility", options, stats_out);
+  options = engine::Options();
+  options.reverse_futility_ = false;
+  Run("-rfutility", options, stats_out);
+  options = engine::Options();
+  options.razoring_ = true;
+  Run("+razoring", options, stats_out);
+  options = engine::Options();
+  options.aspiration_ = false;
+  Run("-aspiration", options, stats_out);
+  return 0;
+}
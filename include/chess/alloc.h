@@ -0,0 +1,88 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_ALLOC_H
+#define FINALPROJECT_ALLOC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Opt-in allocation tracking. When the library is built with
+// CHESS_TRACK_ALLOCATIONS (cmake -DCHESS_TRACK_ALLOCATIONS=ON) the global
+// operator new and delete are replaced with counting versions, and every
+// allocation is attributed to the innermost CHESS_ALLOC_SCOPE active on the
+// allocating thread. The report is printed to stderr at exit, or on demand
+// with alloc::Dump. Without the flag the scopes compile to nothing.
+namespace alloc {
+
+// The maximum number of distinct regions, including the untracked region.
+const size_t kMaxRegions = 64;
+
+// Allocation counters of one region.
+struct RegionStats {
+  // The region name given to CHESS_ALLOC_SCOPE.
+  std::string name;
+  // The number of times the region was entered.
+  uint64_t entries;
+  // The number of calls to operator new while the region was innermost.
+  uint64_t allocations;
+  // The number of bytes requested by those calls.
+  uint64_t bytes;
+  // The number of calls to operator delete while the region was innermost.
+  uint64_t frees;
+};
+
+// Returns the id of the region with the given name, registering it on first
+// use. Names must outlive the program (string literals).
+auto RegisterRegion(const char* name) -> size_t;
+
+// RAII marker attributing the allocations made on this thread during its
+// lifetime to a region. Scopes nest; the innermost one wins.
+class Scope {
+ public:
+  explicit Scope(size_t region);
+  ~Scope();
+  Scope(const Scope&) = delete;
+  auto operator=(const Scope&) -> Scope& = delete;
+
+ private:
+  size_t previous_;
+};
+
+// True iff the library was built with the counting allocation functions.
+auto Enabled() -> bool;
+// Records one allocation of the given size or one deallocation against the
+// current thread's region. Called by the replaced operator new and delete.
+void RecordAllocation(size_t bytes);
+void RecordFree();
+// Returns the counters of every region seen so far. The first entry holds
+// allocations made outside of any scope.
+auto Snapshot() -> std::vector<RegionStats>;
+// Sums of the allocation counters over every region. Never allocate.
+auto TotalAllocations() -> uint64_t;
+auto TotalBytes() -> uint64_t;
+// Zeroes every counter.
+void Reset();
+// Prints a table of the counters of every region.
+void Dump(std::ostream& out);
+
+}  // namespace alloc
+
+#define CHESS_ALLOC_CONCAT_(a, b) a##b
+#define CHESS_ALLOC_CONCAT(a, b) CHESS_ALLOC_CONCAT_(a, b)
+
+#ifdef CHESS_TRACK_ALLOCATIONS
+// Attributes the allocations made until the end of the enclosing block to
+// the named region.
+#define CHESS_ALLOC_SCOPE(name)                                        \
+  static const size_t CHESS_ALLOC_CONCAT(alloc_region_, __LINE__) =    \
+      alloc::RegisterRegion(name);                                     \
+  alloc::Scope CHESS_ALLOC_CONCAT(alloc_scope_, __LINE__)(             \
+      CHESS_ALLOC_CONCAT(alloc_region_, __LINE__))
+#else
+#define CHESS_ALLOC_SCOPE(name)
+#endif
+
+#endif  // FINALPROJECT_ALLOC_H
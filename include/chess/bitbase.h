@@ -0,0 +1,154 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_BITBASE_H
+#define FINALPROJECT_BITBASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "piece.h"
+#include "pool.h"
+
+// Endgame bitbases: whether the player to move wins, draws or loses every
+// position of an endgame of up to four pieces, kings included. Retrograde
+// analysis finds them from the mates back; probing maps the file and reads
+// two bits.
+namespace bitbase {
+
+// The most pieces an endgame may have, kings included.
+const size_t kMaxPieces = 4;
+
+// The outcome with best play, for the player to move.
+enum class Wdl : uint8_t { kDraw, kWin, kLoss, kUnknown };
+
+// A piece of a position being probed. The square is x + 8 * y.
+struct PieceOn {
+  piece::PieceType type_;
+  piece::Color color_;
+  size_t square_;
+};
+
+// Returns the canonical name of the endgame with the given pieces: each
+// side's king followed by its other pieces from queen to pawn, the side
+// with more material first, e.g. "KRKP". Throws std::invalid_argument if
+// the name is not two kings and at most kMaxPieces pieces.
+auto CanonicalName(const std::string& name) -> std::string;
+
+// Counts of the positions of one side to move.
+struct Counts {
+  uint64_t wins_ = 0;
+  uint64_t draws_ = 0;
+  uint64_t losses_ = 0;
+};
+
+class Tables;
+
+// The bitbase of one endgame, with the side named first as White. Both
+// sides to move are held, two bits a position. Positions are indexed by
+// square, the white king's folded onto the a-d files, and onto ranks 1-4
+// too without pawns, by mirroring the board; pawns only stand on ranks
+// 2-7. Castling, en passant and underpromotion are left out: pawns promote
+// to queens.
+class Bitbase {
+ public:
+  // Maps a bitbase file. Throws std::runtime_error if it can't be read or
+  // isn't a bitbase.
+  static auto Load(const std::string& path) -> std::unique_ptr<Bitbase>;
+  ~Bitbase();
+  Bitbase(const Bitbase&) = delete;
+  auto operator=(const Bitbase&) -> Bitbase& = delete;
+  // Writes the bitbase to a file. Throws std::runtime_error if the file
+  // can't be written.
+  void Write(const std::string& path) const;
+  auto Name() const -> const std::string& { return name_; }
+  // The indexed positions of each side to move, illegal ones included.
+  auto Positions() const -> uint64_t { return positions_; }
+  auto Bytes() const -> size_t { return size_; }
+  // The legal positions by outcome, with White to move or not, as
+  // generated. Zero for a loaded bitbase.
+  auto Generated(bool white_to_move) const -> const Counts& {
+    return counts_[white_to_move ? 0 : 1];
+  }
+  // The outcome of the position of the pieces, which must be those of the
+  // endgame, with its white side as White. Kings come first, then the
+  // others in name order. Returns kUnknown for a pawn on the first or last
+  // rank. Illegal positions are draws.
+  auto Probe(const size_t* squares, bool white_to_move) const -> Wdl;
+
+ private:
+  friend class Tables;
+  friend class Generator;
+  Bitbase() = default;
+  std::string name_;
+  // The pieces in index order: the white king, the black king, the other
+  // white pieces, then the other black ones.
+  size_t pieces_ = 0;
+  piece::PieceType types_[kMaxPieces];
+  piece::Color colors_[kMaxPieces];
+  bool pawns_ = false;
+  uint64_t positions_ = 0;
+  Counts counts_[2];
+  // The file's contents, mapped or held in owned_. Two bit arrays of
+  // positions_ entries, White to move first.
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<uint8_t> owned_;
+  // Sets the pieces from the name.
+  void SetPieces(const std::string& name);
+  // The index of the squares, folded onto the canonical half or quarter of
+  // the board. Returns false if a pawn can't stand where it is.
+  auto Index(const size_t* squares, uint64_t* index) const -> bool;
+  // The squares of an index. Inverse of Index on canonical positions.
+  void Squares(uint64_t index, size_t* squares) const;
+};
+
+// How long generating an endgame took.
+struct Report {
+  std::string name_;
+  uint64_t positions_ = 0;
+  // Rounds of retrograde propagation, one per ply of the longest win.
+  size_t rounds_ = 0;
+  double seconds_ = 0;
+};
+
+// The bitbases at hand, found by endgame.
+class Tables {
+ public:
+  // Generates the endgame's bitbase, and first those of the endgames its
+  // captures and promotions lead to, unless already held. Work is split
+  // over the pool's threads. Appends a report of each bitbase generated.
+  // Throws std::invalid_argument for a bad name.
+  void Generate(const std::string& name, pool::ThreadPool* pool,
+                std::vector<Report>* reports = nullptr);
+  // Maps the file of every endgame found in the directory, named like
+  // "KRKP.bb". Returns how many. Throws std::runtime_error if one can't be
+  // read.
+  auto Load(const std::string& directory) -> size_t;
+  // Writes every bitbase held to the directory, one file each.
+  void Write(const std::string& directory) const;
+  // The bitbase of the endgame, or nullptr if none is held.
+  auto Find(const std::string& name) const -> const Bitbase*;
+  auto Size() const -> size_t { return tables_.size(); }
+  // The outcome for the player to move of the position of the pieces, in
+  // any order, probing whichever bitbase holds it, its colors reversed if
+  // need be. Kings alone draw. kUnknown if no bitbase holds it.
+  auto Probe(const PieceOn* pieces, size_t n, bool white_to_move) const
+      -> Wdl;
+  // The outcome for the player to move in the game, or kUnknown if no
+  // bitbase holds the position, castling is still possible or en passant
+  // may be.
+  auto Probe(const game::Game& game) const -> Wdl;
+
+ private:
+  std::map<std::string, std::unique_ptr<Bitbase>> tables_;
+};
+
+}  // namespace bitbase
+
+#endif  // FINALPROJECT_BITBASE_H
@@ -5,8 +5,10 @@
 #ifndef FINALPROJECT_BOARD_H
 #define FINALPROJECT_BOARD_H
 
-#include <cinder/app/App.h>
 #include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
 #include "piece.h"
 
 namespace board {
@@ -16,9 +18,6 @@ using std::vector;
 // The size of one dimension of a chess board.
 const size_t kSize = 8;
 const size_t kSquareSize = 100;
-const cinder::Color green = {.4867f, .5843f, .17725f};
-const cinder::Color white = cinder::Color::white();
-const cinder::Color yellow {.859f, .850f, .100f};
 
 class Board;
 
@@ -51,8 +50,6 @@ class Square {
   // Integer from 0 through 7 representing the y coordinate on a chess board
   // if viewed as a set of Cartesian coordinates.
   size_t y_;
-  // Color representing the color of the square (green or white)
-  cinder::Color sq_color_;
   // Returns whether or not there is a piece at this square.
   auto IsEmpty() const -> bool;
 };
@@ -64,6 +61,10 @@ class Board {
  public:
   // Default board constructor. Returns a board with the default board setup.
   Board();
+  // Constructs a board from the piece placement field of a FEN string (e.g.
+  // "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR"). Throws
+  // std::invalid_argument if the placement is malformed.
+  explicit Board(const std::string& placement);
   // Board destructor.
   ~Board();
   // Board copy constructor.
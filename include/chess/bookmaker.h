@@ -0,0 +1,142 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_BOOKMAKER_H
+#define FINALPROJECT_BOOKMAKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pgn.h"
+#include "polyglot.h"
+#include "pool.h"
+
+// Builds Polyglot opening books from collections of games: every move of
+// every game's opening is counted by how the game ended for the player who
+// made it, and the counts become the book's weights.
+namespace bookmaker {
+
+struct Options {
+  // Plies of each game put in the book.
+  size_t max_plies_ = 24;
+  // Moves played in fewer games are left out of the book.
+  uint32_t min_games_ = 1;
+  // Counts held in memory before they are sorted and spilled to a run file
+  // on disk, in megabytes.
+  size_t memory_mb_ = 256;
+  // The directory run files are made in.
+  std::string temp_dir_ = ".";
+  // Run files merged at a time. More runs are merged in passes.
+  size_t fan_in_ = 64;
+  // Games replayed per task.
+  size_t batch_ = 64;
+};
+
+// How a move fared, for the player who made it.
+struct Score {
+  uint32_t wins_ = 0;
+  uint32_t draws_ = 0;
+  uint32_t losses_ = 0;
+};
+
+// A move played from a position and how it fared.
+struct Count {
+  uint64_t key_;
+  uint16_t move_;
+  Score score_;
+};
+
+struct Report {
+  // Games replayed, and those left out for having no result or starting
+  // from another position.
+  uint64_t games_ = 0;
+  uint64_t skipped_ = 0;
+  // Games cut short by a move that could not be read or played.
+  uint64_t truncated_ = 0;
+  // Moves counted, over all games.
+  uint64_t moves_ = 0;
+  // Run files spilled to disk and merged.
+  size_t runs_ = 0;
+  // Entries in the book.
+  uint64_t entries_ = 0;
+};
+
+// Counts moves from games added from any number of threads, in a hash map
+// split into shards, each behind its own lock. When the counts outgrow the
+// memory budget they are sorted and spilled to a run file; writing the
+// book merges the runs.
+class Builder {
+ public:
+  explicit Builder(const Options& options = Options());
+  // Removes the run files.
+  ~Builder();
+  Builder(const Builder&) = delete;
+  auto operator=(const Builder&) -> Builder& = delete;
+  // Replays the game from the starting position up to the ply limit,
+  // counting each move. Games set up from another position or without a
+  // result are left out. Thread-safe.
+  void Add(const pgn::Record& record);
+  // Reads every game in the stream, replaying them on the pool's threads.
+  // At most a few batches are held at a time.
+  void Read(std::istream* in, pool::ThreadPool* pool);
+  // Writes the book of the counts so far: one entry per move played from
+  // a position, weighted by the half points it scored, 2 a win and 1 a
+  // draw, scaled down if need be so the position's best fits in 16 bits.
+  // Throws std::runtime_error if a file can't be read or written. The
+  // builder can't be added to afterwards.
+  auto Write(const std::string& path) -> Report;
+  // The counts held in memory, not yet spilled.
+  auto InMemory() const -> uint64_t {
+    return in_memory_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Slot {
+    uint64_t key_;
+    uint16_t move_;
+    auto operator==(const Slot& other) const -> bool {
+      return key_ == other.key_ && move_ == other.move_;
+    }
+  };
+  struct SlotHash {
+    auto operator()(const Slot& s) const -> size_t {
+      return static_cast<size_t>(s.key_ ^ (s.move_ * 0x9E3779B97F4A7C15ULL));
+    }
+  };
+  struct Shard {
+    std::mutex mutex_;
+    std::unordered_map<Slot, Score, SlotHash> counts_;
+  };
+
+  Options options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<uint64_t> in_memory_;
+  // The run files not yet merged away, and how many were made.
+  std::vector<std::string> runs_;
+  size_t next_run_;
+  // Runs spilled from memory.
+  size_t spills_;
+  uint64_t limit_;
+  std::mutex spill_mutex_;
+  std::mutex report_mutex_;
+  Report report_;
+
+  void Tally(uint64_t key, uint16_t move, const Score& score);
+  // Takes every count out of memory, sorted by key and move.
+  auto Drain() -> std::vector<Count>;
+  // Names a new run file and adds it to runs_.
+  auto NewRun() -> std::string;
+  // Spills the counts in memory to a new run file. The caller holds
+  // spill_mutex_.
+  void Spill();
+};
+
+}  // namespace bookmaker
+
+#endif  // FINALPROJECT_BOOKMAKER_H
@@ -0,0 +1,284 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_ENGINE_H
+#define FINALPROJECT_ENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bitbase.h"
+#include "game.h"
+#include "movepick.h"
+#include "nnue.h"
+#include "numa.h"
+#include "pawns.h"
+#include "stats.h"
+#include "timeman.h"
+#include "tt.h"
+
+// A computer player: searches a game's position for the best move.
+namespace engine {
+
+// The score of delivering mate at the root. Mate in n plies scores
+// kMateScore - n.
+const int kMateScore = 32000;
+// The score of a position the bitbases prove won, less the plies to reach
+// it. Above any evaluation and below every mate score.
+const int kKnownWin = 20000;
+// The deepest ply the search can reach.
+const size_t kMaxPly = 64;
+// How often a timed search reads the clock, in nodes. A node costs tens of
+// microseconds, so a hard limit is overrun by under a millisecond.
+const uint64_t kTimeCheckNodes = 16;
+
+// Returns the static evaluation of the position in centipawns, from the
+// point of view of the player to move: the game's incrementally updated
+// piece-square score blended by phase.
+auto Evaluate(const game::Game& game) -> int;
+
+struct Result;
+
+// Limits on a search. The search stops at whichever is reached first.
+struct Limits {
+  // The deepest iteration to search, in plies.
+  size_t depth_ = kMaxPly;
+  // The number of nodes after which the search stops, 0 for no limit.
+  uint64_t nodes_ = 0;
+  // Think for exactly this many milliseconds, 0 for no limit.
+  int64_t move_time_ms_ = 0;
+  // Unless its time_ms_ is 0, think time is allocated from the clock by a
+  // timeman::TimeManager.
+  timeman::TimeControl clock_;
+  // If set, called on the searching thread with the statistics of every
+  // thread of the search after each completed iteration and about every
+  // stats_interval_ms_ milliseconds in between.
+  std::function<void(const stats::SearchStats&)> on_stats_;
+  int64_t stats_interval_ms_ = 1000;
+  // If set, called on the searching thread with the result so far after
+  // each completed iteration.
+  std::function<void(const Result&)> on_iteration_;
+};
+
+// How the searcher searches, for tuning and for measuring each technique.
+struct Options {
+  // Evaluate with this network instead of the hand-written terms. Not
+  // owned; must outlive the searcher.
+  const nnue::Network* network_ = nullptr;
+  // Score positions captures have brought down to an endgame these
+  // bitbases hold, with fewer pieces than the root, as won, drawn or lost
+  // instead of searching them. Endgames with pawns are searched: the game
+  // has no promotion, which their bitbases assume. Not owned; must outlive
+  // the searcher.
+  const bitbase::Tables* bitbases_ = nullptr;
+  // Add pawn structure and king shelter terms, cached in a pawn hash table,
+  // to the material and piece-square evaluation.
+  bool pawn_structure_ = true;
+  // Resolve captures and check evasions past the nominal depth instead of
+  // evaluating a position in the middle of an exchange.
+  bool quiescence_ = true;
+  // In quiescence search, skip a capture when even winning the captured
+  // piece and this margin, in centipawns, can't raise the score to alpha.
+  // 0 turns delta pruning off.
+  int delta_margin_ = 200;
+  // Skip a node when passing the turn still fails high on a reduced search.
+  bool null_move_ = true;
+  // From this depth on, a null-move cutoff is only taken once a reduced
+  // search of the position without null moves confirms it.
+  size_t null_move_verify_depth_ = 6;
+  // Search late quiet moves to a depth reduced with the logarithm of the
+  // depth and the move's index, and again fully if they beat alpha.
+  bool lmr_ = true;
+  // Near the leaves, skip quiet moves when the static evaluation is far
+  // below alpha.
+  bool futility_ = true;
+  // Near the leaves, return the static evaluation when it is far above
+  // beta.
+  bool reverse_futility_ = true;
+  // Near the leaves, drop into quiescence search when the static
+  // evaluation is far below alpha. Off by default: it cost tactics_bench
+  // positions.
+  bool razoring_ = false;
+  // Search each iteration in a window of aspiration_window_ centipawns
+  // around the previous score, widened on failure.
+  bool aspiration_ = true;
+  int aspiration_window_ = 25;
+  // The number of best root moves to search a principal variation for.
+  // Each iteration searches them in turn, every line excluding the first
+  // moves of the lines found before it; the shared transposition table
+  // carries much of each line's work over to the next.
+  size_t multi_pv_ = 1;
+  // If set, a ParallelSearcher pins helper thread i to the topology's
+  // CpuFor(i), spreading the helpers over the NUMA nodes. The main search
+  // runs on the caller's thread, which is left as it is. Not owned; must
+  // outlive the searcher.
+  const numa::Topology* topology_ = nullptr;
+};
+
+// A principal variation and its score.
+struct Line {
+  // The moves in UCI notation, e.g. "e2e4".
+  std::vector<std::string> pv_;
+  // In centipawns, from the point of view of the player to move.
+  int score_ = 0;
+};
+
+// The outcome of a search.
+struct Result {
+  // The principal variation, each move in the "xyxy" format. Empty if the
+  // player to move has no legal moves.
+  std::vector<std::string> pv_;
+  // The score of the principal variation in centipawns, from the point of
+  // view of the player to move.
+  int score_ = 0;
+  // The depth of the last completed iteration, 0 if none completed.
+  size_t depth_ = 0;
+  // The number of nodes searched.
+  uint64_t nodes_ = 0;
+  // Nodes searched per second.
+  uint64_t nps_ = 0;
+  // Wall time spent searching.
+  double seconds_ = 0;
+  // Pawn hash table probes and hits.
+  uint64_t pawn_probes_ = 0;
+  uint64_t pawn_hits_ = 0;
+  // Nodes scored by Options::bitbases_.
+  uint64_t bitbase_hits_ = 0;
+  // The nodes searched in quiescence search, included in nodes_.
+  uint64_t quiescence_nodes_ = 0;
+  // Beta cutoffs, and how many of them the first move searched caused.
+  uint64_t cutoffs_ = 0;
+  uint64_t first_move_cutoffs_ = 0;
+  // Everything counted, the above included.
+  stats::SearchStats stats_;
+  // The Options::multi_pv_ best lines of the last completed iteration,
+  // best first, fewer if there are fewer legal moves. The first is pv_.
+  std::vector<Line> lines_;
+};
+
+class ParallelSearcher;
+
+// Iterative-deepening negamax alpha-beta search with principal variation
+// search. The searcher works on its own copy of the game, so the original
+// can keep changing while it thinks.
+class Searcher {
+ public:
+  // Creates a searcher for the game's current position. Results are cached
+  // in the transposition table, if given, which may be shared by searchers
+  // running at the same time.
+  explicit Searcher(const game::Game& game, tt::Table* table = nullptr,
+                    const Options& options = Options());
+  // Searches until a limit is reached or Stop is called. Returns the result
+  // of the last completed iteration or, if even the first was interrupted,
+  // its best root move so far, else the first legal one, at depth 0.
+  auto Search(const Limits& limits) -> Result;
+  // Asks a running search to stop as soon as possible. Safe to call from
+  // any thread.
+  void Stop();
+  // The statistics of the running or last search. Safe to call from any
+  // thread.
+  auto Stats() const -> stats::SearchStats;
+
+ private:
+  friend class ParallelSearcher;
+  // The search this searcher is a thread of, or nullptr.
+  const ParallelSearcher* parent_;
+  // 0 for a searcher of its own, otherwise the index of the helper thread
+  // in a ParallelSearcher. Helpers skip some depths.
+  size_t helper_;
+  // The searcher's own copy of the game. Moves are made and taken back on
+  // it with PlayTurn and UndoTurn.
+  game::Game game_;
+  // Not owned. May be nullptr.
+  tt::Table* table_;
+  // Set by Stop and by the node limit.
+  std::atomic<bool> stop_;
+  Options options_;
+  Limits limits_;
+  // Set during a search with a time limit.
+  std::unique_ptr<timeman::TimeManager> time_;
+  stats::Counters counters_;
+  // When Limits::on_stats_ is next due.
+  std::chrono::steady_clock::time_point next_report_;
+  // Triangular principal variation table: pv_[ply] holds the best line
+  // found from ply, pv_length_[ply] moves long.
+  game::Move pv_[kMaxPly][kMaxPly];
+  size_t pv_length_[kMaxPly];
+  // The principal variation of the last completed iteration, searched
+  // first in the next one. In a multi-PV search, that of the line being
+  // searched.
+  std::vector<game::Move> last_pv_;
+  // The root moves the line being searched may not start with: the first
+  // moves of the better lines of the iteration.
+  std::vector<uint16_t> excluded_root_;
+  // Kept across searches, as entries depend on the pawns alone.
+  pawns::Table pawn_table_;
+  // The pieces on the board at the root, and the nodes the bitbases have
+  // scored this search.
+  size_t root_pieces_;
+  uint64_t bitbase_hits_;
+  // Killers, history and countermoves, learned afresh each search.
+  movepick::Heuristics heuristics_;
+  // With a network, accumulators_[ply] belongs to the node ply plies from
+  // the root being searched.
+  std::vector<nnue::Accumulator> accumulators_;
+  // Returns the score of the position depth plies deep, ply plies from the
+  // root, within the window (alpha, beta).
+  // Null moves are tried only with allow_null.
+  auto Negamax(int alpha, int beta, size_t depth, size_t ply,
+               bool allow_null = true) -> int;
+  // Searches the root to the depth, in an aspiration window around the
+  // previous iteration's score if the options ask for one.
+  auto SearchRoot(size_t depth, int previous) -> int;
+  // True if the last move made on game_ was a null move.
+  auto LastMoveWasNull() const -> bool;
+  // Returns the score of the position once captures, and evasions when in
+  // check, have been played out. Otherwise the side to move may stand pat
+  // on the static evaluation.
+  auto Quiesce(int alpha, int beta, size_t ply) -> int;
+  // With a network, computes the accumulator of the node at the ply from
+  // its parent's, or from scratch at the root. Called on entering a node.
+  void Accumulate(size_t ply);
+  // The static evaluation of game_, the node at the ply, from the side to
+  // move's point of view, with the terms the options ask for.
+  auto StaticEval(size_t ply) -> int;
+  // Counts a node and checks the limits, the clock every kTimeCheckNodes
+  // nodes. Returns true if the search must stop.
+  auto CountNode() -> bool;
+  // Calls Limits::on_stats_ with the statistics of the whole search.
+  void ReportStats();
+};
+
+// Lazy SMP parallel search. Every thread runs a Searcher on its own copy of
+// the game over the same root, sharing results through one transposition
+// table. Helper threads skip some iterations so they run ahead of the main
+// thread and fill the table with deeper results for it.
+class ParallelSearcher {
+ public:
+  // Creates a search over the game's position with the given number of
+  // threads, at least one, sharing the table.
+  ParallelSearcher(const game::Game& game, size_t threads, tt::Table* table,
+                   const Options& options = Options());
+  // Searches until the main thread reaches a limit or Stop is called. The
+  // limits apply to the main thread; the result is that of the thread that
+  // completed the deepest iteration, with the nodes of every thread.
+  auto Search(const Limits& limits) -> Result;
+  // Asks a running search to stop as soon as possible. Safe to call from
+  // any thread.
+  void Stop();
+  // The statistics of every thread, added up. Safe to call from any thread.
+  auto Stats() const -> stats::SearchStats;
+
+ private:
+  // searchers_[0] runs on the thread calling Search, the rest are helpers.
+  std::vector<std::unique_ptr<Searcher>> searchers_;
+};
+
+}  // namespace engine
+
+#endif  // FINALPROJECT_ENGINE_H
@@ -0,0 +1,51 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_EVAL_H
+#define FINALPROJECT_EVAL_H
+
+#include <cstddef>
+
+#include "piece.h"
+
+// Tapered material and piece-square evaluation. Every piece contributes a
+// midgame and an endgame value depending on its square; a position's score
+// is the blend of the two sums by how much material is left.
+namespace eval {
+
+// The game phase with every knight, bishop, rook and queen on the board.
+const int kMaxPhase = 24;
+
+// A pair of midgame and endgame values, in centipawns.
+struct Score {
+  int mg_ = 0;
+  int eg_ = 0;
+};
+
+inline auto operator+=(Score& a, const Score& b) -> Score& {
+  a.mg_ += b.mg_;
+  a.eg_ += b.eg_;
+  return a;
+}
+
+inline auto operator-=(Score& a, const Score& b) -> Score& {
+  a.mg_ -= b.mg_;
+  a.eg_ -= b.eg_;
+  return a;
+}
+
+// The material plus piece-square value of the piece on square (x, y), from
+// the point of view of the piece's own side.
+auto PieceSquare(piece::PieceType t, piece::Color c, size_t x, size_t y)
+    -> Score;
+
+// How much the piece counts toward the game phase: 1 for minor pieces, 2
+// for rooks, 4 for queens, 0 otherwise.
+auto PhaseWeight(piece::PieceType t) -> int;
+
+// Blends the score by phase, from pure midgame at kMaxPhase to pure endgame
+// at 0.
+auto Blend(const Score& score, int phase) -> int;
+
+}  // namespace eval
+
+#endif  // FINALPROJECT_EVAL_H
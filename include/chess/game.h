@@ -5,9 +5,15 @@
 
 #ifndef FINALPROJECT_GAME_H
 #define FINALPROJECT_GAME_H
+#include <cstdint>
+#include <string>
 #include "board.h"
+#include "eval.h"
 #include "piece.h"
 
+namespace bench {
+struct GameAccess;
+}  // namespace bench
 
 namespace game {
 
@@ -43,6 +49,27 @@ struct Move {
 
 std::ostream &operator << (std::ostream &os, const Move &move);
 
+// The move in UCI long algebraic notation, e.g. "e2e4", or "0000" for a
+// null move.
+auto ToUci(const Move& move) -> std::string;
+
+// A piece put on or taken off a square by a move.
+struct PieceChange {
+  piece::PieceType type_;
+  piece::Color color_;
+  // The square as x + 8 * y.
+  size_t square_;
+  // True if the piece was put on the square, false if it was taken off.
+  bool added_;
+};
+
+// The pieces a move put on and took off squares, in order. Castling changes
+// the most: four.
+struct MoveChanges {
+  PieceChange changes_[4];
+  size_t size_ = 0;
+};
+
 // Class representing a player. Each game has two players.
 class Player {
  public:
@@ -74,6 +101,10 @@ class Game {
  public:
   // Default game constructor.
   Game(const int id);
+  // Constructs a game from a FEN string. The side to move, castling rights,
+  // en passant square and fullmove number are honored. Throws
+  // std::invalid_argument if the FEN is malformed.
+  Game(const std::string& fen, const int id);
   //Game Destructor.
   ~Game();
   // Game copy constructor.
@@ -93,6 +124,30 @@ class Game {
   int id_;
   // Current Move number
   size_t move_number_;
+  // The player who moves next.
+  Player* turn_;
+  // The Zobrist key of the position, kept up to date by PlayTurn and
+  // UndoTurn. Equal positions with the same side to move, castling rights
+  // and en passant file have equal keys.
+  uint64_t key_;
+  // Computes the Zobrist key of the position from scratch.
+  auto ComputeKey() const -> uint64_t;
+  // The XOR of the Zobrist keys of the pawns alone, kept up to date with
+  // key_. Positions with the same pawns share it.
+  uint64_t pawn_key_;
+  auto ComputePawnKey() const -> uint64_t;
+  // White's material and piece-square score minus Black's, kept up to date
+  // by PlayTurn and UndoTurn.
+  eval::Score psq_;
+  // The game phase, from eval::kMaxPhase with every piece on the board down
+  // to 0 with only kings and pawns, kept up to date with psq_.
+  int phase_;
+  // Compute psq_ and phase_ from scratch.
+  auto ComputePieceSquare() const -> eval::Score;
+  auto ComputePhase() const -> int;
+  // Returns the castling rights still held as zobrist::kWhiteKingSide, ...
+  // bits.
+  auto CastlingRights() const -> unsigned;
   // Returns the current game state of the board.
   auto EvaluateBoard() const -> GameState;
   // Takes in a move object for a player Move and returns true and updates
@@ -101,9 +156,72 @@ class Game {
   // Returns true if the player can legally make a move from a square to
   // another square.
   auto CanMove(const Square* from, const Square* to, Player* p) const -> bool;
+  // Takes back the last move played with PlayTurn or PlayNullMove,
+  // restoring the board and both players. Returns false if there is no move
+  // to take back.
+  auto UndoTurn() -> bool;
+  // The pieces changed by a move that UndoTurn can still take back: the
+  // last one for back 0, the one before for back 1, and so on. Null moves
+  // change none. Lets evaluations such as nnue::Accumulator be kept up to
+  // date outside the game. back must be below the number of such moves.
+  auto Changes(size_t back = 0) const -> const MoveChanges&;
+  // Passes the turn to the opponent without moving, for null-move pruning.
+  // Recorded in moves_ as a move with null squares. The player to move must
+  // not be in check.
+  void PlayNullMove();
   // Gets a move from a string
   auto GetMoveFromStr(const std::string str, Player* p) -> Move;
+  // Returns every legal move the player can make in the current position.
+  auto LegalMoves(Player* p) -> vector<Move>;
+  // Returns the legal moves of the player which capture, en passant
+  // included.
+  auto LegalCaptures(Player* p) -> vector<Move>;
  private:
+  // The state of a player overwritten by a turn.
+  struct PlayerState {
+    bool HasKingMoved_;
+    bool HasKingRookMoved_;
+    bool HasQueenRookMoved_;
+    size_t numPieces_;
+    const Square* kingSquare_;
+    vector<const Square*> PiecesChecking_;
+  };
+  // Everything PlayTurn overwrites, kept so that UndoTurn can restore it.
+  struct Undo {
+    // The captured piece, owned by the game, or nullptr.
+    piece::Piece* captured_ = nullptr;
+    // The square the captured piece stood on. Differs from the destination
+    // of the move for en passant captures.
+    const Square* captured_at_ = nullptr;
+    PlayerState white_;
+    PlayerState black_;
+    size_t move_number_;
+    uint64_t key_;
+    uint64_t pawn_key_;
+    eval::Score psq_;
+    int phase_;
+    MoveChanges changes_;
+  };
+  // One undo record per move played with PlayTurn, oldest first.
+  vector<Undo> undo_;
+  // Saves the player's state before a turn. Moves out PiecesChecking_.
+  static void SaveState(Player& p, PlayerState* state);
+  // Restores the player's state after a turn is taken back.
+  static void RestoreState(PlayerState* state, Player* p);
+  // Put a piece on an empty square, take one off or move one, keeping key_,
+  // pawn_key_, psq_ and phase_ up to date in constant time. Each change is
+  // recorded in changes.
+  void PutPiece(piece::Piece* p, const Square* at, MoveChanges* changes);
+  auto RemovePiece(const Square* at, MoveChanges* changes) -> piece::Piece*;
+  void MovePiece(const Square* from, const Square* to, MoveChanges* changes);
+  // The part of the key not made of pieces: side to move, castling rights
+  // and en passant file.
+  auto StateKey() const -> uint64_t;
+  // Grants the benchmark suite access to the private validation helpers.
+  friend struct bench::GameAccess;
+  // Points the squares and players copied from another game at this game's
+  // own board and players. Called by the copy constructor and assignment.
+  void RemapCopiedPointers(const Game& other);
   // Checks whether the piece's path tries to run over an existing piece in a
   // move from a square to another.
   auto CheckPath(const Square* from, const Square *to) const -> bool;
@@ -111,12 +229,19 @@ class Game {
   // which the king would receive a check at the square at.
   auto GetPiecesChecking(const Square* at, Player* player) const ->
       vector<const Square*>;
+  // Returns true if the piece on the square from attacks the square at, i.e.
+  // could capture an enemy piece standing there.
+  auto Attacks(const Square* from, const Square* at) const -> bool;
   // Gets a vector of pointers to squares of all possible moves by a player
   // from a square.
   auto GetAllPossibleKingMoves(Player* p)
       const -> vector<const Square*>;
   // Returns true if the player can make a castling move to the given square.
   auto CanCastle(Player* p, const Square* s) const -> bool;
+  // Returns true if the move is legal: the player moves one of their own
+  // pieces, the piece can make the move, and the move does not leave the
+  // player's king in check. The board is left untouched.
+  auto IsLegal(const Move& m) const -> bool;
 };
 }  // namespace game
 
@@ -0,0 +1,113 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_MATE_H
+#define FINALPROJECT_MATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "game.h"
+
+// A mate solver: depth-first proof-number search (Nagai, 2002) answers
+// whether the player to move can force mate within a number of moves.
+// Unlike alpha-beta it needs no evaluation and spends its nodes where the
+// defender has the fewest replies.
+namespace mate {
+
+// Proof and disproof numbers saturate here.
+const uint32_t kInfinity = UINT32_MAX / 2;
+
+// The proof and disproof numbers of a node, from the point of view of the
+// player to move there: phi_ is 0 once the player is proven to reach their
+// goal, delta_ once they are proven not to. For the attacker the goal is
+// mate, for the defender avoiding it.
+struct Numbers {
+  uint32_t phi_ = 1;
+  uint32_t delta_ = 1;
+};
+
+// A fixed size table of proof and disproof numbers. When it fills up,
+// garbage collection drops the half of the entries whose subtrees took the
+// least work to search.
+class Table {
+ public:
+  // A table of as many entries as fit in the given number of megabytes,
+  // and at least 1024.
+  explicit Table(size_t megabytes = 16);
+  // The numbers stored for the key, or those of a new leaf.
+  auto Probe(uint64_t key) const -> Numbers;
+  // Stores the numbers for the key, with the nodes searched to find them.
+  void Store(uint64_t key, const Numbers& numbers, uint64_t work);
+  void Clear();
+  auto Size() const -> size_t { return size_; }
+  auto Capacity() const -> size_t { return entries_.size(); }
+  // The garbage collections run so far.
+  auto Collections() const -> size_t { return collections_; }
+
+ private:
+  struct Entry {
+    // 0 for an empty slot; keys are never 0.
+    uint64_t key_;
+    Numbers numbers_;
+    uint64_t work_;
+  };
+  // Linear probing over a power of two number of slots.
+  std::vector<Entry> entries_;
+  size_t size_;
+  size_t collections_;
+  auto Slot(uint64_t key) const -> size_t;
+  void Collect();
+};
+
+// The outcome of a mate search.
+struct Result {
+  // True if mate was proven, false if disproven or the node limit hit.
+  bool mate_ = false;
+  // True if the search ran to a proof or a disproof.
+  bool solved_ = false;
+  // A mating line in UCI notation, attacker first, if mate was proven.
+  std::vector<std::string> pv_;
+  uint64_t nodes_ = 0;
+  double seconds_ = 0;
+  // Table entries in use and the garbage collections run.
+  size_t entries_ = 0;
+  size_t collections_ = 0;
+};
+
+class Solver {
+ public:
+  // Solves with a table of the given size, kept across searches.
+  explicit Solver(size_t megabytes = 16);
+  // Returns whether the player to move in the game can mate within the
+  // given number of their moves, searching at most max_nodes nodes, 0 for
+  // no limit.
+  auto Solve(const game::Game& game, size_t moves, uint64_t max_nodes = 0)
+      -> Result;
+  // The smallest number of moves up to max_moves the player to move can
+  // mate in, trying each in turn, or 0 if there is none or the node limit
+  // was hit. Writes the last search's result to result, if given.
+  auto MateIn(const game::Game& game, size_t max_moves,
+              uint64_t max_nodes = 0, Result* result = nullptr) -> size_t;
+
+ private:
+  Table table_;
+  game::Game game_;
+  uint64_t nodes_;
+  uint64_t max_nodes_;
+  // The key of the position of game_, plies plies from the end of the
+  // search.
+  auto Key(size_t plies) const -> uint64_t;
+  // Searches game_'s position, plies plies from the end of the search and
+  // with the attacker to move or not, until its numbers reach a threshold
+  // or the node limit is hit. Returns its numbers.
+  auto Mid(size_t plies, bool attacker, uint32_t phi_threshold,
+           uint32_t delta_threshold) -> Numbers;
+  // Follows proven moves from game_'s position into pv.
+  void ProofLine(size_t plies, bool attacker, std::vector<std::string>* pv);
+};
+
+}  // namespace mate
+
+#endif  // FINALPROJECT_MATE_H
@@ -0,0 +1,171 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_MCTS_H
+#define FINALPROJECT_MCTS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "game.h"
+
+// Monte Carlo tree search: an alternative to the alpha-beta engine that
+// grows a tree of the positions it visits, steering each playout by PUCT
+// towards the moves that have scored best and those it knows least about.
+namespace mcts {
+
+// Node values are summed in fixed point, so threads can add to them with a
+// single atomic instruction.
+const int64_t kValueScale = 1 << 16;
+// More than the legal moves of any position. A node is only expanded while
+// the pool has this many nodes free.
+const size_t kMaxChildren = 256;
+
+// A node of the tree: a position reached by a move. Values are from the
+// point of view of the player who made the move.
+struct Node {
+  // The move, packed like tt::PackMove.
+  uint16_t move_;
+  // The number of children, which are consecutive in the pool from
+  // first_child_. Set before state_ becomes kExpanded.
+  uint8_t children_;
+  std::atomic<uint8_t> state_;
+  uint32_t first_child_;
+  // The probability the move is best, as guessed before it is searched.
+  float prior_;
+  // Visits and the sum of their values, each in [-1, 1] times kValueScale.
+  // Both include the virtual losses of playouts in progress.
+  std::atomic<uint32_t> visits_;
+  std::atomic<int64_t> value_;
+  // Copies a node when no thread is searching.
+  void CopyFrom(const Node& other);
+};
+
+// The states of a node.
+enum NodeState : uint8_t {
+  kUnexpanded,
+  // A thread is adding the children.
+  kExpanding,
+  kExpanded,
+  // The player to move has no legal moves.
+  kMate,
+  kStalemate,
+};
+
+// A fixed number of nodes allocated up front, handed out in blocks by
+// bumping an index. Nodes are never freed one by one.
+class NodePool {
+ public:
+  // A pool of as many nodes as fit in the given number of bytes.
+  explicit NodePool(size_t bytes);
+  // Allocates n consecutive nodes and returns the index of the first, or
+  // kFull if there is no room. Safe to call from any thread.
+  auto Allocate(size_t n) -> uint32_t;
+  auto operator[](uint32_t i) -> Node& { return nodes_[i]; }
+  auto operator[](uint32_t i) const -> const Node& { return nodes_[i]; }
+  auto Size() const -> size_t { return used_.load(std::memory_order_relaxed); }
+  auto Capacity() const -> size_t { return capacity_; }
+  // Keeps the first size nodes and frees the rest. Not thread safe.
+  void Resize(size_t size);
+  static const uint32_t kFull = UINT32_MAX;
+
+ private:
+  std::unique_ptr<Node[]> nodes_;
+  size_t capacity_;
+  std::atomic<uint32_t> used_;
+};
+
+struct Options {
+  // The number of threads growing the tree together.
+  size_t threads_ = 1;
+  // The tree is held within this many megabytes. Once full it stops
+  // growing and playouts only refine the values of the nodes it has.
+  size_t memory_mb_ = 64;
+  // Weighs exploring moves with high priors and few visits against
+  // exploiting those with the best values.
+  double c_puct_ = 1.5;
+  // The losses a playout adds to each node on its path until it backs up
+  // its value, so other threads prefer other paths meanwhile.
+  uint32_t virtual_loss_ = 1;
+};
+
+// Limits on a search. The search stops at whichever is reached first.
+struct Limits {
+  // The number of playouts, 0 for no limit.
+  uint64_t playouts_ = 0;
+  // Think for this many milliseconds, 0 for no limit.
+  int64_t move_time_ms_ = 0;
+};
+
+// The outcome of a search.
+struct Result {
+  // The most visited line, each move in UCI notation. Empty if the player
+  // to move has no legal moves.
+  std::vector<std::string> pv_;
+  // The value of the first move of the pv, in [-1, 1], and its visits.
+  double value_ = 0;
+  uint32_t visits_ = 0;
+  // The playouts of this search, their rate, and the time it took.
+  uint64_t playouts_ = 0;
+  double playouts_per_second_ = 0;
+  double seconds_ = 0;
+  // The nodes of the tree, those kept from earlier searches included, and
+  // what they take up.
+  size_t nodes_ = 0;
+  size_t bytes_per_node_ = sizeof(Node);
+  size_t memory_bytes_ = 0;
+};
+
+// Grows one tree over a game's positions across searches. Threads select
+// nodes by PUCT, expand them without locks and score new leaves with
+// engine::Evaluate.
+class Searcher {
+ public:
+  // Starts a tree at the game's current position. The searcher keeps its
+  // own copy of the game.
+  explicit Searcher(const game::Game& game,
+                    const Options& options = Options());
+  // Grows the tree until a limit is reached or Stop is called.
+  auto Search(const Limits& limits) -> Result;
+  // Asks a running search to stop as soon as possible. Safe to call from
+  // any thread.
+  void Stop();
+  // Plays the move, in UCI notation, and makes the node it leads to the
+  // root, keeping its subtree and compacting it to the front of the pool.
+  // Returns false if the tree had no node for the move and starts over.
+  // Throws std::invalid_argument if the move is illegal. Not safe during a
+  // search.
+  auto Advance(const std::string& move) -> bool;
+  // The number of nodes in the tree, and its root's visits.
+  auto Nodes() const -> size_t { return pool_.Size(); }
+  auto RootVisits() const -> uint32_t;
+
+ private:
+  game::Game game_;
+  Options options_;
+  NodePool pool_;
+  std::atomic<bool> stop_;
+  std::atomic<uint64_t> playouts_;
+  // Runs playouts on the game, a copy of game_, until the search stops.
+  void Work(game::Game game, const Limits& limits);
+  // Selects a leaf from the root, expands it and backs its value up the
+  // path. Returns false, having changed nothing, if another thread was
+  // expanding the leaf. The game is left as it was.
+  auto Playout(game::Game* game, std::vector<uint32_t>* path) -> bool;
+  // The child with the best PUCT score.
+  auto Select(uint32_t node) const -> uint32_t;
+  // Adds the children of the node, whose position is the game's, unless
+  // another thread is already at it or the pool is full.
+  void Expand(uint32_t node, game::Game* game);
+  // Clears the tree down to a root for game_'s position.
+  void Reset();
+  // Makes the node the root, dropping every node outside its subtree.
+  void Reroot(uint32_t node);
+};
+
+}  // namespace mcts
+
+#endif  // FINALPROJECT_MCTS_H
@@ -0,0 +1,124 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_MOVEPICK_H
+#define FINALPROJECT_MOVEPICK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+// Move ordering for alpha-beta search. Moves are handed out in stages, most
+// likely to cause a cutoff first, and each stage picks its next best move
+// lazily, so a node that cuts off early never scores or sorts the rest.
+namespace movepick {
+
+// The deepest ply with killer moves.
+const size_t kMaxPly = 64;
+// History scores stay within +-kMaxHistory.
+const int kMaxHistory = 16384;
+
+// Piece values in centipawns, for capture ordering and exchange evaluation.
+auto PieceValue(piece::PieceType t) -> int;
+
+// Packs the move like tt::PackMove, 0 for a null move.
+auto Pack(const game::Move& m) -> uint16_t;
+
+// True if the move captures, en passant included.
+auto IsCapture(const game::Move& m) -> bool;
+
+// The value of the piece a capture takes, a pawn for en passant.
+auto VictimValue(const game::Move& m) -> int;
+
+// Static exchange evaluation: the material the side making the move gains
+// if both sides keep recapturing on the destination square with their
+// least valuable attacker, each free to stop. Pins are ignored.
+auto See(const game::Game& game, const game::Move& m) -> int;
+
+// Quiet move ordering learned during a search: two killer moves per ply,
+// a history score per side and from/to square pair, and the move that last
+// refuted each previous move.
+class Heuristics {
+ public:
+  Heuristics();
+  // Forgets everything learned.
+  void Clear();
+  // Records that the quiet move best caused a cutoff at the ply, after the
+  // quiet moves in tried (best excluded) failed to. The game is at the
+  // node, so its last move is the one best refutes.
+  void UpdateQuiet(const game::Game& game, const game::Move& best,
+                   const std::vector<game::Move>& tried, size_t depth,
+                   size_t ply);
+  auto Killer(size_t ply, size_t i) const -> uint16_t {
+    return killers_[ply][i];
+  }
+  auto History(piece::Color c, const game::Move& m) const -> int;
+  // The refutation of the last move played in the game, or 0.
+  auto Countermove(const game::Game& game) const -> uint16_t;
+
+ private:
+  uint16_t killers_[kMaxPly][2];
+  int history_[2][64][64];
+  uint16_t countermoves_[64][64];
+  // Adds bonus to a history score, scaled down as the score nears
+  // kMaxHistory so scores saturate instead of overflowing.
+  void AddHistory(piece::Color c, const game::Move& m, int bonus);
+};
+
+// Hands out a node's legal moves in order: the hash move, captures that
+// don't lose material by MVV-LVA, killers, the countermove, the other quiet
+// moves by history, and last the losing captures.
+class MovePicker {
+ public:
+  // hash_move is the packed move from the transposition table or the
+  // principal variation, or 0.
+  MovePicker(const game::Game& game, const std::vector<game::Move>& moves,
+             uint16_t hash_move, const Heuristics& heuristics, size_t ply);
+  // For quiescence search: hands out only the captures among the moves
+  // that don't lose material, by MVV-LVA.
+  MovePicker(const game::Game& game, const std::vector<game::Move>& moves,
+             const Heuristics& heuristics);
+  // Sets m to the next move and returns true, or returns false when every
+  // move has been handed out.
+  auto Next(game::Move* m) -> bool;
+
+ private:
+  enum class Stage {
+    kHashMove,
+    kGoodCaptures,
+    kKillers,
+    kCountermove,
+    kQuiets,
+    kBadCaptures,
+    kDone
+  };
+  struct Scored {
+    game::Move move_;
+    int score_;
+  };
+  const game::Game& game_;
+  const Heuristics& heuristics_;
+  size_t ply_;
+  Stage stage_;
+  // Index into the killers during kKillers.
+  size_t killer_;
+  bool has_hash_move_;
+  game::Move hash_move_;
+  std::vector<Scored> captures_;
+  std::vector<Scored> quiets_;
+  std::vector<game::Move> bad_captures_;
+  size_t next_bad_capture_;
+  // Set for quiescence search: the picker stops after the good captures.
+  bool captures_only_;
+  // Scores the capture and adds it to captures_.
+  void AddCapture(const game::Move& m);
+  // Removes and returns the highest scored move of the list.
+  static auto PickBest(std::vector<Scored>* list) -> game::Move;
+  // Removes the quiet move packed as packed and sets m to it, if present.
+  auto TakeQuiet(uint16_t packed, game::Move* m) -> bool;
+};
+
+}  // namespace movepick
+
+#endif  // FINALPROJECT_MOVEPICK_H
@@ -0,0 +1,113 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_NNUE_H
+#define FINALPROJECT_NNUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "game.h"
+
+// An efficiently updatable neural network evaluation. The inputs are
+// HalfKP features: for each side's perspective, one per non-king piece and
+// square, paired with that side's king square. The first layer's output,
+// the accumulator, only changes by a few weight rows per move, so it is
+// updated from the previous position's instead of recomputed. The small
+// layers after it run on 8-bit activations with AVX2, SSSE3 or SSE2
+// kernels, whichever the compiler targets, or portable scalar code.
+//
+// A network file is little-endian and starts with a header of six 32-bit
+// words: kMagic, kVersion, kFeatures, kHidden, kLayer1 and kLayer2. Then
+// come, each starting at a multiple of 64 bytes from the start of the file:
+//   int16 feature biases[kHidden]
+//   int16 feature weights[kFeatures][kHidden]
+//   int32 layer 1 biases[kLayer1]
+//   int8  layer 1 weights[kLayer1][2 * kHidden]
+//   int32 layer 2 biases[kLayer2]
+//   int8  layer 2 weights[kLayer2][kLayer1]
+//   int32 output bias
+//   int8  output weights[kLayer2]
+// Hidden layers take the accumulator of the side to move followed by the
+// other's, each clipped to [0, 127]. Their sums are shifted right by
+// kWeightShift and clipped to [0, 127] again. The output divided by
+// kOutputScale is the evaluation in centipawns for the side to move.
+namespace nnue {
+
+const uint32_t kMagic = 0x4e4e4843;  // "CHNN"
+const uint32_t kVersion = 1;
+// King square, piece kind other than a king by color, piece square.
+const size_t kFeatures = 64 * 10 * 64;
+const size_t kHidden = 256;
+const size_t kLayer1 = 32;
+const size_t kLayer2 = 32;
+const int kWeightShift = 6;
+const int kOutputScale = 16;
+
+// The index of the feature for a piece of color c and type t, not a king,
+// on square (x, y) from the perspective of the side whose king stands on
+// (kx, ky). Black's perspective is mirrored vertically so both sides see
+// the board from their own back rank.
+auto Feature(piece::Color perspective, size_t kx, size_t ky, piece::Color c,
+             piece::PieceType t, size_t x, size_t y) -> size_t;
+
+// The first layer's output for both perspectives, White's at index 1 like
+// piece::Color::kWhite.
+struct Accumulator {
+  int16_t values_[2][kHidden];
+};
+
+// The name of the kernels compiled in: "avx2", "ssse3", "sse2" or "scalar".
+auto Simd() -> const char*;
+
+// A network mapped read-only from its file, shared by any number of
+// searchers.
+class Network {
+ public:
+  // Maps the file. Throws std::runtime_error if it can't be read or isn't a
+  // network of this layout.
+  static auto Load(const std::string& path) -> std::unique_ptr<Network>;
+  // Writes a network of random weights drawn from the seed, for tests and
+  // benchmarks when no trained network is at hand. Throws
+  // std::runtime_error if the file can't be written.
+  static void WriteRandom(const std::string& path, uint64_t seed);
+  ~Network();
+  Network(const Network&) = delete;
+  auto operator=(const Network&) -> Network& = delete;
+  // Computes the accumulator of the game's position from scratch.
+  void Refresh(const game::Game& game, Accumulator* out) const;
+  // Computes the accumulator of the game's position from previous, that of
+  // the position before the game's last move, by the move's changes. A
+  // perspective whose king moved is refreshed instead.
+  void Update(const game::Game& game, const Accumulator& previous,
+              Accumulator* out) const;
+  // The evaluation in centipawns for the side to move.
+  auto Evaluate(const Accumulator& acc, piece::Color to_move) const -> int;
+  // Refreshes an accumulator and evaluates it.
+  auto Evaluate(const game::Game& game) const -> int;
+
+ private:
+  Network() = default;
+  // The file's contents, mapped or, where mapping isn't available, read
+  // into memory.
+  void* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  // Sections of the mapping.
+  const int16_t* feature_biases_ = nullptr;
+  const int16_t* feature_weights_ = nullptr;
+  const int32_t* layer1_biases_ = nullptr;
+  const int8_t* layer1_weights_ = nullptr;
+  const int32_t* layer2_biases_ = nullptr;
+  const int8_t* layer2_weights_ = nullptr;
+  const int32_t* output_bias_ = nullptr;
+  const int8_t* output_weights_ = nullptr;
+  // Computes one perspective of the accumulator from scratch.
+  void RefreshSide(const game::Game& game, piece::Color perspective,
+                   Accumulator* out) const;
+};
+
+}  // namespace nnue
+
+#endif  // FINALPROJECT_NNUE_H
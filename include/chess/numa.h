@@ -0,0 +1,67 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_NUMA_H
+#define FINALPROJECT_NUMA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Non-uniform memory access: which CPUs share a memory controller, so that
+// threads can be spread over the sockets of a machine and kept there, and
+// large tables spread over the sockets' memory. Reads Linux's sysfs and
+// calls the kernel directly; libnuma is not needed.
+namespace numa {
+
+// A node: CPUs and the memory nearest them, usually a socket.
+struct Node {
+  // The kernel's number for the node.
+  size_t id_;
+  std::vector<size_t> cpus_;
+};
+
+// Parses a Linux CPU list such as "0-3,8-11" into its CPUs. Throws
+// std::invalid_argument if it is malformed.
+auto ParseCpuList(const std::string& list) -> std::vector<size_t>;
+
+class Topology {
+ public:
+  // A single node of every hardware thread, as on machines without NUMA.
+  Topology();
+  explicit Topology(std::vector<Node> nodes);
+  // The machine's nodes, from /sys/devices/system/node, keeping the CPUs
+  // the process may run on. A single node where there is no such
+  // information.
+  static auto Detect() -> Topology;
+  // The nodes described in a directory laid out like
+  // /sys/devices/system/node: a nodeN directory per node, each with a
+  // cpulist file. Nodes without CPUs are left out. Throws
+  // std::runtime_error if no node with CPUs is found.
+  static auto Read(const std::string& directory) -> Topology;
+  auto Nodes() const -> const std::vector<Node>& { return nodes_; }
+  auto Cpus() const -> size_t;
+  // The CPU for worker i. Workers go round-robin over the nodes, then over
+  // each node's CPUs, so any number of them is spread evenly.
+  auto CpuFor(size_t worker) const -> size_t;
+  // The index in Nodes() of the node worker i runs on.
+  auto NodeFor(size_t worker) const -> size_t;
+  // The first n nodes only, e.g. to compare one socket against all.
+  auto Restrict(size_t n) const -> Topology;
+
+ private:
+  std::vector<Node> nodes_;
+};
+
+// Pins the calling thread to the CPU. Returns false where the platform
+// can't or the kernel refuses.
+auto PinThread(size_t cpu) -> bool;
+
+// Spreads the pages of the memory round-robin over the topology's nodes,
+// moving those already touched, so that no one node's memory controller
+// serves every thread. The memory must start on a page. Returns false where
+// the platform can't, with a single node, or if the kernel refuses.
+auto Interleave(void* memory, size_t bytes, const Topology& topology) -> bool;
+
+}  // namespace numa
+
+#endif  // FINALPROJECT_NUMA_H
@@ -0,0 +1,61 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_PAWNS_H
+#define FINALPROJECT_PAWNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "eval.h"
+#include "game.h"
+
+// Pawn structure evaluation: passed, isolated, doubled and backward pawns,
+// and the pawn shields in front of the kings. The terms depend on the pawns
+// alone, so they are cached by game::Game::pawn_key_ in a small table that
+// sibling positions nearly always hit.
+namespace pawns {
+
+// The pawn structure of a position.
+struct Entry {
+  // The pawn key the entry was computed for. An empty entry has key 0, the
+  // key of a position without pawns, and the correct all-zero terms.
+  uint64_t key_ = 0;
+  // White's pawn structure score minus Black's, shelter excluded.
+  eval::Score score_;
+  // front_[c][x]: the rank, counted from the side's own back rank, of the
+  // least advanced pawn of side c (0 for White) on file x, or 0 if none,
+  // as no pawn stands on its back rank.
+  uint8_t front_[2][8] = {};
+};
+
+// Computes the pawn structure of the position from scratch.
+auto Compute(const game::Game& game) -> Entry;
+
+// The value of the pawn shields in front of both kings, White's minus
+// Black's, from the entry of the game's position. Midgame only.
+auto Shelter(const Entry& entry, const game::Game& game) -> eval::Score;
+
+// A direct-mapped cache of entries. Not thread safe: each searcher owns
+// one.
+class Table {
+ public:
+  // The number of entries is rounded down to a power of two.
+  explicit Table(size_t entries = 1 << 13);
+  // Returns the entry for the game's pawns, computing it on a miss.
+  auto Probe(const game::Game& game) -> const Entry&;
+  void Clear();
+  uint64_t probes_ = 0;
+  uint64_t hits_ = 0;
+
+ private:
+  std::vector<Entry> entries_;
+};
+
+// Pawn structure plus king shelter, White's minus Black's, through the
+// table.
+auto Evaluate(const game::Game& game, Table* table) -> eval::Score;
+
+}  // namespace pawns
+
+#endif  // FINALPROJECT_PAWNS_H
@@ -0,0 +1,41 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_PERFT_H
+#define FINALPROJECT_PERFT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "game.h"
+#include "pool.h"
+#include "tt.h"
+
+// Performance test: counts the leaf nodes of the legal move tree. Used to
+// validate move generation and as a move generation benchmark.
+namespace perft {
+
+// Returns the number of leaf nodes depth plies below the game's position,
+// with the player to move given by game.turn_.
+auto Perft(const game::Game& game, size_t depth) -> uint64_t;
+// Perft which caches subtree counts in the table by position key. The table
+// may be shared with other threads running perft at the same time, but not
+// with a search, which stores different values.
+auto Perft(const game::Game& game, size_t depth, tt::Table* table)
+    -> uint64_t;
+
+// Perft split over the pool: one fork-join task per root move, each forking
+// a task per reply that counts its subtree on a private copy of the game.
+auto ParallelPerft(const game::Game& game, size_t depth, pool::ThreadPool* pool)
+    -> uint64_t;
+
+// Returns the perft count below each legal root move, keyed by the move in
+// the "xyxy" string format.
+auto Divide(const game::Game& game, size_t depth)
+    -> std::vector<std::pair<std::string, uint64_t>>;
+
+}  // namespace perft
+
+#endif  // FINALPROJECT_PERFT_H
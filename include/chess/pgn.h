@@ -0,0 +1,57 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_PGN_H
+#define FINALPROJECT_PGN_H
+
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "game.h"
+
+// Portable Game Notation: games as tag pairs followed by moves in standard
+// algebraic notation (SAN), read one game at a time from a stream.
+namespace pgn {
+
+// A game as read, its moves not yet checked.
+struct Record {
+  // Tag pairs by name, e.g. "White" or "Result".
+  std::map<std::string, std::string> tags_;
+  // The main line in SAN, without move numbers, comments, variations or
+  // annotation glyphs.
+  std::vector<std::string> moves_;
+  // "1-0", "0-1", "1/2-1/2" or "*", from the game termination marker or
+  // else the Result tag. Empty if there was neither.
+  std::string result_;
+};
+
+// Reads games from a stream one at a time, so collections of any size can
+// be streamed through.
+class Reader {
+ public:
+  // The stream must outlive the reader.
+  explicit Reader(std::istream* in) : in_(in), pending_(-1) {}
+  // Reads the next game into the record. Returns false at the end of the
+  // stream.
+  auto Next(Record* record) -> bool;
+
+ private:
+  std::istream* in_;
+  // A character read ahead, or -1.
+  int pending_;
+  auto Get() -> int;
+  // Skips to the character, past it.
+  void SkipTo(int end);
+  auto ReadTag(Record* record) -> bool;
+};
+
+// Finds the legal move the SAN names for the player to move, e.g. "Nbd7",
+// "exd5", "O-O-O" or "Qh4#". Returns false if there is no such move, more
+// than one, or it promotes, which the game doesn't support.
+auto ParseSan(game::Game* game, const std::string& san, game::Move* move)
+    -> bool;
+
+}  // namespace pgn
+
+#endif  // FINALPROJECT_PGN_H
@@ -6,10 +6,10 @@
 #define FINALPROJECT_PIECE_H
 
 #include <cstddef>
+#include <map>
+#include <string>
 #include <tuple>
 #include <vector>
-#include "cinder/ImageIo.h"
-#include "cinder/gl/Texture.h"
 
 namespace piece {
 
@@ -31,6 +31,8 @@ class Piece {
  public:
   // Piece constructor taking in a PieceType and Color enum.
   Piece(const PieceType t, const Color c);
+  // Pieces are owned and deleted through Piece pointers.
+  virtual ~Piece() = default;
   // The piece type.
   const PieceType type_;
   // image path;
@@ -128,6 +130,9 @@ class King : public Piece {
   // King Constructor.
   explicit King(const Color c);
 };
+
+// Allocates a new piece of the given type and color.
+auto MakePiece(const PieceType t, const Color c) -> Piece*;
 }  // namespace piece
 
 #endif  // FINALPROJECT_PIECE_H
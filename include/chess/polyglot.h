@@ -0,0 +1,106 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_POLYGLOT_H
+#define FINALPROJECT_POLYGLOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "game.h"
+
+// Polyglot opening books: files of 16-byte entries, sorted by position key,
+// each a move played from the position and how often to choose it. A book
+// is mapped, not read, and probed by binary search.
+namespace polyglot {
+
+// The number of random numbers hashed into a Polyglot key: 12 pieces on 64
+// squares, 4 castling rights, 8 en passant files and the side to move.
+const size_t kRandoms = 781;
+// The key of the starting position.
+const uint64_t kStartKey = 0x463B96181691FC9CULL;
+
+// The Polyglot key of the game's position, hashed with Polyglot's own
+// random numbers, so books from other programs can be read. The en passant
+// file counts only if a pawn of the player to move stands next to the pawn
+// that just moved two squares.
+auto Key(const game::Game& game) -> uint64_t;
+
+// A book entry, as stored but in host byte order. The move packs the
+// destination file in bits 0-2, its rank in bits 3-5, then the origin file
+// and rank in bits 6-11; castling is the king taking its own rook.
+struct Entry {
+  uint64_t key_;
+  uint16_t move_;
+  uint16_t weight_;
+  uint32_t learn_;
+};
+
+// A move the book holds for a position, packed as in an entry.
+struct BookMove {
+  uint16_t move_;
+  uint16_t weight_;
+};
+
+// Packs a move of the game as a book entry does.
+auto Encode(const game::Move& move) -> uint16_t;
+// The packed move in UCI notation, castling as the king's two-square move,
+// which the game's position, before the move, tells apart from a king
+// taking its rook.
+auto Decode(uint16_t move, const game::Game& game) -> std::string;
+
+// Writes a book file an entry at a time, for entries already in key order,
+// so a book need not fit in memory to be written.
+class Writer {
+ public:
+  // Throws std::runtime_error if the file can't be created.
+  explicit Writer(const std::string& path);
+  void Add(const Entry& entry);
+  // Flushes the file. Throws std::runtime_error if it wasn't all written.
+  void Close();
+
+ private:
+  std::string path_;
+  std::ofstream out_;
+};
+
+class Book {
+ public:
+  // Maps a book file. Throws std::runtime_error if it can't be read or its
+  // size isn't a multiple of an entry's.
+  static auto Open(const std::string& path) -> std::unique_ptr<Book>;
+  // Sorts the entries by key and writes them as a book file. Throws
+  // std::runtime_error if the file can't be written.
+  static void Write(const std::string& path, std::vector<Entry> entries);
+  ~Book();
+  Book(const Book&) = delete;
+  auto operator=(const Book&) -> Book& = delete;
+  auto Size() const -> size_t { return size_; }
+  // The moves held for the position with the key, in file order, which is
+  // heaviest first in books written by Polyglot.
+  auto Probe(uint64_t key) const -> std::vector<BookMove>;
+  auto Probe(const game::Game& game) const -> std::vector<BookMove> {
+    return Probe(Key(game));
+  }
+  // Picks one of the book's legal moves for the position at random, in
+  // proportion to the weights. Returns false if there is none.
+  auto Pick(game::Game* game, std::mt19937_64* random, game::Move* move) const
+      -> bool;
+
+ private:
+  Book() = default;
+  // The entries, mapped or held in owned_, big-endian as in the file.
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<uint8_t> owned_;
+  auto KeyAt(size_t i) const -> uint64_t;
+};
+
+}  // namespace polyglot
+
+#endif  // FINALPROJECT_POLYGLOT_H
@@ -0,0 +1,79 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_PONDER_H
+#define FINALPROJECT_PONDER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine.h"
+#include "game.h"
+#include "tt.h"
+
+// Thinking on the opponent's time: once a move is made, a background
+// search of the opponent's position predicts the likely replies and finds
+// the answer to each, so the answer is ready when a predicted reply comes.
+namespace ponder {
+
+// The best answer found to a predicted reply.
+struct Answer {
+  // In UCI notation, e.g. "e7e5".
+  std::string move_;
+  // In centipawns, from the point of view of the player answering.
+  int score_ = 0;
+  // The depth the answer was searched to below the reply.
+  size_t depth_ = 0;
+};
+
+// Runs one background search at a time and caches the answers of its last
+// completed iteration. All methods are called from one thread.
+class Ponderer {
+ public:
+  // Searches with the options and the table, which may be nullptr, for the
+  // given number of most likely replies.
+  explicit Ponderer(tt::Table* table,
+                    const engine::Options& options = engine::Options(),
+                    size_t replies = 4);
+  // Stops the search.
+  ~Ponderer();
+  Ponderer(const Ponderer&) = delete;
+  auto operator=(const Ponderer&) -> Ponderer& = delete;
+  // Stops any search and starts pondering the game's position, the
+  // opponent to move, forgetting the answers of the last one.
+  void Start(const game::Game& game);
+  // Stops the search, keeping its answers. Returns once the thread exits.
+  void Stop();
+  // Sets the answer to the reply, in UCI notation, and returns true if the
+  // reply was predicted.
+  auto Lookup(const std::string& reply, Answer* answer) const -> bool;
+  // The predicted replies, in UCI notation.
+  auto Replies() const -> std::vector<std::string>;
+  // The depth of the last completed iteration, 0 before the first.
+  auto Depth() const -> size_t;
+
+ private:
+  tt::Table* table_;
+  engine::Options options_;
+  std::unique_ptr<engine::Searcher> searcher_;
+  std::thread thread_;
+  // Guards the answers, the depth and done_, written by the searching
+  // thread.
+  mutable std::mutex mutex_;
+  std::map<std::string, Answer> answers_;
+  size_t depth_;
+  // Set when the search returns, signalled on done_changed_.
+  bool done_;
+  std::condition_variable done_changed_;
+  // Replaces the answers with those of the iteration's lines.
+  void Record(const engine::Result& result);
+};
+
+}  // namespace ponder
+
+#endif  // FINALPROJECT_PONDER_H
@@ -0,0 +1,229 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_POOL_H
+#define FINALPROJECT_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "numa.h"
+
+// A work-stealing thread pool for fork-join workloads such as perft
+// splitting and batch position analysis.
+namespace pool {
+
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models", 2013). The owning thread pushes
+// and pops at the bottom; any other thread steals from the top. T must be a
+// pointer type; nullptr means empty.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  // capacity must be a power of two. The deque grows when full.
+  explicit WorkStealingDeque(size_t capacity = 256)
+      : top_(0), bottom_(0), array_(new Array(capacity)) {
+    garbage_.emplace_back(array_.load(std::memory_order_relaxed));
+  }
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  auto operator=(const WorkStealingDeque&) -> WorkStealingDeque& = delete;
+
+  // Owner only.
+  void Push(T item) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    Array* a = array_.load(std::memory_order_relaxed);
+    if (b - t > static_cast<int64_t>(a->mask_)) {
+      // Thieves may still read the old array, so it is kept until the
+      // deque is destroyed.
+      a = a->Grow(b, t);
+      garbage_.emplace_back(a);
+      array_.store(a, std::memory_order_release);
+    }
+    a->Put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // Owner only. Returns the most recently pushed item, or nullptr.
+  auto Pop() -> T {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Array* a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T item = a->Get(b);
+    if (t == b) {
+      // The last item: race the thieves for it.
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread. Returns the oldest item, or nullptr if the deque is empty
+  // or another thread took it first.
+  auto Steal() -> T {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    Array* a = array_.load(std::memory_order_acquire);
+    T item = a->Get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  // A snapshot; may be stale by the time it returns.
+  auto Empty() const -> bool {
+    return bottom_.load(std::memory_order_relaxed) <=
+           top_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Array {
+    explicit Array(size_t capacity)
+        : mask_(capacity - 1), items_(new std::atomic<T>[capacity]) {}
+    auto Get(int64_t i) const -> T {
+      return items_[static_cast<size_t>(i) & mask_].load(
+          std::memory_order_relaxed);
+    }
+    void Put(int64_t i, T item) {
+      items_[static_cast<size_t>(i) & mask_].store(item,
+                                                   std::memory_order_relaxed);
+    }
+    auto Grow(int64_t b, int64_t t) const -> Array* {
+      Array* bigger = new Array(2 * (mask_ + 1));
+      for (int64_t i = t; i < b; i++) {
+        bigger->Put(i, Get(i));
+      }
+      return bigger;
+    }
+    size_t mask_;
+    std::unique_ptr<std::atomic<T>[]> items_;
+  };
+  // top_ is written by thieves and bottom_ by the owner, so they are kept
+  // on separate cache lines.
+  std::atomic<int64_t> top_;
+  char padding_[64];
+  std::atomic<int64_t> bottom_;
+  std::atomic<Array*> array_;
+  // Every array the deque has used, owned here.
+  std::vector<std::unique_ptr<Array>> garbage_;
+};
+
+class TaskGroup;
+
+// A fixed set of worker threads, each with its own work-stealing deque.
+// Tasks submitted from a worker go to its own deque, others to a shared
+// queue. Idle workers steal from random victims before going to sleep.
+class ThreadPool {
+ public:
+  // Starts the given number of workers, or one per hardware thread for 0.
+  // With pin_threads, worker i is pinned to numa::Topology::Detect()'s CPU
+  // for it, round-robin over the NUMA nodes, where the platform supports
+  // it.
+  explicit ThreadPool(size_t threads = 0, bool pin_threads = false);
+  // Starts workers pinned to the topology's CPUs, worker i to CpuFor(i).
+  // 0 threads is one per CPU of the topology.
+  ThreadPool(size_t threads, const numa::Topology& topology);
+  // Finishes the queued tasks and joins the workers.
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+  // Queues a task which no one waits for.
+  void Submit(std::function<void()> fn);
+  // The number of worker threads.
+  auto Size() const -> size_t { return workers_.size(); }
+  // The index of the calling worker thread of this pool, or -1.
+  auto WorkerIndex() const -> int;
+
+ private:
+  friend class TaskGroup;
+  struct Task {
+    std::function<void()> fn_;
+    // The group waiting for the task, or nullptr.
+    TaskGroup* group_;
+  };
+  struct Worker {
+    WorkStealingDeque<Task*> deque_;
+    std::thread thread_;
+  };
+  std::vector<std::unique_ptr<Worker>> workers_;
+  // Tasks submitted from outside the pool.
+  std::mutex mutex_;
+  std::deque<Task*> injected_;
+  // injected_.size(), readable without the lock.
+  std::atomic<size_t> injected_count_;
+  std::condition_variable wake_;
+  // Tasks queued but not yet taken, and workers asleep or going to sleep.
+  std::atomic<size_t> queued_;
+  std::atomic<size_t> sleepers_;
+  std::atomic<bool> stop_;
+  void Push(Task* task);
+  // Takes a queued task: the caller's own, an injected one or a stolen
+  // one. Returns nullptr if none was found.
+  auto Take(int self, uint64_t* seed) -> Task*;
+  // Runs a task and frees it.
+  static void Execute(Task* task);
+  // Runs one queued task if there is one. Used by waiting task groups to
+  // help instead of blocking.
+  auto RunOne(uint64_t* seed) -> bool;
+  void Start(size_t threads, const numa::Topology* topology);
+  // Runs tasks until the pool stops, pinned to the CPU unless it is -1.
+  void WorkerLoop(size_t index, int cpu);
+};
+
+// A fork-join scope: tasks run through the group are waited for together.
+// Waiting helps run queued tasks, so groups can be nested inside tasks
+// without tying up the workers.
+class TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool* pool);
+  // Waits for the group's tasks. Exceptions are dropped; call Wait first to
+  // see them.
+  ~TaskGroup();
+  TaskGroup(const TaskGroup&) = delete;
+  auto operator=(const TaskGroup&) -> TaskGroup& = delete;
+  // Queues a task in the group.
+  void Run(std::function<void()> fn);
+  // Returns once every task of the group has run or been skipped.
+  // Rethrows the first exception thrown by a task.
+  void Wait();
+  // Tasks of the group which have not started yet are skipped. Running
+  // tasks can check Cancelled to finish early.
+  void Cancel();
+  auto Cancelled() const -> bool;
+
+ private:
+  friend class ThreadPool;
+  ThreadPool* pool_;
+  std::atomic<size_t> pending_;
+  std::atomic<bool> cancelled_;
+  std::mutex mutex_;
+  std::exception_ptr error_;
+};
+
+}  // namespace pool
+
+#endif  // FINALPROJECT_POOL_H
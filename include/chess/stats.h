@@ -0,0 +1,129 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_STATS_H
+#define FINALPROJECT_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Search statistics: counts of the work a search does, kept by each
+// searching thread on its own and added up on demand.
+namespace stats {
+
+// Cutoffs are counted by the index of the move that caused them; moves from
+// kMoveIndices - 1 on share the last count.
+const size_t kMoveIndices = 8;
+
+// A completed iteration of iterative deepening.
+struct Iteration {
+  size_t depth_ = 0;
+  // The nodes searched by the iteration alone.
+  uint64_t nodes_ = 0;
+  // The time the iteration took, and the time since the search started
+  // when it completed.
+  double seconds_ = 0;
+  double elapsed_ = 0;
+};
+
+// The statistics of one searcher, or of several added up.
+struct SearchStats {
+  // The nodes searched, quiescence nodes included, and those alone.
+  uint64_t nodes_ = 0;
+  uint64_t quiescence_nodes_ = 0;
+  // Transposition table probes and the probes that found the position.
+  uint64_t hash_probes_ = 0;
+  uint64_t hash_hits_ = 0;
+  // Beta cutoffs by the index of the move that caused them.
+  uint64_t cutoffs_[kMoveIndices] = {};
+  // Null moves searched and those that cut the node off.
+  uint64_t null_move_tries_ = 0;
+  uint64_t null_move_cutoffs_ = 0;
+  // The completed iterations of the main thread.
+  std::vector<Iteration> iterations_;
+  // The threads added up.
+  size_t threads_ = 1;
+  // The time the search has run.
+  double seconds_ = 0;
+  // Adds the counters of another thread of the same search. The
+  // iterations and time are this thread's.
+  void Add(const SearchStats& other);
+  auto Cutoffs() const -> uint64_t;
+  // Each ratio is 0 when nothing was counted.
+  auto FirstMoveCutoffRate() const -> double;
+  auto HashHitRate() const -> double;
+  auto NullMoveSuccessRate() const -> double;
+  auto NodesPerSecond() const -> double;
+  // How many times more nodes each iteration took than the one before, as
+  // the geometric mean over the iterations. 0 with fewer than two.
+  auto EffectiveBranchingFactor() const -> double;
+  // Writes the statistics and the ratios as one JSON object.
+  void WriteJson(std::ostream& out) const;
+};
+
+// The counters of one searcher. Only the owning thread counts, with relaxed
+// loads and stores rather than read-modify-writes, so counting costs what
+// it does on plain integers and threads never contend. Any thread can take
+// a Snapshot meanwhile.
+class Counters {
+ public:
+  Counters();
+  // Zeroes the counters and restarts the clock.
+  void Start();
+  // Stops the clock, for snapshots taken after the search.
+  void Finish();
+  void CountNode() { Bump(&nodes_); }
+  void CountQuiescenceNode() { Bump(&quiescence_nodes_); }
+  void CountProbe(bool hit) {
+    Bump(&hash_probes_);
+    if (hit) {
+      Bump(&hash_hits_);
+    }
+  }
+  void CountCutoff(size_t move_index) {
+    Bump(&cutoffs_[move_index < kMoveIndices ? move_index
+                                             : kMoveIndices - 1]);
+  }
+  void CountNullMove(bool cutoff) {
+    Bump(&null_move_tries_);
+    if (cutoff) {
+      Bump(&null_move_cutoffs_);
+    }
+  }
+  // Records that an iteration to the depth completed.
+  void CompleteIteration(size_t depth);
+  auto Nodes() const -> uint64_t {
+    return nodes_.load(std::memory_order_relaxed);
+  }
+  auto Snapshot() const -> SearchStats;
+
+ private:
+  static void Bump(std::atomic<uint64_t>* counter) {
+    counter->store(counter->load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+  }
+  auto Elapsed() const -> double;
+  std::atomic<uint64_t> nodes_;
+  std::atomic<uint64_t> quiescence_nodes_;
+  std::atomic<uint64_t> hash_probes_;
+  std::atomic<uint64_t> hash_hits_;
+  std::atomic<uint64_t> cutoffs_[kMoveIndices];
+  std::atomic<uint64_t> null_move_tries_;
+  std::atomic<uint64_t> null_move_cutoffs_;
+  // Steady clock nanoseconds when the search started and finished, 0 while
+  // it runs.
+  std::atomic<int64_t> start_ns_;
+  std::atomic<int64_t> finish_ns_;
+  // Guards the iterations, written once per iteration.
+  mutable std::mutex mutex_;
+  std::vector<Iteration> iterations_;
+  // Nodes when the running iteration started.
+  uint64_t iteration_start_nodes_;
+};
+
+}  // namespace stats
+
+#endif  // FINALPROJECT_STATS_H
@@ -0,0 +1,66 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_TIMEMAN_H
+#define FINALPROJECT_TIMEMAN_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Think time allocation for a search from a chess clock.
+namespace timeman {
+
+using Clock = std::chrono::steady_clock;
+
+// The state of the searching player's clock when the search starts. All
+// times are in milliseconds.
+struct TimeControl {
+  // Time left on the clock.
+  int64_t time_ms_ = 0;
+  // Time added after each move.
+  int64_t increment_ms_ = 0;
+  // Moves until the next time control adds time, 0 for none.
+  size_t moves_to_go_ = 0;
+  // Time lost per move outside the search, e.g. to the network, kept in
+  // reserve.
+  int64_t overhead_ms_ = 20;
+};
+
+// Decides when a search stops. The soft limit is checked between
+// iterations: no new iteration starts once it is unlikely to finish before
+// it, and the limit shrinks while the best move stays the same. The hard
+// limit aborts an iteration in progress.
+class TimeManager {
+ public:
+  // Spends about the time left divided over the moves to go, plus most of
+  // the increment.
+  explicit TimeManager(const TimeControl& control);
+  // Thinks for exactly the given time.
+  static auto FixedTime(int64_t move_time_ms) -> TimeManager;
+  // Returns true if another iteration should start, given the best move of
+  // the iteration just completed.
+  auto StartIteration(uint16_t best_move) -> bool;
+  // Returns true once the hard limit has passed. Cheap enough to call every
+  // few hundred nodes.
+  auto HardLimitReached() const -> bool { return Clock::now() >= hard_; }
+  auto ElapsedMs() const -> int64_t;
+  auto SoftLimitMs() const -> int64_t;
+  auto HardLimitMs() const -> int64_t;
+
+ private:
+  TimeManager(Clock::time_point start, int64_t soft_ms, int64_t hard_ms,
+              bool scale);
+  Clock::time_point start_;
+  // Before scaling for stability.
+  int64_t soft_ms_;
+  Clock::time_point hard_;
+  // False for a fixed time, which is spent in full.
+  bool scale_;
+  uint16_t best_move_;
+  // Iterations in a row which returned the same best move.
+  size_t stable_iterations_;
+};
+
+}  // namespace timeman
+
+#endif  // FINALPROJECT_TIMEMAN_H
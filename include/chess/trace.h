@@ -0,0 +1,61 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_TRACE_H
+#define FINALPROJECT_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Scoped tracing. Always compiled in and off by default; when enabled every
+// CHESS_TRACE_SCOPE records its start time and duration into a lock-free
+// ring buffer owned by the current thread. The most recent events of every
+// thread can be exported as Chrome trace JSON and opened in
+// chrome://tracing or https://ui.perfetto.dev.
+namespace trace {
+
+// The number of events kept per thread. Older events are overwritten.
+const size_t kBufferSize = 1 << 16;
+
+// Turns recording on or off at runtime. Disabled scopes cost one relaxed
+// atomic load.
+void SetEnabled(bool enabled);
+auto IsEnabled() -> bool;
+
+// Nanoseconds since the trace clock started.
+auto Now() -> uint64_t;
+
+// Appends a completed event to the current thread's buffer. The name must
+// outlive the program (string literals).
+void Record(const char* name, uint64_t start_ns, uint64_t duration_ns);
+
+// RAII marker recording the time between its construction and destruction.
+class Scope {
+ public:
+  explicit Scope(const char* name);
+  ~Scope();
+  Scope(const Scope&) = delete;
+  auto operator=(const Scope&) -> Scope& = delete;
+
+ private:
+  const char* name_;
+  // False when tracing was disabled at construction.
+  bool active_;
+  uint64_t start_ns_;
+};
+
+// Drops every recorded event.
+void Clear();
+// Writes the recorded events of every thread in the Chrome trace event
+// format.
+void WriteChromeTrace(std::ostream& out);
+
+}  // namespace trace
+
+#define CHESS_TRACE_CONCAT_(a, b) a##b
+#define CHESS_TRACE_CONCAT(a, b) CHESS_TRACE_CONCAT_(a, b)
+// Traces the enclosing block under the given name.
+#define CHESS_TRACE_SCOPE(name) \
+  trace::Scope CHESS_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+#endif  // FINALPROJECT_TRACE_H
@@ -0,0 +1,112 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_TT_H
+#define FINALPROJECT_TT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "numa.h"
+#include "pool.h"
+
+// Transposition table: a fixed-size cache of results keyed by a position's
+// Zobrist key (game::Game::key_), shared by any number of threads without
+// locks.
+namespace tt {
+
+// How a stored score relates to the true score of the position.
+enum class Bound : uint8_t { kNone, kUpper, kLower, kExact };
+
+// The largest value an entry can hold.
+const uint64_t kMaxValue = (uint64_t{1} << 48) - 1;
+
+// A stored result. The table only interprets depth_ (deeper results are
+// kept in preference) and treats value_ as opaque.
+struct Entry {
+  // Up to 48 bits of user data, e.g. PackSearch's output or a perft count.
+  uint64_t value_ = 0;
+  // The depth the result was computed to.
+  uint8_t depth_ = 0;
+  Bound bound_ = Bound::kNone;
+};
+
+// A search result packed into an entry value.
+struct SearchValue {
+  // The best move as from and to square indices, x + 8 * y each, packed
+  // by PackMove. 0 for no move.
+  uint16_t move_ = 0;
+  int16_t score_ = 0;
+  int16_t eval_ = 0;
+};
+
+auto PackSearch(const SearchValue& v) -> uint64_t;
+auto UnpackSearch(uint64_t value) -> SearchValue;
+// Packs a move from square (fx, fy) to square (tx, ty).
+auto PackMove(size_t fx, size_t fy, size_t tx, size_t ty) -> uint16_t;
+
+// The table is an array of 64 byte buckets of four entries each, so a probe
+// touches a single cache line. Each entry is two atomic words, the key
+// XORed with the data and the data, written and read with relaxed
+// ordering. A torn entry, half written by another thread, fails the XOR
+// check and reads as a miss.
+class Table {
+ public:
+  // Allocates a table of about the given size, rounded down to a power of
+  // two number of buckets. With huge_pages, the table is backed by huge
+  // pages where the platform supports them.
+  explicit Table(size_t megabytes = 16, bool huge_pages = false);
+  ~Table();
+  Table(const Table&) = delete;
+  auto operator=(const Table&) -> Table& = delete;
+  // Reallocates the table, dropping every entry. Not thread safe.
+  void Resize(size_t megabytes, bool huge_pages = false);
+  // Drops every entry. Not thread safe.
+  void Clear();
+  // Drops every entry, the pool's workers clearing the buckets a share
+  // each. A new table's pages are only placed in memory when first
+  // touched, on the node of the thread touching them, so with workers
+  // pinned over the NUMA nodes this spreads the table over them too. Not
+  // thread safe.
+  void Clear(pool::ThreadPool* pool);
+  // Spreads the table's pages over the topology's nodes round-robin.
+  // Returns false if they could not be, e.g. on a single node.
+  auto Interleave(const numa::Topology& topology) -> bool;
+  // Starts a new search: entries from older searches are replaced first.
+  void NewSearch();
+  // Returns true and fills out if the key is stored.
+  auto Probe(uint64_t key, Entry* out) const -> bool;
+  // Stores an entry for the key. Deeper entries and entries of the current
+  // search are kept in preference to shallower and older ones.
+  void Store(uint64_t key, const Entry& entry);
+  // Entries of the current search per thousand, sampled like UCI hashfull.
+  auto Hashfull() const -> size_t;
+  // The size of the table in bytes.
+  auto Bytes() const -> size_t;
+  // True if the table is backed by huge pages.
+  auto HugePages() const -> bool { return huge_pages_; }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> key_;
+    std::atomic<uint64_t> data_;
+  };
+  struct alignas(64) Bucket {
+    Slot slots_[4];
+  };
+  Bucket* buckets_;
+  size_t num_buckets_;
+  // Whether the buckets were mapped (and must be unmapped) or allocated.
+  bool mapped_;
+  bool huge_pages_;
+  // Stored in every entry, 6 bits. Atomic so that a search can start while
+  // helper threads are still storing.
+  std::atomic<uint8_t> generation_;
+  void Allocate(size_t megabytes, bool huge_pages);
+  void Free();
+  auto BucketFor(uint64_t key) const -> Bucket*;
+};
+
+}  // namespace tt
+
+#endif  // FINALPROJECT_TT_H
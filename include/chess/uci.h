@@ -0,0 +1,99 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_UCI_H
+#define FINALPROJECT_UCI_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine.h"
+#include "game.h"
+#include "tt.h"
+
+// The Universal Chess Interface: the text protocol tournament managers and
+// GUIs drive engines with, a command per line.
+namespace uci {
+
+// The score as UCI sends it: "cp 35", or "mate 3" and "mate -2" in moves.
+auto FormatScore(int score) -> std::string;
+
+// An engine speaking UCI. Commands are handled on the calling thread;
+// searches run on a thread of their own, which sends their info and best
+// move lines, so "stop" and "ponderhit" are read while they think.
+class Engine {
+ public:
+  // Sends its replies to out, flushing after every line.
+  explicit Engine(std::ostream* out);
+  // Stops any search without waiting for its best move to be wanted.
+  ~Engine();
+  Engine(const Engine&) = delete;
+  auto operator=(const Engine&) -> Engine& = delete;
+  // Handles the commands read from in until "quit" or the end of the input,
+  // where a search without limits is stopped and any other one finished.
+  void Run(std::istream* in);
+  // Handles one command. Returns false if it was "quit". Unknown commands
+  // and malformed arguments are answered with an "info string".
+  auto Handle(const std::string& line) -> bool;
+  // Waits for the running search, if any, to send its best move. Must not
+  // be called while it searches without limits or ponders.
+  void Wait();
+
+ private:
+  std::ostream* out_;
+  // Guards writes to out_, which both threads make.
+  std::mutex out_mutex_;
+  // Null once a position was refused, until the next one.
+  std::unique_ptr<game::Game> game_;
+  tt::Table table_;
+  size_t threads_;
+  int64_t overhead_ms_;
+  engine::Options options_;
+  std::unique_ptr<engine::ParallelSearcher> searcher_;
+  std::thread thread_;
+  // Set by "stop" and "ponderhit". The search is told again after each
+  // iteration, in case the request came before it started.
+  std::atomic<bool> stop_requested_;
+  // Guards hold_ and silent_, signalled on released_.
+  std::mutex mutex_;
+  // While set, a finished search keeps its best move: one without limits,
+  // or pondering, must wait for "stop" or "ponderhit".
+  bool hold_;
+  // Set when a ponder search is replaced by the real one on "ponderhit",
+  // so that it sends no best move.
+  bool silent_;
+  std::condition_variable released_;
+  // Set while pondering, with the limits of the search "ponderhit" starts.
+  bool pondering_;
+  engine::Limits ponder_limits_;
+
+  void Send(const std::string& line);
+  void Uci();
+  void SetOption(const std::vector<std::string>& args);
+  void Position(const std::vector<std::string>& args);
+  void Go(const std::vector<std::string>& args);
+  // Starts searching game_ on thread_. With hold, the best move is sent
+  // only once the search is stopped.
+  void Launch(engine::Limits limits, bool hold);
+  // Stops the running search, if any, and joins its thread. Its best move
+  // is sent unless silent.
+  void Stop(bool silent = false);
+  void PonderHit();
+  // Sends an info line per line of the iteration's result, searched from
+  // the root.
+  void SendInfo(const game::Game& root, const engine::Result& result,
+                std::chrono::steady_clock::time_point start);
+};
+
+}  // namespace uci
+
+#endif  // FINALPROJECT_UCI_H
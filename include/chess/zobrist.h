@@ -0,0 +1,34 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#ifndef FINALPROJECT_ZOBRIST_H
+#define FINALPROJECT_ZOBRIST_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "piece.h"
+
+// Zobrist hashing: a position's key is the XOR of one random number per
+// piece on a square, plus numbers for the side to move, castling rights and
+// en passant file, so it can be updated incrementally as moves are played.
+namespace zobrist {
+
+// Castling right bits, as returned by game::Game::CastlingRights.
+const unsigned kWhiteKingSide = 1;
+const unsigned kWhiteQueenSide = 2;
+const unsigned kBlackKingSide = 4;
+const unsigned kBlackQueenSide = 8;
+
+// The key of a piece of the type and color on square (x, y).
+auto PieceKey(piece::PieceType t, piece::Color c, size_t x, size_t y)
+    -> uint64_t;
+// XORed in when black is to move.
+auto SideKey() -> uint64_t;
+// The key of a combination of castling right bits.
+auto CastlingKey(unsigned rights) -> uint64_t;
+// The key of an en passant capture being possible on the file.
+auto EnPassantKey(size_t file) -> uint64_t;
+
+}  // namespace zobrist
+
+#endif  // FINALPROJECT_ZOBRIST_H
@@ -0,0 +1,171 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/alloc.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+
+namespace alloc {
+
+namespace {
+
+// Per region counters. Plain arrays of atomics so that recording an
+// allocation never allocates.
+struct Counters {
+  std::atomic<const char*> name;
+  std::atomic<uint64_t> entries;
+  std::atomic<uint64_t> allocations;
+  std::atomic<uint64_t> bytes;
+  std::atomic<uint64_t> frees;
+};
+
+Counters regions[kMaxRegions];
+std::atomic<size_t> num_regions(1);
+std::mutex register_mutex;
+// The innermost region on this thread. Region 0 collects everything
+// allocated outside of a scope.
+thread_local size_t current_region = 0;
+
+#ifdef CHESS_TRACK_ALLOCATIONS
+// Prints the report when the program exits.
+struct ExitReport {
+  ~ExitReport() { Dump(std::cerr); }
+} exit_report;
+#endif
+
+}  // namespace
+
+auto RegisterRegion(const char* name) -> size_t {
+  std::lock_guard<std::mutex> lock(register_mutex);
+  size_t count = num_regions.load();
+  for (size_t i = 1; i < count; i++) {
+    if (std::strcmp(regions[i].name.load(), name) == 0) {
+      return i;
+    }
+  }
+  if (count == kMaxRegions) {
+    // Out of slots, fall back to the untracked region.
+    return 0;
+  }
+  regions[count].name = name;
+  num_regions = count + 1;
+  return count;
+}
+
+Scope::Scope(size_t region) : previous_(current_region) {
+  current_region = region;
+  regions[region].entries.fetch_add(1, std::memory_order_relaxed);
+}
+
+Scope::~Scope() { current_region = previous_; }
+
+auto Enabled() -> bool {
+#ifdef CHESS_TRACK_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+void RecordAllocation(size_t bytes) {
+  Counters& c = regions[current_region];
+  c.allocations.fetch_add(1, std::memory_order_relaxed);
+  c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void RecordFree() {
+  regions[current_region].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto Snapshot() -> std::vector<RegionStats> {
+  std::vector<RegionStats> stats;
+  size_t count = num_regions.load();
+  for (size_t i = 0; i < count; i++) {
+    const char* name = i == 0 ? "(untracked)" : regions[i].name.load();
+    stats.push_back({name, regions[i].entries.load(),
+                     regions[i].allocations.load(), regions[i].bytes.load(),
+                     regions[i].frees.load()});
+  }
+  return stats;
+}
+
+auto TotalAllocations() -> uint64_t {
+  uint64_t total = 0;
+  for (const Counters& c : regions) {
+    total += c.allocations.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+auto TotalBytes() -> uint64_t {
+  uint64_t total = 0;
+  for (const Counters& c : regions) {
+    total += c.bytes.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+void Reset() {
+  for (Counters& c : regions) {
+    c.entries = 0;
+    c.allocations = 0;
+    c.bytes = 0;
+    c.frees = 0;
+  }
+}
+
+void Dump(std::ostream& out) {
+  if (!Enabled()) {
+    out << "allocation tracking disabled, rebuild with "
+           "CHESS_TRACK_ALLOCATIONS\n";
+    return;
+  }
+  out << std::left << std::setw(24) << "region" << std::right
+      << std::setw(12) << "entries" << std::setw(14) << "allocs"
+      << std::setw(16) << "bytes" << std::setw(14) << "frees"
+      << std::setw(14) << "allocs/entry" << "\n";
+  for (const RegionStats& r : Snapshot()) {
+    double per_entry = r.entries == 0 ? 0
+                                      : static_cast<double>(r.allocations) /
+                                            static_cast<double>(r.entries);
+    out << std::left << std::setw(24) << r.name << std::right
+        << std::setw(12) << r.entries << std::setw(14) << r.allocations
+        << std::setw(16) << r.bytes << std::setw(14) << r.frees
+        << std::setw(14) << std::fixed << std::setprecision(2) << per_entry
+        << "\n";
+  }
+}
+
+}  // namespace alloc
+
+#ifdef CHESS_TRACK_ALLOCATIONS
+// Counting replacements of the global allocation functions. The array forms
+// forward to these by default.
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC cannot see that free matches the malloc in the replaced operator new.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+  alloc::RecordAllocation(size);
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  if (p != nullptr) {
+    alloc::RecordFree();
+  }
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+#endif
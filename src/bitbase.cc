@@ -0,0 +1,904 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/bitbase.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "chess/trace.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bitbase {
+
+using piece::Color;
+using piece::PieceType;
+
+namespace {
+
+// The file holds the magic, the version, the name padded with zeros and
+// the positions of each side to move, then the bits.
+const uint32_t kMagic = 0x42424843;  // "CHBB"
+const uint32_t kVersion = 1;
+const size_t kNameBytes = 8;
+const size_t kHeaderBytes =
+    2 * sizeof(uint32_t) + kNameBytes + sizeof(uint64_t);
+
+// The pieces after each king in a name, in order, and their values for
+// telling the stronger side.
+const char kOrder[] = "QRBNP";
+const int kValues[] = {9, 5, 3, 3, 1};
+
+auto Letter(PieceType t) -> char {
+  switch (t) {
+    case PieceType::kKing:
+      return 'K';
+    case PieceType::kQueen:
+      return 'Q';
+    case PieceType::kRook:
+      return 'R';
+    case PieceType::kBishop:
+      return 'B';
+    case PieceType::kKnight:
+      return 'N';
+    default:
+      return 'P';
+  }
+}
+
+auto TypeOf(char c) -> PieceType {
+  switch (c) {
+    case 'K':
+      return PieceType::kKing;
+    case 'Q':
+      return PieceType::kQueen;
+    case 'R':
+      return PieceType::kRook;
+    case 'B':
+      return PieceType::kBishop;
+    case 'N':
+      return PieceType::kKnight;
+    default:
+      return PieceType::kPawn;
+  }
+}
+
+auto OrderOf(char c) -> size_t {
+  return static_cast<size_t>(std::strchr(kOrder, c) - kOrder);
+}
+
+auto ByOrder(char a, char b) -> bool { return OrderOf(a) < OrderOf(b); }
+
+auto Material(const std::string& side) -> int {
+  int value = 0;
+  for (const char c : side) {
+    value += kValues[OrderOf(c)];
+  }
+  return value;
+}
+
+auto Bit(size_t square) -> uint64_t { return uint64_t(1) << square; }
+
+auto FlipRanks(uint64_t squares) -> uint64_t {
+  uint64_t flipped = 0;
+  for (size_t sq = 0; sq < 64; sq++) {
+    if (squares & Bit(sq)) {
+      flipped |= Bit(sq ^ 56);
+    }
+  }
+  return flipped;
+}
+
+auto Side(Color c) -> size_t { return c == Color::kWhite ? 0 : 1; }
+
+auto Other(Color c) -> Color {
+  return c == Color::kWhite ? Color::kBlack : Color::kWhite;
+}
+
+// A move of a piece to a square, and the squares it passes over, which
+// must be empty.
+struct Step {
+  size_t to_;
+  uint64_t between_;
+};
+
+// The moves of every piece from every square, worked out once from
+// piece::Piece::CanMove and Path so that the bitbases play by the game's
+// rules.
+struct Rules {
+  // By piece type, pawns aside.
+  std::vector<Step> moves_[6][64];
+  // By color: pawn pushes, captures, and pushes taken back, whose to_ is
+  // the square the pawn came from.
+  std::vector<Step> pushes_[2][64];
+  std::vector<Step> captures_[2][64];
+  std::vector<Step> unpushes_[2][64];
+};
+
+auto BuildRules() -> Rules {
+  Rules rules;
+  for (const PieceType t :
+       {PieceType::kKing, PieceType::kQueen, PieceType::kRook,
+        PieceType::kBishop, PieceType::kKnight, PieceType::kPawn}) {
+    std::unique_ptr<piece::Piece> p(piece::MakePiece(t, Color::kWhite));
+    for (size_t from = 0; from < 64; from++) {
+      const size_t fx = from % 8;
+      const size_t fy = from / 8;
+      if (t == PieceType::kPawn && (fy == 0 || fy == 7)) {
+        continue;
+      }
+      for (size_t to = 0; to < 64; to++) {
+        const size_t tx = to % 8;
+        const size_t ty = to / 8;
+        if (to == from || !p->CanMove(fx, fy, tx, ty)) {
+          continue;
+        }
+        // Castling needs rights, which bitbases don't have.
+        const size_t dx = std::max(fx, tx) - std::min(fx, tx);
+        const size_t dy = std::max(fy, ty) - std::min(fy, ty);
+        if (t == PieceType::kKing && (dx > 1 || dy > 1)) {
+          continue;
+        }
+        Step step = {to, 0};
+        for (const auto& xy : p->Path(fx, fy, tx, ty)) {
+          const size_t sq = std::get<0>(xy) + 8 * std::get<1>(xy);
+          if (sq != to) {
+            step.between_ |= Bit(sq);
+          }
+        }
+        if (t != PieceType::kPawn) {
+          rules.moves_[static_cast<size_t>(t)][from].push_back(step);
+          continue;
+        }
+        // Black pawns move as White's do, mirrored.
+        const Step black = {to ^ 56, FlipRanks(step.between_)};
+        if (fx == tx) {
+          rules.pushes_[0][from].push_back(step);
+          rules.unpushes_[0][to].push_back({from, step.between_});
+          rules.pushes_[1][from ^ 56].push_back(black);
+          rules.unpushes_[1][to ^ 56].push_back({from ^ 56, black.between_});
+        } else {
+          rules.captures_[0][from].push_back(step);
+          rules.captures_[1][from ^ 56].push_back(black);
+        }
+      }
+    }
+  }
+  return rules;
+}
+
+auto TheRules() -> const Rules& {
+  static const Rules rules = BuildRules();
+  return rules;
+}
+
+// True if the piece on from attacks the square, with the given squares
+// occupied.
+auto Attacks(PieceType t, Color c, size_t from, size_t square,
+             uint64_t occupied) -> bool {
+  const Rules& rules = TheRules();
+  const std::vector<Step>& steps =
+      t == PieceType::kPawn ? rules.captures_[Side(c)][from]
+                            : rules.moves_[static_cast<size_t>(t)][from];
+  for (const Step& step : steps) {
+    if (step.to_ == square) {
+      return (step.between_ & occupied) == 0;
+    }
+  }
+  return false;
+}
+
+// Splits a canonical name into the pieces after each king.
+void SplitName(const std::string& name, std::string* white,
+               std::string* black) {
+  const size_t second = name.find('K', 1);
+  *white = name.substr(1, second - 1);
+  *black = name.substr(second + 1);
+}
+
+// The endgames a capture or a promotion leads to from the endgame, those
+// with kings alone excepted.
+auto Successors(const std::string& name) -> std::vector<std::string> {
+  std::string sides[2];
+  SplitName(name, &sides[0], &sides[1]);
+  std::vector<std::string> next;
+  for (size_t s = 0; s < 2; s++) {
+    for (size_t i = 0; i < sides[s].size(); i++) {
+      std::string changed[2] = {sides[0], sides[1]};
+      changed[s].erase(i, 1);
+      next.push_back("K" + changed[0] + "K" + changed[1]);
+      if (sides[s][i] == 'P') {
+        changed[s] = sides[s];
+        changed[s][i] = 'Q';
+        next.push_back("K" + changed[0] + "K" + changed[1]);
+      }
+    }
+  }
+  std::vector<std::string> canonical;
+  for (const std::string& n : next) {
+    if (n.size() > 2) {
+      canonical.push_back(CanonicalName(n));
+    }
+  }
+  return canonical;
+}
+
+}  // namespace
+
+auto CanonicalName(const std::string& name) -> std::string {
+  const size_t second = name.empty() ? std::string::npos : name.find('K', 1);
+  if (name.size() > kMaxPieces || name[0] != 'K' ||
+      second == std::string::npos ||
+      name.find_first_not_of("KQRBNP") != std::string::npos ||
+      name.find('K', second + 1) != std::string::npos) {
+    throw std::invalid_argument("bad endgame name: " + name);
+  }
+  std::string white;
+  std::string black;
+  SplitName(name, &white, &black);
+  std::sort(white.begin(), white.end(), ByOrder);
+  std::sort(black.begin(), black.end(), ByOrder);
+  const auto key = [](const std::string& side) {
+    std::string orders;
+    for (const char c : side) {
+      orders.push_back(static_cast<char>('0' + OrderOf(c)));
+    }
+    return orders;
+  };
+  const int difference = Material(white) - Material(black);
+  if (difference < 0 || (difference == 0 && key(black) < key(white))) {
+    std::swap(white, black);
+  }
+  return "K" + white + "K" + black;
+}
+
+// Finds a bitbase by retrograde analysis. Every position starts with the
+// number of its moves that stay in the endgame. Mates, and positions whose
+// captures or promotions win, are settled first; then each round takes
+// the positions settled by the last one and, unmaking moves, settles the
+// positions that lead to them: a move to a lost position wins, and once
+// every move leads to a won one the position is lost. What is never
+// settled is drawn.
+class Generator {
+ public:
+  Generator(Bitbase* table, const Tables& smaller, pool::ThreadPool* pool)
+      : table_(table), smaller_(smaller), pool_(pool), rules_(TheRules()) {}
+
+  // Fills in the table's bits and counts. Returns the rounds it took.
+  auto Run() -> size_t {
+    const uint64_t n = table_->positions_;
+    for (size_t s = 0; s < 2; s++) {
+      state_[s].reset(new std::atomic<uint8_t>[n]);
+      moves_left_[s].reset(new std::atomic<uint8_t>[n]);
+    }
+    std::vector<uint64_t> frontier = Parallel(2 * n, [this](uint64_t entry,
+                                                   std::vector<uint64_t>* out) {
+      Initialize(entry % 2, entry / 2, out);
+    });
+    size_t rounds = 0;
+    while (!frontier.empty()) {
+      rounds++;
+      const std::vector<uint64_t> settled = frontier;
+      frontier = Parallel(settled.size(),
+                          [this, &settled](uint64_t i,
+                                           std::vector<uint64_t>* out) {
+                            Unmake(settled[i], out);
+                          });
+    }
+    Pack();
+    return rounds;
+  }
+
+ private:
+  enum State : uint8_t { kPending, kWon, kLost, kDrawn, kIllegal };
+  Bitbase* table_;
+  const Tables& smaller_;
+  pool::ThreadPool* pool_;
+  const Rules& rules_;
+  // By side to move, White first.
+  std::unique_ptr<std::atomic<uint8_t>[]> state_[2];
+  std::unique_ptr<std::atomic<uint8_t>[]> moves_left_[2];
+
+  // Runs fn on 0 to n - 1, split over the pool, and returns what it
+  // appended, as entries: index * 2 + side to move.
+  template <typename Fn>
+  auto Parallel(uint64_t n, Fn fn) -> std::vector<uint64_t> {
+    const uint64_t chunks = std::min<uint64_t>(
+        std::max<uint64_t>(4 * pool_->Size(), 1), std::max<uint64_t>(n, 1));
+    std::vector<std::vector<uint64_t>> out(chunks);
+    pool::TaskGroup group(pool_);
+    for (uint64_t c = 0; c < chunks; c++) {
+      group.Run([&, c] {
+        for (uint64_t i = n * c / chunks; i < n * (c + 1) / chunks; i++) {
+          fn(i, &out[c]);
+        }
+      });
+    }
+    group.Wait();
+    std::vector<uint64_t> all;
+    for (const std::vector<uint64_t>& part : out) {
+      all.insert(all.end(), part.begin(), part.end());
+    }
+    return all;
+  }
+
+  auto Occupied(const size_t* squares) const -> uint64_t {
+    uint64_t occupied = 0;
+    for (size_t i = 0; i < table_->pieces_; i++) {
+      occupied |= Bit(squares[i]);
+    }
+    return occupied;
+  }
+
+  // True if the king of the color is attacked, the piece at skip, if any,
+  // having been captured.
+  auto InCheck(const size_t* squares, Color c,
+               size_t skip = kMaxPieces) const -> bool {
+    const size_t king = squares[Side(c)];
+    const uint64_t occupied = Occupied(squares) & ~(skip < kMaxPieces
+                                                        ? Bit(squares[skip])
+                                                        : 0);
+    for (size_t i = 0; i < table_->pieces_; i++) {
+      if (i != skip && table_->colors_[i] != c &&
+          Attacks(table_->types_[i], table_->colors_[i], squares[i], king,
+                  occupied)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The outcome, for the player to move then, of a move that leaves the
+  // endgame: the piece at captured, if any, is taken and the piece at
+  // promoted, if any, becomes a queen.
+  auto Exit(const size_t* squares, size_t captured, size_t promoted,
+            Color to_move) const -> Wdl {
+    PieceOn pieces[kMaxPieces];
+    size_t n = 0;
+    for (size_t i = 0; i < table_->pieces_; i++) {
+      if (i != captured) {
+        pieces[n++] = {i == promoted ? PieceType::kQueen : table_->types_[i],
+                       table_->colors_[i], squares[i]};
+      }
+    }
+    const Wdl wdl = smaller_.Probe(pieces, n, to_move == Color::kWhite);
+    if (wdl == Wdl::kUnknown) {
+      throw std::logic_error("no bitbase for a successor of " +
+                             table_->name_);
+    }
+    return wdl;
+  }
+
+  // Settles the position if it is illegal, over or won by leaving the
+  // endgame, and otherwise counts its moves.
+  void Initialize(size_t side, uint64_t index, std::vector<uint64_t>* out) {
+    size_t squares[kMaxPieces];
+    table_->Squares(index, squares);
+    const Color us = side == 0 ? Color::kWhite : Color::kBlack;
+    const uint64_t occupied = Occupied(squares);
+    bool overlap = false;
+    for (size_t i = 0; i < table_->pieces_; i++) {
+      overlap = overlap || PieceAt(squares, squares[i]) != i;
+    }
+    if (overlap || InCheck(squares, Other(us))) {
+      state_[side][index].store(kIllegal, std::memory_order_relaxed);
+      return;
+    }
+    size_t moves = 0;
+    bool legal = false;
+    bool won = false;
+    bool drawn = false;
+    const auto exit = [&](size_t* after, size_t captured, size_t promoted) {
+      if (InCheck(after, us, captured)) {
+        return;
+      }
+      legal = true;
+      const Wdl wdl = Exit(after, captured, promoted, Other(us));
+      won = won || wdl == Wdl::kLoss;
+      drawn = drawn || wdl == Wdl::kDraw;
+    };
+    const auto quiet = [&](size_t* after) {
+      if (!InCheck(after, us)) {
+        legal = true;
+        moves++;
+      }
+    };
+    for (size_t i = 0; i < table_->pieces_; i++) {
+      if (table_->colors_[i] != us) {
+        continue;
+      }
+      size_t after[kMaxPieces];
+      std::copy(squares, squares + kMaxPieces, after);
+      const size_t from = squares[i];
+      if (table_->types_[i] == PieceType::kPawn) {
+        const size_t last = us == Color::kWhite ? 7 : 0;
+        for (const Step& step : rules_.pushes_[side][from]) {
+          if (occupied & (Bit(step.to_) | step.between_)) {
+            continue;
+          }
+          after[i] = step.to_;
+          if (step.to_ / 8 == last) {
+            exit(after, kMaxPieces, i);
+          } else {
+            quiet(after);
+          }
+        }
+        for (const Step& step : rules_.captures_[side][from]) {
+          const size_t victim = PieceAt(squares, step.to_);
+          if (victim == kMaxPieces || table_->colors_[victim] == us) {
+            continue;
+          }
+          after[i] = step.to_;
+          exit(after, victim, step.to_ / 8 == last ? i : kMaxPieces);
+        }
+        after[i] = from;
+        continue;
+      }
+      for (const Step& step :
+           rules_.moves_[static_cast<size_t>(table_->types_[i])][from]) {
+        if (occupied & step.between_) {
+          continue;
+        }
+        const size_t victim = PieceAt(squares, step.to_);
+        if (victim != kMaxPieces && table_->colors_[victim] == us) {
+          continue;
+        }
+        after[i] = step.to_;
+        if (victim != kMaxPieces) {
+          exit(after, victim, kMaxPieces);
+        } else {
+          quiet(after);
+        }
+      }
+    }
+
+    uint8_t state = kPending;
+    if (!legal) {
+      state = InCheck(squares, us) ? kLost : kDrawn;
+    } else if (won) {
+      state = kWon;
+    } else if (moves == 0 && !drawn) {
+      state = kLost;
+    }
+    // A move out of the endgame that draws keeps the count above zero.
+    moves_left_[side][index].store(static_cast<uint8_t>(moves + drawn),
+                                   std::memory_order_relaxed);
+    state_[side][index].store(state, std::memory_order_relaxed);
+    if (state == kWon || state == kLost) {
+      out->push_back(index * 2 + side);
+    }
+  }
+
+  auto PieceAt(const size_t* squares, size_t square) const -> size_t {
+    for (size_t i = 0; i < table_->pieces_; i++) {
+      if (squares[i] == square) {
+        return i;
+      }
+    }
+    return kMaxPieces;
+  }
+
+  // Unmakes every move that could have led to the settled position and
+  // settles the positions they lead back to where it can.
+  void Unmake(uint64_t entry, std::vector<uint64_t>* out) {
+    const size_t side = entry % 2;
+    const uint64_t index = entry / 2;
+    const bool lost =
+        state_[side][index].load(std::memory_order_relaxed) == kLost;
+    size_t squares[kMaxPieces];
+    table_->Squares(index, squares);
+    const uint64_t occupied = Occupied(squares);
+    // The player who moved.
+    const size_t them = 1 - side;
+    const Color mover = them == 0 ? Color::kWhite : Color::kBlack;
+    for (size_t i = 0; i < table_->pieces_; i++) {
+      if (table_->colors_[i] != mover) {
+        continue;
+      }
+      const std::vector<Step>& steps =
+          table_->types_[i] == PieceType::kPawn
+              ? rules_.unpushes_[them][squares[i]]
+              : rules_.moves_[static_cast<size_t>(table_->types_[i])]
+                             [squares[i]];
+      for (const Step& step : steps) {
+        if (occupied & (Bit(step.to_) | step.between_)) {
+          continue;
+        }
+        size_t before[kMaxPieces];
+        std::copy(squares, squares + kMaxPieces, before);
+        before[i] = step.to_;
+        uint64_t previous;
+        if (InCheck(before, Other(mover)) ||
+            !table_->Index(before, &previous)) {
+          continue;
+        }
+        Settle(them, previous, lost, out);
+      }
+    }
+  }
+
+  // A move from the position leads to a lost position, if lost, or to a
+  // won one.
+  void Settle(size_t side, uint64_t index, bool lost,
+              std::vector<uint64_t>* out) {
+    std::atomic<uint8_t>& state = state_[side][index];
+    if (state.load(std::memory_order_relaxed) != kPending) {
+      return;
+    }
+    uint8_t pending = kPending;
+    if (lost) {
+      if (state.compare_exchange_strong(pending, kWon,
+                                        std::memory_order_relaxed)) {
+        out->push_back(index * 2 + side);
+      }
+    } else if (moves_left_[side][index].fetch_sub(
+                   1, std::memory_order_relaxed) == 1 &&
+               state.compare_exchange_strong(pending, kLost,
+                                             std::memory_order_relaxed)) {
+      out->push_back(index * 2 + side);
+    }
+  }
+
+  // Writes the outcomes into the table, two bits each.
+  void Pack() {
+    const uint64_t n = table_->positions_;
+    const size_t side_bytes = static_cast<size_t>((n + 3) / 4);
+    table_->owned_.assign(kHeaderBytes + 2 * side_bytes, 0);
+    uint8_t* header = table_->owned_.data();
+    char name[kNameBytes] = {};
+    std::copy(table_->name_.begin(), table_->name_.end(), name);
+    std::memcpy(header, &kMagic, sizeof(kMagic));
+    std::memcpy(header + 4, &kVersion, sizeof(kVersion));
+    std::memcpy(header + 8, name, kNameBytes);
+    std::memcpy(header + 8 + kNameBytes, &n, sizeof(n));
+    for (size_t side = 0; side < 2; side++) {
+      uint8_t* bits = header + kHeaderBytes + side * side_bytes;
+      Counts& counts = table_->counts_[side];
+      for (uint64_t i = 0; i < n; i++) {
+        const uint8_t state = state_[side][i].load(std::memory_order_relaxed);
+        Wdl wdl = Wdl::kDraw;
+        if (state == kWon) {
+          wdl = Wdl::kWin;
+          counts.wins_++;
+        } else if (state == kLost) {
+          wdl = Wdl::kLoss;
+          counts.losses_++;
+        } else if (state != kIllegal) {
+          counts.draws_++;
+        }
+        bits[i / 4] = static_cast<uint8_t>(
+            bits[i / 4] | static_cast<uint8_t>(wdl) << (2 * (i % 4)));
+      }
+    }
+    table_->data_ = table_->owned_.data();
+    table_->size_ = table_->owned_.size();
+  }
+};
+
+void Bitbase::SetPieces(const std::string& name) {
+  name_ = name;
+  std::string white;
+  std::string black;
+  SplitName(name, &white, &black);
+  pieces_ = 0;
+  types_[pieces_] = PieceType::kKing;
+  colors_[pieces_++] = Color::kWhite;
+  types_[pieces_] = PieceType::kKing;
+  colors_[pieces_++] = Color::kBlack;
+  for (const char c : white) {
+    types_[pieces_] = TypeOf(c);
+    colors_[pieces_++] = Color::kWhite;
+  }
+  for (const char c : black) {
+    types_[pieces_] = TypeOf(c);
+    colors_[pieces_++] = Color::kBlack;
+  }
+  pawns_ = name.find('P') != std::string::npos;
+  positions_ = pawns_ ? 32 : 16;
+  for (size_t i = 1; i < pieces_; i++) {
+    positions_ *= types_[i] == PieceType::kPawn ? 48 : 64;
+  }
+}
+
+auto Bitbase::Index(const size_t* squares, uint64_t* index) const -> bool {
+  // Mirror the board so the white king stands on the a-d files, and on
+  // ranks 1-4 unless pawns make up and down differ.
+  size_t flip = squares[0] % 8 > 3 ? 7 : 0;
+  if (!pawns_ && squares[0] / 8 > 3) {
+    flip |= 56;
+  }
+  const size_t king = squares[0] ^ flip;
+  uint64_t i = king % 8 + 4 * (king / 8);
+  for (size_t p = 1; p < pieces_; p++) {
+    const size_t sq = squares[p] ^ flip;
+    if (types_[p] == PieceType::kPawn) {
+      if (sq < 8 || sq >= 56) {
+        return false;
+      }
+      i = i * 48 + sq - 8;
+    } else {
+      i = i * 64 + sq;
+    }
+  }
+  *index = i;
+  return true;
+}
+
+void Bitbase::Squares(uint64_t index, size_t* squares) const {
+  for (size_t p = pieces_; p-- > 1;) {
+    if (types_[p] == PieceType::kPawn) {
+      squares[p] = static_cast<size_t>(index % 48) + 8;
+      index /= 48;
+    } else {
+      squares[p] = static_cast<size_t>(index % 64);
+      index /= 64;
+    }
+  }
+  squares[0] = static_cast<size_t>(index % 4 + 8 * (index / 4));
+}
+
+auto Bitbase::Probe(const size_t* squares, bool white_to_move) const -> Wdl {
+  uint64_t index;
+  if (!Index(squares, &index)) {
+    return Wdl::kUnknown;
+  }
+  const size_t side_bytes = static_cast<size_t>((positions_ + 3) / 4);
+  const uint8_t byte = data_[kHeaderBytes + (white_to_move ? 0 : side_bytes) +
+                             index / 4];
+  return static_cast<Wdl>((byte >> (2 * (index % 4))) & 3);
+}
+
+auto Bitbase::Load(const std::string& path) -> std::unique_ptr<Bitbase> {
+  std::unique_ptr<Bitbase> table(new Bitbase());
+#if defined(__unix__) || defined(__APPLE__)
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("can't open bitbase file " + path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderBytes) {
+    close(fd);
+    throw std::runtime_error(path + " is not a bitbase");
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error("can't map bitbase file " + path);
+  }
+  table->data_ = static_cast<const uint8_t*>(data);
+  table->mapped_ = true;
+#else
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw std::runtime_error("can't open bitbase file " + path);
+  }
+  const size_t size = static_cast<size_t>(in.tellg());
+  table->owned_.resize(size);
+  in.seekg(0);
+  in.read(reinterpret_cast<char*>(table->owned_.data()),
+          static_cast<std::streamsize>(size));
+  if (!in || size < kHeaderBytes) {
+    throw std::runtime_error(path + " is not a bitbase");
+  }
+  table->data_ = table->owned_.data();
+#endif
+  table->size_ = size;
+
+  uint32_t magic;
+  uint32_t version;
+  char name[kNameBytes + 1] = {};
+  uint64_t positions;
+  std::memcpy(&magic, table->data_, sizeof(magic));
+  std::memcpy(&version, table->data_ + 4, sizeof(version));
+  std::memcpy(name, table->data_ + 8, kNameBytes);
+  std::memcpy(&positions, table->data_ + 8 + kNameBytes, sizeof(positions));
+  bool valid = magic == kMagic && version == kVersion;
+  if (valid) {
+    try {
+      valid = CanonicalName(name) == name;
+    } catch (const std::invalid_argument&) {
+      valid = false;
+    }
+  }
+  if (valid) {
+    table->SetPieces(name);
+    valid = positions == table->positions_ &&
+            size == kHeaderBytes + 2 * ((positions + 3) / 4);
+  }
+  if (!valid) {
+    throw std::runtime_error(path + " is not a bitbase");
+  }
+  return table;
+}
+
+Bitbase::~Bitbase() {
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapped_) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+#endif
+}
+
+void Bitbase::Write(const std::string& path) const {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(data_),
+            static_cast<std::streamsize>(size_));
+  if (!out) {
+    throw std::runtime_error("can't write bitbase file " + path);
+  }
+}
+
+void Tables::Generate(const std::string& name, pool::ThreadPool* pool,
+                      std::vector<Report>* reports) {
+  const std::string canonical = CanonicalName(name);
+  if (canonical.size() <= 2 || Find(canonical)) {
+    return;
+  }
+  for (const std::string& next : Successors(canonical)) {
+    Generate(next, pool, reports);
+  }
+  CHESS_TRACE_SCOPE("bitbase::Tables::Generate");
+  const auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<Bitbase> table(new Bitbase());
+  table->SetPieces(canonical);
+  const size_t rounds = Generator(table.get(), *this, pool).Run();
+  if (reports) {
+    Report report;
+    report.name_ = canonical;
+    report.positions_ = table->positions_;
+    report.rounds_ = rounds;
+    report.seconds_ = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    reports->push_back(report);
+  }
+  tables_[canonical] = std::move(table);
+}
+
+auto Tables::Load(const std::string& directory) -> size_t {
+  // Every endgame of up to kMaxPieces pieces: each side's pieces after the
+  // king as a string in name order.
+  std::vector<std::string> sides = {""};
+  for (size_t extra = 0; extra + 2 < kMaxPieces; extra++) {
+    const size_t n = sides.size();
+    for (size_t i = 0; i < n; i++) {
+      for (const char c : std::string(kOrder)) {
+        if (sides[i].size() == extra &&
+            (sides[i].empty() || !ByOrder(c, sides[i].back()))) {
+          sides.push_back(sides[i] + c);
+        }
+      }
+    }
+  }
+  size_t loaded = 0;
+  for (const std::string& white : sides) {
+    for (const std::string& black : sides) {
+      const std::string name = "K" + white + "K" + black;
+      if (name.size() <= 2 || name.size() > kMaxPieces ||
+          CanonicalName(name) != name) {
+        continue;
+      }
+      const std::string path = directory + "/" + name + ".bb";
+      if (!std::ifstream(path)) {
+        continue;
+      }
+      tables_[name] = Bitbase::Load(path);
+      loaded++;
+    }
+  }
+  return loaded;
+}
+
+void Tables::Write(const std::string& directory) const {
+  for (const auto& entry : tables_) {
+    entry.second->Write(directory + "/" + entry.first + ".bb");
+  }
+}
+
+auto Tables::Find(const std::string& name) const -> const Bitbase* {
+  const auto it = tables_.find(name);
+  return it == tables_.end() ? nullptr : it->second.get();
+}
+
+auto Tables::Probe(const PieceOn* pieces, size_t n, bool white_to_move) const
+    -> Wdl {
+  if (n > kMaxPieces) {
+    return Wdl::kUnknown;
+  }
+  std::string sides[2];
+  size_t kings[2] = {0, 0};
+  for (size_t i = 0; i < n; i++) {
+    if (pieces[i].type_ == PieceType::kKing) {
+      kings[Side(pieces[i].color_)]++;
+    } else {
+      sides[Side(pieces[i].color_)] += Letter(pieces[i].type_);
+    }
+  }
+  if (kings[0] != 1 || kings[1] != 1) {
+    return Wdl::kUnknown;
+  }
+  if (n == 2) {
+    return Wdl::kDraw;
+  }
+  std::sort(sides[0].begin(), sides[0].end(), ByOrder);
+  std::sort(sides[1].begin(), sides[1].end(), ByOrder);
+  // With the colors reversed, Black's pieces play as White's, mirrored.
+  bool reversed = false;
+  const Bitbase* table = Find("K" + sides[0] + "K" + sides[1]);
+  if (!table) {
+    table = Find("K" + sides[1] + "K" + sides[0]);
+    reversed = true;
+  }
+  if (!table) {
+    return Wdl::kUnknown;
+  }
+  const size_t flip = reversed ? 56 : 0;
+  size_t squares[kMaxPieces];
+  for (size_t p = 0; p < table->pieces_; p++) {
+    const Color color = reversed ? Other(table->colors_[p]) : table->colors_[p];
+    // The nth piece of the kind in the table takes the nth on the board.
+    size_t nth = 0;
+    for (size_t q = 0; q < p; q++) {
+      nth += table->types_[q] == table->types_[p] &&
+             table->colors_[q] == table->colors_[p];
+    }
+    for (size_t i = 0; i < n; i++) {
+      if (pieces[i].type_ == table->types_[p] && pieces[i].color_ == color &&
+          nth-- == 0) {
+        squares[p] = pieces[i].square_ ^ flip;
+        break;
+      }
+    }
+  }
+  return table->Probe(squares, reversed ? !white_to_move : white_to_move);
+}
+
+auto Tables::Probe(const game::Game& game) const -> Wdl {
+  if (game.white_->numPieces_ + game.black_->numPieces_ > kMaxPieces ||
+      game.CastlingRights() != 0) {
+    return Wdl::kUnknown;
+  }
+  // A pawn that just moved two squares may be taken en passant by a pawn
+  // beside it.
+  if (!game.moves_.empty()) {
+    const game::Move& last = game.moves_.back();
+    const piece::Piece* moved = last.to_ ? last.to_->piece_ : nullptr;
+    if (moved && moved->type_ == PieceType::kPawn &&
+        std::max(last.from_->y_, last.to_->y_) -
+                std::min(last.from_->y_, last.to_->y_) == 2) {
+      for (const size_t x : {last.to_->x_ - 1, last.to_->x_ + 1}) {
+        const piece::Piece* beside =
+            x < board::kSize ? game.board_->At(x, last.to_->y_)->piece_
+                             : nullptr;
+        if (beside && beside->type_ == PieceType::kPawn &&
+            beside->color_ != moved->color_) {
+          return Wdl::kUnknown;
+        }
+      }
+    }
+  }
+  PieceOn pieces[kMaxPieces];
+  size_t n = 0;
+  for (size_t sq = 0; sq < 64; sq++) {
+    const piece::Piece* p = game.board_->At(sq % 8, sq / 8)->piece_;
+    if (p) {
+      if (n == kMaxPieces) {
+        return Wdl::kUnknown;
+      }
+      pieces[n++] = {p->type_, p->color_, sq};
+    }
+  }
+  return Probe(pieces, n, game.turn_->color_ == Color::kWhite);
+}
+
+}  // namespace bitbase
@@ -5,6 +5,7 @@
 #include <chess/piece.h>
 
 #include <ostream>
+#include <stdexcept>
 
 using piece::Bishop;
 using piece::King;
@@ -17,15 +18,32 @@ using std::get;
 
 namespace board {
 
+namespace {
+
+// Returns the type of the piece denoted by a FEN letter of either case.
+auto FenPieceType(const char c) -> piece::PieceType {
+  switch (tolower(c)) {
+    case 'p':
+      return piece::PieceType::kPawn;
+    case 'n':
+      return piece::PieceType::kKnight;
+    case 'b':
+      return piece::PieceType::kBishop;
+    case 'r':
+      return piece::PieceType::kRook;
+    case 'q':
+      return piece::PieceType::kQueen;
+    default:
+      return piece::PieceType::kKing;
+  }
+}
+
+}  // namespace
+
 Square::Square(const size_t x, const size_t y) {
   assert(x < kSize && y < kSize);
   x_ = x;
   y_ = y;
-  if ((x + y) % 2 == 0) {
-    sq_color_ = white;
-  } else {
-    sq_color_ = green;
-  }
   piece_ = nullptr;
 }
 Square::~Square() { delete piece_; }
@@ -33,30 +51,10 @@ Square::~Square() { delete piece_; }
 Square::Square(const Square& other) {
   x_ = other.x_;
   y_ = other.y_;
-  sq_color_ = other.sq_color_;
   if (other.piece_ == nullptr) {
     piece_ = nullptr;
   } else {
-    switch (other.piece_->type_) {
-      case piece::PieceType::kPawn:
-        piece_ = new Pawn(other.piece_->color_);
-        return;
-      case piece::PieceType::kKnight:
-        piece_ = new Knight(other.piece_->color_);
-        return;
-      case piece::PieceType::kBishop:
-        piece_ = new Bishop(other.piece_->color_);
-        return;
-      case piece::PieceType::kRook:
-        piece_ = new Rook(other.piece_->color_);
-        return;
-      case piece::PieceType::kKing:
-        piece_ = new King(other.piece_->color_);
-        return;
-      case piece::PieceType::kQueen:
-        piece_ = new King(other.piece_->color_);
-        return;
-    };
+    piece_ = piece::MakePiece(other.piece_->type_, other.piece_->color_);
   }
 }
 
@@ -66,31 +64,13 @@ Square& Square::operator=(const Square& other) {
   }
   x_ = other.x_;
   y_ = other.y_;
-  sq_color_ = other.sq_color_;
   delete piece_;
   if (other.piece_ == nullptr) {
     piece_ = nullptr;
+  } else {
+    piece_ = piece::MakePiece(other.piece_->type_, other.piece_->color_);
   }
-  switch (other.piece_->type_) {
-    case piece::PieceType::kPawn:
-      piece_ = new Pawn(other.piece_->color_);
-      return *this;
-    case piece::PieceType::kKnight:
-      piece_ = new Knight(other.piece_->color_);
-      return *this;
-    case piece::PieceType::kBishop:
-      piece_ = new Bishop(other.piece_->color_);
-      return *this;
-    case piece::PieceType::kRook:
-      piece_ = new Rook(other.piece_->color_);
-      return *this;
-    case piece::PieceType::kKing:
-      piece_ = new King(other.piece_->color_);
-      return *this;
-    case piece::PieceType::kQueen:
-      piece_ = new King(other.piece_->color_);
-      return *this;
-  };
+  return *this;
 }
 bool Square::IsEmpty() const { return piece_ == nullptr; }
 
@@ -98,11 +78,6 @@ Square::Square(size_t x, size_t y, Piece* p) {
   assert(x < kSize && y < kSize);
   x_ = x;
   y_ = y;
-  if ((x + y) % 2 == 0) {
-    sq_color_ = white;
-  } else {
-    sq_color_ = green;
-  }
   piece_ = p;
 }
 
@@ -145,6 +120,46 @@ Board::Board() {
     grid_[row * kSize + i] = new Square(i, row, new piece::Pawn(c));
   }
 }
+Board::Board(const std::string& placement) {
+  // Validate the whole placement before allocating any squares so that a
+  // malformed string does not leak.
+  char layout[kSize * kSize] = {};
+  // FEN lists the ranks from the black side (row 7) down to row 0.
+  size_t x = 0;
+  size_t y = kSize - 1;
+  for (const char c : placement) {
+    if (c == '/') {
+      if (x != kSize || y == 0) {
+        throw std::invalid_argument("bad FEN placement: " + placement);
+      }
+      x = 0;
+      y--;
+    } else if (c >= '1' && c <= '8') {
+      x += c - '0';
+    } else if (std::string("pnbrqkPNBRQK").find(c) != std::string::npos &&
+               x < kSize) {
+      layout[y * kSize + x] = c;
+      x++;
+    } else {
+      throw std::invalid_argument("bad FEN placement: " + placement);
+    }
+    if (x > kSize) {
+      throw std::invalid_argument("bad FEN placement: " + placement);
+    }
+  }
+  if (x != kSize || y != 0) {
+    throw std::invalid_argument("bad FEN placement: " + placement);
+  }
+  for (size_t i = 0; i < kSize * kSize; i++) {
+    grid_[i] = new Square(i % kSize, i / kSize);
+    if (layout[i] == '\0') {
+      continue;
+    }
+    piece::Color c =
+        isupper(layout[i]) ? piece::Color::kWhite : piece::Color::kBlack;
+    grid_[i]->piece_ = piece::MakePiece(FenPieceType(layout[i]), c);
+  }
+}
 Board::~Board() {
   for (int i = 0; i < kSize * kSize; i++) {
     delete grid_[i];
@@ -0,0 +1,400 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/bookmaker.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include "chess/trace.h"
+
+namespace bookmaker {
+
+namespace {
+
+// Shards are picked by the top bits of the position key, so all the moves
+// of a position share one.
+const size_t kShardBits = 6;
+// What a count costs in an unordered_map: the node, its allocation and a
+// bucket.
+const uint64_t kBytesPerCount = 72;
+// A count as stored in a run file: key, move, wins, draws, losses.
+const size_t kRecordBytes = 8 + 2 + 3 * 4;
+// Records read from each run file at a time while merging.
+const size_t kReadBuffer = 4096;
+
+auto Less(const Count& a, const Count& b) -> bool {
+  return a.key_ != b.key_ ? a.key_ < b.key_ : a.move_ < b.move_;
+}
+
+void Accumulate(const Score& from, Score* to) {
+  to->wins_ += from.wins_;
+  to->draws_ += from.draws_;
+  to->losses_ += from.losses_;
+}
+
+void Pack(const Count& c, char* p) {
+  std::memcpy(p, &c.key_, 8);
+  std::memcpy(p + 8, &c.move_, 2);
+  std::memcpy(p + 10, &c.score_.wins_, 4);
+  std::memcpy(p + 14, &c.score_.draws_, 4);
+  std::memcpy(p + 18, &c.score_.losses_, 4);
+}
+
+void Unpack(const char* p, Count* c) {
+  std::memcpy(&c->key_, p, 8);
+  std::memcpy(&c->move_, p + 8, 2);
+  std::memcpy(&c->score_.wins_, p + 10, 4);
+  std::memcpy(&c->score_.draws_, p + 14, 4);
+  std::memcpy(&c->score_.losses_, p + 18, 4);
+}
+
+// Reads a run file's counts in order, a buffer at a time.
+class RunReader {
+ public:
+  explicit RunReader(const std::string& path)
+      : in_(path, std::ios::binary), path_(path), next_(0), size_(0) {
+    if (!in_) {
+      throw std::runtime_error("can't read run file " + path);
+    }
+  }
+  auto Next(Count* c) -> bool {
+    if (next_ == size_) {
+      in_.read(buffer_.data(),
+               static_cast<std::streamsize>(buffer_.size()));
+      const size_t read = static_cast<size_t>(in_.gcount());
+      if (read % kRecordBytes != 0) {
+        throw std::runtime_error("truncated run file " + path_);
+      }
+      next_ = 0;
+      size_ = read / kRecordBytes;
+      if (size_ == 0) {
+        return false;
+      }
+    }
+    Unpack(buffer_.data() + next_++ * kRecordBytes, c);
+    return true;
+  }
+
+ private:
+  std::ifstream in_;
+  std::string path_;
+  std::vector<char> buffer_ = std::vector<char>(kReadBuffer * kRecordBytes);
+  size_t next_;
+  size_t size_;
+};
+
+// Writes counts to a run file, a buffer at a time.
+class RunWriter {
+ public:
+  explicit RunWriter(const std::string& path)
+      : out_(path, std::ios::binary | std::ios::trunc), path_(path) {
+    if (!out_) {
+      throw std::runtime_error("can't write run file " + path);
+    }
+  }
+  void Add(const Count& c) {
+    if (buffer_.size() == kReadBuffer * kRecordBytes) {
+      WriteBuffer();
+    }
+    buffer_.resize(buffer_.size() + kRecordBytes);
+    Pack(c, &buffer_[buffer_.size() - kRecordBytes]);
+  }
+  void Close() {
+    WriteBuffer();
+    out_.close();
+    if (!out_) {
+      throw std::runtime_error("can't write run file " + path_);
+    }
+  }
+
+ private:
+  std::ofstream out_;
+  std::string path_;
+  std::vector<char> buffer_;
+  void WriteBuffer() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+  }
+};
+
+// Merges sorted run files into one sorted sequence of counts, taking the
+// least of the runs' next counts each time.
+void Merge(const std::vector<std::string>& runs,
+           const std::function<void(const Count&)>& sink) {
+  std::vector<std::unique_ptr<RunReader>> readers;
+  using Head = std::pair<Count, size_t>;
+  auto later = [](const Head& a, const Head& b) {
+    return Less(b.first, a.first);
+  };
+  std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+  for (const std::string& run : runs) {
+    readers.emplace_back(new RunReader(run));
+    Count c;
+    if (readers.back()->Next(&c)) {
+      heads.push({c, readers.size() - 1});
+    }
+  }
+  while (!heads.empty()) {
+    const Head head = heads.top();
+    heads.pop();
+    sink(head.first);
+    Count c;
+    if (readers[head.second]->Next(&c)) {
+      heads.push({c, head.second});
+    }
+  }
+}
+
+// Turns counts, in key and move order, into book entries a position at a
+// time.
+class Emitter {
+ public:
+  Emitter(polyglot::Writer* writer, uint32_t min_games)
+      : writer_(writer), min_games_(min_games), entries_(0) {}
+  void Add(const Count& c) {
+    if (!moves_.empty() && moves_.back().key_ == c.key_ &&
+        moves_.back().move_ == c.move_) {
+      Accumulate(c.score_, &moves_.back().score_);
+      return;
+    }
+    if (!moves_.empty() && moves_.back().key_ != c.key_) {
+      Flush();
+    }
+    moves_.push_back(c);
+  }
+  void Flush() {
+    uint64_t best = 0;
+    std::vector<std::pair<uint16_t, uint64_t>> kept;
+    for (const Count& c : moves_) {
+      const Score& s = c.score_;
+      const uint64_t games =
+          static_cast<uint64_t>(s.wins_) + s.draws_ + s.losses_;
+      if (games < min_games_) {
+        continue;
+      }
+      const uint64_t half_points =
+          2 * static_cast<uint64_t>(s.wins_) + s.draws_;
+      kept.emplace_back(c.move_, half_points);
+      best = std::max(best, half_points);
+    }
+    for (const auto& m : kept) {
+      const uint64_t weight =
+          best > 0xFFFF ? m.second * 0xFFFF / best : m.second;
+      writer_->Add({moves_.front().key_, m.first,
+                    static_cast<uint16_t>(weight), 0});
+      entries_++;
+    }
+    moves_.clear();
+  }
+  auto Entries() const -> uint64_t { return entries_; }
+
+ private:
+  polyglot::Writer* writer_;
+  uint32_t min_games_;
+  uint64_t entries_;
+  std::vector<Count> moves_;
+};
+
+}  // namespace
+
+Builder::Builder(const Options& options)
+    : options_(options),
+      in_memory_(0),
+      next_run_(0),
+      spills_(0),
+      limit_(std::max<uint64_t>(
+          1, (static_cast<uint64_t>(options.memory_mb_) << 20) /
+                 kBytesPerCount)) {
+  for (size_t i = 0; i < (size_t{1} << kShardBits); i++) {
+    shards_.emplace_back(new Shard());
+  }
+}
+
+Builder::~Builder() {
+  for (const std::string& run : runs_) {
+    std::remove(run.c_str());
+  }
+}
+
+void Builder::Add(const pgn::Record& record) {
+  const std::string& result = record.result_;
+  const auto setup = record.tags_.find("SetUp");
+  if (record.tags_.count("FEN") ||
+      (setup != record.tags_.end() && setup->second == "1") ||
+      (result != "1-0" && result != "0-1" && result != "1/2-1/2")) {
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    report_.skipped_++;
+    return;
+  }
+  game::Game game(0);
+  uint64_t moves = 0;
+  bool truncated = false;
+  for (size_t ply = 0; ply < record.moves_.size() && ply < options_.max_plies_;
+       ply++) {
+    game::Move m;
+    if (!pgn::ParseSan(&game, record.moves_[ply], &m)) {
+      truncated = true;
+      break;
+    }
+    const bool white = game.turn_ == game.white_;
+    Score score;
+    if (result == "1/2-1/2") {
+      score.draws_ = 1;
+    } else if ((result == "1-0") == white) {
+      score.wins_ = 1;
+    } else {
+      score.losses_ = 1;
+    }
+    Tally(polyglot::Key(game), polyglot::Encode(m), score);
+    game.PlayTurn(m);
+    moves++;
+  }
+  std::lock_guard<std::mutex> lock(report_mutex_);
+  report_.games_++;
+  report_.truncated_ += truncated ? 1 : 0;
+  report_.moves_ += moves;
+}
+
+void Builder::Tally(uint64_t key, uint16_t move, const Score& score) {
+  Shard& shard = *shards_[key >> (64 - kShardBits)];
+  uint64_t in_memory = 0;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    const auto inserted = shard.counts_.emplace(Slot{key, move}, score);
+    if (!inserted.second) {
+      Accumulate(score, &inserted.first->second);
+      return;
+    }
+    // Counted under the shard's lock, so a drain never takes a count
+    // before it's added.
+    in_memory = in_memory_.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  if (in_memory > limit_) {
+    // One thread spills while the others go on counting.
+    std::unique_lock<std::mutex> lock(spill_mutex_, std::try_to_lock);
+    if (lock.owns_lock() &&
+        in_memory_.load(std::memory_order_relaxed) > limit_) {
+      Spill();
+    }
+  }
+}
+
+void Builder::Read(std::istream* in, pool::ThreadPool* pool) {
+  CHESS_TRACE_SCOPE("bookmaker::Builder::Read");
+  pgn::Reader reader(in);
+  pool::TaskGroup group(pool);
+  const size_t max_queued = 2 * pool->Size();
+  size_t queued = 0;
+  bool more = true;
+  while (more) {
+    auto batch = std::make_shared<std::vector<pgn::Record>>(
+        std::max<size_t>(options_.batch_, 1));
+    size_t n = 0;
+    while (n < batch->size() && (more = reader.Next(&(*batch)[n]))) {
+      n++;
+    }
+    if (n == 0) {
+      break;
+    }
+    batch->resize(n);
+    group.Run([this, batch] {
+      for (const pgn::Record& record : *batch) {
+        Add(record);
+      }
+    });
+    // Parsing runs ahead of replaying; bound the games held meanwhile.
+    if (++queued == max_queued) {
+      group.Wait();
+      queued = 0;
+    }
+  }
+  group.Wait();
+}
+
+auto Builder::Drain() -> std::vector<Count> {
+  std::vector<Count> counts;
+  counts.reserve(in_memory_.load(std::memory_order_relaxed));
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    std::unordered_map<Slot, Score, SlotHash> taken;
+    {
+      std::lock_guard<std::mutex> lock(shard->mutex_);
+      taken.swap(shard->counts_);
+    }
+    in_memory_.fetch_sub(taken.size(), std::memory_order_relaxed);
+    for (const auto& entry : taken) {
+      counts.push_back({entry.first.key_, entry.first.move_, entry.second});
+    }
+  }
+  std::sort(counts.begin(), counts.end(), Less);
+  return counts;
+}
+
+auto Builder::NewRun() -> std::string {
+  const std::string path =
+      options_.temp_dir_ + "/book-" +
+      std::to_string(reinterpret_cast<uintptr_t>(this)) + "-" +
+      std::to_string(next_run_++) + ".run";
+  runs_.push_back(path);
+  return path;
+}
+
+void Builder::Spill() {
+  CHESS_TRACE_SCOPE("bookmaker::Builder::Spill");
+  const std::vector<Count> counts = Drain();
+  if (counts.empty()) {
+    return;
+  }
+  RunWriter out(NewRun());
+  for (const Count& c : counts) {
+    out.Add(c);
+  }
+  out.Close();
+  spills_++;
+}
+
+auto Builder::Write(const std::string& path) -> Report {
+  CHESS_TRACE_SCOPE("bookmaker::Builder::Write");
+  std::lock_guard<std::mutex> lock(spill_mutex_);
+  polyglot::Writer writer(path);
+  Emitter emitter(&writer, options_.min_games_);
+  if (runs_.empty()) {
+    for (const Count& c : Drain()) {
+      emitter.Add(c);
+    }
+  } else {
+    // The counts still in memory become the last run. Runs are merged
+    // fan_in_ at a time into longer ones until one merge can take them
+    // all, so only so many files are open at once.
+    Spill();
+    const size_t fan_in = std::max<size_t>(options_.fan_in_, 2);
+    while (runs_.size() > fan_in) {
+      const std::vector<std::string> merged(
+          runs_.begin(), runs_.begin() + static_cast<ptrdiff_t>(fan_in));
+      runs_.erase(runs_.begin(),
+                  runs_.begin() + static_cast<ptrdiff_t>(fan_in));
+      RunWriter out(NewRun());
+      Merge(merged, [&out](const Count& c) { out.Add(c); });
+      out.Close();
+      for (const std::string& run : merged) {
+        std::remove(run.c_str());
+      }
+    }
+    Merge(runs_, [&emitter](const Count& c) { emitter.Add(c); });
+  }
+  emitter.Flush();
+  writer.Close();
+  std::lock_guard<std::mutex> report_lock(report_mutex_);
+  Report report = report_;
+  report.runs_ = spills_;
+  report.entries_ = emitter.Entries();
+  return report;
+}
+
+}  // namespace bookmaker
@@ -0,0 +1,725 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+#include "chess/trace.h"
+
+namespace engine {
+
+using game::Game;
+using game::Move;
+
+namespace {
+
+// Larger than any score the search can return.
+const int kInfinity = kMateScore + 1;
+
+// Mate scores are stored relative to the node rather than the root, so that
+// they stay correct when the position is reached at another ply.
+auto ToTable(int score, size_t ply) -> int16_t {
+  if (score > kMateScore - static_cast<int>(kMaxPly)) {
+    score += static_cast<int>(ply);
+  } else if (score < -kMateScore + static_cast<int>(kMaxPly)) {
+    score -= static_cast<int>(ply);
+  }
+  return static_cast<int16_t>(score);
+}
+
+auto FromTable(int score, size_t ply) -> int {
+  if (score > kMateScore - static_cast<int>(kMaxPly)) {
+    return score - static_cast<int>(ply);
+  } else if (score < -kMateScore + static_cast<int>(kMaxPly)) {
+    return score + static_cast<int>(ply);
+  }
+  return score;
+}
+
+// True if a pawn is on the board. Pawn endgame bitbases promote to queens,
+// which the game can't, so their wins may not be wins in it.
+auto HasPawns(const game::Game& game) -> bool {
+  for (size_t sq = 0; sq < board::kSize * board::kSize; sq++) {
+    const piece::Piece* p =
+        game.board_->At(sq % board::kSize, sq / board::kSize)->piece_;
+    if (p && p->type_ == piece::PieceType::kPawn) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Which iterations each helper thread skips: helper i skips depth d when
+// ((d + kSkipPhase[j]) / kSkipSize[j]) is odd, where j = (i - 1) % 20. Half
+// of the helpers search every other depth, and so on, so that the threads
+// spread over neighbouring depths instead of all searching the same one.
+const size_t kSkipSize[] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                            3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+const size_t kSkipPhase[] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                             4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// Pruning margins in centipawns. Futility and reverse futility apply up to
+// kFutilityDepth plies from the leaves, razoring up to kRazoringDepth.
+const size_t kFutilityDepth = 3;
+const int kFutilityMargin[kFutilityDepth + 1] = {0, 200, 300, 500};
+const int kReverseFutilityMargin = 120;
+const size_t kRazoringDepth = 2;
+const int kRazoringMargin = 300;
+// Iterations from this depth on search an aspiration window.
+const size_t kAspirationDepth = 4;
+
+// The late move reduction for the move searched i-th at the depth, growing
+// with the logarithm of both.
+auto Reduction(size_t depth, size_t i) -> size_t {
+  static const struct Table {
+    Table() {
+      for (size_t d = 1; d < kMaxPly; d++) {
+        for (size_t m = 1; m < kMaxPly; m++) {
+          value_[d][m] = static_cast<size_t>(
+              0.75 + std::log(static_cast<double>(d)) *
+                         std::log(static_cast<double>(m)) / 2.25);
+        }
+      }
+    }
+    size_t value_[kMaxPly][kMaxPly] = {};
+  } table;
+  return table.value_[std::min(depth, kMaxPly - 1)][std::min(i, kMaxPly - 1)];
+}
+
+// True if the player to move has a piece other than pawns and the king,
+// without which null-move pruning is unsafe: zugzwang is then common.
+auto HasPieces(const Game& game) -> bool {
+  for (size_t x = 0; x < board::kSize; x++) {
+    for (size_t y = 0; y < board::kSize; y++) {
+      const piece::Piece* p = game.board_->At(x, y)->piece_;
+      if (p && p->color_ == game.turn_->color_ &&
+          p->type_ != piece::PieceType::kPawn &&
+          p->type_ != piece::PieceType::kKing) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+auto SkipDepth(size_t helper, size_t depth) -> bool {
+  if (helper == 0) {
+    return false;
+  }
+  const size_t j = (helper - 1) % 20;
+  return ((depth + kSkipPhase[j]) / kSkipSize[j]) % 2 != 0;
+}
+
+}  // namespace
+
+auto Evaluate(const Game& game) -> int {
+  const int score = eval::Blend(game.psq_, game.phase_);
+  return game.turn_ == game.white_ ? score : -score;
+}
+
+Searcher::Searcher(const Game& game, tt::Table* table,
+                   const Options& options)
+    : parent_(nullptr), helper_(0), game_(game), table_(table), stop_(false),
+      options_(options), pv_length_(), root_pieces_(0), bitbase_hits_(0) {
+  if (options_.network_) {
+    accumulators_.resize(kMaxPly);
+  }
+}
+
+void Searcher::Stop() { stop_.store(true, std::memory_order_relaxed); }
+
+auto Searcher::Stats() const -> stats::SearchStats {
+  return counters_.Snapshot();
+}
+
+void Searcher::ReportStats() {
+  limits_.on_stats_(parent_ ? parent_->Stats() : Stats());
+  next_report_ = std::chrono::steady_clock::now() +
+                 std::chrono::milliseconds(limits_.stats_interval_ms_);
+}
+
+auto Searcher::Search(const Limits& limits) -> Result {
+  CHESS_TRACE_SCOPE("Searcher::Search");
+  const auto start = std::chrono::steady_clock::now();
+  limits_ = limits;
+  counters_.Start();
+  next_report_ = std::chrono::steady_clock::now() +
+                 std::chrono::milliseconds(limits.stats_interval_ms_);
+  pawn_table_.probes_ = 0;
+  pawn_table_.hits_ = 0;
+  root_pieces_ = game_.white_->numPieces_ + game_.black_->numPieces_;
+  bitbase_hits_ = 0;
+  last_pv_.clear();
+  heuristics_.Clear();
+  // A ParallelSearcher resets its helpers before starting their threads,
+  // so that stopping them can't race with the reset.
+  if (helper_ == 0) {
+    stop_.store(false, std::memory_order_relaxed);
+  }
+  time_.reset();
+  if (limits.move_time_ms_ > 0) {
+    time_.reset(new timeman::TimeManager(
+        timeman::TimeManager::FixedTime(limits.move_time_ms_)));
+  } else if (limits.clock_.time_ms_ > 0) {
+    time_.reset(new timeman::TimeManager(limits.clock_));
+  }
+  // Helpers share the table with the main thread, which starts the search.
+  if (table_ && helper_ == 0) {
+    table_->NewSearch();
+  }
+
+  // A line found by the last completed iteration.
+  struct RootLine {
+    std::vector<Move> moves_;
+    int score_;
+  };
+  std::vector<RootLine> lines;
+  const std::vector<Move> root_moves = game_.LegalMoves(game_.turn_);
+  const size_t num_lines =
+      std::max<size_t>(std::min(options_.multi_pv_, root_moves.size()), 1);
+  Result result;
+  const size_t max_depth = std::min(std::max<size_t>(limits.depth_, 1),
+                                    kMaxPly - 1);
+  for (size_t depth = 1; depth <= max_depth; depth++) {
+    if (depth > 1 && SkipDepth(helper_, depth)) {
+      continue;
+    }
+    std::vector<RootLine> found;
+    // The score of the first line, or of the game's end without moves.
+    int first_score = 0;
+    excluded_root_.clear();
+    for (size_t i = 0; i < num_lines; i++) {
+      // Each line starts from its own previous principal variation and
+      // score, or the worst line's when it is new.
+      last_pv_.clear();
+      int previous_score = 0;
+      if (!lines.empty()) {
+        const RootLine& previous = lines[std::min(i, lines.size() - 1)];
+        last_pv_ = previous.moves_;
+        previous_score = previous.score_;
+      }
+      const int score = SearchRoot(depth, previous_score);
+      if (i == 0) {
+        first_score = score;
+      }
+      if (stop_.load(std::memory_order_relaxed)) {
+        // An interrupted first iteration still needs a move to play: the
+        // best root move found so far, or else the first legal one. Its
+        // score is unknown.
+        if (depth == 1 && found.empty()) {
+          if (pv_length_[0] > 0) {
+            found.push_back({{pv_[0], pv_[0] + pv_length_[0]}, 0});
+          } else if (!root_moves.empty()) {
+            found.push_back({{root_moves[0]}, 0});
+          }
+          first_score = 0;
+        }
+        break;
+      }
+      if (pv_length_[0] == 0) {
+        break;
+      }
+      found.push_back({{pv_[0], pv_[0] + pv_length_[0]}, score});
+      excluded_root_.push_back(movepick::Pack(pv_[0][0]));
+    }
+    excluded_root_.clear();
+    // An interrupted iteration is discarded, except the first, which keeps
+    // the lines it completed or its fallback, reported at depth 0.
+    const bool interrupted = stop_.load(std::memory_order_relaxed);
+    if (interrupted && depth > 1) {
+      break;
+    }
+    // Aspiration windows can leave a later line scoring above an earlier
+    // one.
+    std::stable_sort(found.begin(), found.end(),
+                     [](const RootLine& a, const RootLine& b) {
+                       return a.score_ > b.score_;
+                     });
+    lines = found;
+    last_pv_ = lines.empty() ? std::vector<Move>() : lines[0].moves_;
+    if (!interrupted) {
+      counters_.CompleteIteration(depth);
+    }
+    if (limits_.on_stats_) {
+      ReportStats();
+    }
+    result.score_ = lines.empty() ? first_score : lines[0].score_;
+    result.depth_ = interrupted ? 0 : depth;
+    result.pv_.clear();
+    for (const Move& m : last_pv_) {
+      std::stringstream move;
+      move << m;
+      result.pv_.push_back(move.str());
+    }
+    result.lines_.clear();
+    for (const RootLine& line : lines) {
+      result.lines_.emplace_back();
+      result.lines_.back().score_ = line.score_;
+      for (const Move& m : line.moves_) {
+        result.lines_.back().pv_.push_back(game::ToUci(m));
+      }
+    }
+    if (limits_.on_iteration_) {
+      result.nodes_ = counters_.Nodes();
+      limits_.on_iteration_(result);
+    }
+    // No point searching deeper once a mate has been found or the game has
+    // ended, nor starting an iteration that won't finish in time.
+    const int score = result.score_;
+    if (stop_.load(std::memory_order_relaxed) || last_pv_.empty() ||
+        std::abs(score) >= kMateScore - static_cast<int>(depth) ||
+        (time_ && !time_->StartIteration(movepick::Pack(last_pv_[0])))) {
+      break;
+    }
+  }
+
+  counters_.Finish();
+  result.stats_ = counters_.Snapshot();
+  result.nodes_ = result.stats_.nodes_;
+  result.quiescence_nodes_ = result.stats_.quiescence_nodes_;
+  result.pawn_probes_ = pawn_table_.probes_;
+  result.pawn_hits_ = pawn_table_.hits_;
+  result.bitbase_hits_ = bitbase_hits_;
+  result.cutoffs_ = result.stats_.Cutoffs();
+  result.first_move_cutoffs_ = result.stats_.cutoffs_[0];
+  result.seconds_ = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  if (result.seconds_ > 0) {
+    result.nps_ = static_cast<uint64_t>(
+        static_cast<double>(result.nodes_) / result.seconds_);
+  }
+  return result;
+}
+
+void Searcher::Accumulate(size_t ply) {
+  if (!options_.network_) {
+    return;
+  }
+  // Entering a node, its parent's accumulator is always up to date.
+  if (ply == 0) {
+    options_.network_->Refresh(game_, &accumulators_[0]);
+  } else {
+    options_.network_->Update(game_, accumulators_[ply - 1],
+                              &accumulators_[ply]);
+  }
+}
+
+auto Searcher::StaticEval(size_t ply) -> int {
+  if (options_.network_) {
+    return options_.network_->Evaluate(accumulators_[ply],
+                                       game_.turn_->color_);
+  }
+  if (!options_.pawn_structure_) {
+    return Evaluate(game_);
+  }
+  eval::Score score = game_.psq_;
+  score += pawns::Evaluate(game_, &pawn_table_);
+  const int blended = eval::Blend(score, game_.phase_);
+  return game_.turn_ == game_.white_ ? blended : -blended;
+}
+
+auto Searcher::SearchRoot(size_t depth, int previous) -> int {
+  if (!options_.aspiration_ || depth < kAspirationDepth) {
+    return Negamax(-kInfinity, kInfinity, depth, 0);
+  }
+  // Search a window around the previous iteration's score, widening it on
+  // the side that fails until the score falls inside.
+  int delta = options_.aspiration_window_;
+  int alpha = std::max(previous - delta, -kInfinity);
+  int beta = std::min(previous + delta, kInfinity);
+  while (true) {
+    const int score = Negamax(alpha, beta, depth, 0);
+    if (stop_.load(std::memory_order_relaxed) ||
+        (score > alpha && score < beta)) {
+      return score;
+    }
+    delta *= 2;
+    if (score <= alpha) {
+      alpha = std::max(score - delta, -kInfinity);
+    } else {
+      beta = std::min(score + delta, kInfinity);
+    }
+  }
+}
+
+auto Searcher::CountNode() -> bool {
+  counters_.CountNode();
+  const uint64_t nodes = counters_.Nodes();
+  if ((limits_.nodes_ != 0 && nodes >= limits_.nodes_) ||
+      (time_ && nodes % kTimeCheckNodes == 0 &&
+       time_->HardLimitReached())) {
+    stop_.store(true, std::memory_order_relaxed);
+  }
+  if (limits_.on_stats_ && nodes % kTimeCheckNodes == 0 &&
+      std::chrono::steady_clock::now() >= next_report_) {
+    ReportStats();
+  }
+  return stop_.load(std::memory_order_relaxed);
+}
+
+auto Searcher::Negamax(int alpha, int beta, size_t depth, size_t ply,
+                       bool allow_null) -> int {
+  if (depth == 0 && options_.quiescence_) {
+    return Quiesce(alpha, beta, ply);
+  }
+  pv_length_[ply] = 0;
+  if (CountNode()) {
+    return 0;
+  }
+  Accumulate(ply);
+
+  if (depth == 0 || ply + 1 >= kMaxPly) {
+    return StaticEval(ply);
+  }
+  const int original_alpha = alpha;
+  uint16_t tt_move = 0;
+  tt::Entry entry;
+  const bool hit = table_ && table_->Probe(game_.key_, &entry);
+  if (table_) {
+    counters_.CountProbe(hit);
+  }
+  if (hit) {
+    const tt::SearchValue stored = tt::UnpackSearch(entry.value_);
+    tt_move = stored.move_;
+    // The root always searches, so that there is a principal variation.
+    if (ply > 0 && entry.depth_ >= depth) {
+      const int score = FromTable(stored.score_, ply);
+      if (entry.bound_ == tt::Bound::kExact ||
+          (entry.bound_ == tt::Bound::kLower && score >= beta) ||
+          (entry.bound_ == tt::Bound::kUpper && score <= alpha)) {
+        return score;
+      }
+    }
+  }
+
+  // A capture into an endgame the bitbases hold settles it.
+  // Endgames already on the board at the root are searched as usual, so
+  // that the search makes progress towards mate.
+  const size_t pieces = game_.white_->numPieces_ + game_.black_->numPieces_;
+  if (options_.bitbases_ && ply > 0 && pieces < root_pieces_ &&
+      pieces <= bitbase::kMaxPieces && !HasPawns(game_)) {
+    const bitbase::Wdl wdl = options_.bitbases_->Probe(game_);
+    if (wdl != bitbase::Wdl::kUnknown) {
+      bitbase_hits_++;
+      const int win = kKnownWin - static_cast<int>(ply);
+      return wdl == bitbase::Wdl::kWin ? win
+             : wdl == bitbase::Wdl::kLoss ? -win
+                                          : 0;
+    }
+  }
+
+  // Selective pruning only applies away from the principal variation, out
+  // of check, and never at the root.
+  const bool in_check = game_.turn_->IsKingInCheck();
+  const bool pv_node = beta - alpha > 1;
+  const bool prune = !pv_node && !in_check && ply > 0;
+  const int static_eval = in_check ? -kInfinity : StaticEval(ply);
+
+  // Reverse futility pruning: so far above beta that no move is likely to
+  // bring the score back down within a few plies.
+  if (prune && options_.reverse_futility_ && depth <= kFutilityDepth &&
+      static_eval - kReverseFutilityMargin * static_cast<int>(depth) >=
+          beta &&
+      std::abs(beta) < kMateScore - static_cast<int>(kMaxPly)) {
+    return static_eval;
+  }
+
+  // Razoring: so far below alpha that only a capture could help, so drop
+  // into quiescence search and believe it if it fails low too.
+  if (prune && options_.razoring_ && depth <= kRazoringDepth &&
+      static_eval + kRazoringMargin * static_cast<int>(depth) < alpha) {
+    const int score = options_.quiescence_ ? Quiesce(alpha - 1, alpha, ply)
+                                           : static_eval;
+    if (score < alpha) {
+      return score;
+    }
+  }
+
+  // Null-move pruning: if passing still scores at least beta after a
+  // reduced search, a real move almost certainly would too. Zugzwang breaks
+  // this, so it is skipped with only pawns left and, deep enough, the
+  // cutoff is verified by a reduced search of the position itself.
+  if (prune && allow_null && options_.null_move_ && depth >= 3 &&
+      static_eval >= beta && !LastMoveWasNull() && HasPieces(game_)) {
+    const size_t reduction = 3 + depth / 6;
+    const size_t null_depth = depth > reduction + 1 ? depth - 1 - reduction
+                                                    : 0;
+    game_.PlayNullMove();
+    int score = -Negamax(-beta, -beta + 1, null_depth, ply + 1);
+    game_.UndoTurn();
+    if (stop_.load(std::memory_order_relaxed)) {
+      return 0;
+    }
+    const bool cutoff =
+        score >= beta &&
+        (depth < options_.null_move_verify_depth_ ||
+         Negamax(beta - 1, beta, null_depth, ply, false) >= beta);
+    counters_.CountNullMove(cutoff);
+    if (cutoff) {
+      // A mate found after passing is no proof of a mate.
+      return score >= kMateScore - static_cast<int>(kMaxPly) ? beta : score;
+    }
+  }
+
+  std::vector<Move> moves = game_.LegalMoves(game_.turn_);
+  if (moves.empty()) {
+    // Checkmate or stalemate.
+    return in_check ? -kMateScore + static_cast<int>(ply) : 0;
+  }
+  if (ply == 0 && !excluded_root_.empty()) {
+    moves.erase(std::remove_if(moves.begin(), moves.end(),
+                               [this](const Move& m) {
+                                 return std::find(excluded_root_.begin(),
+                                                  excluded_root_.end(),
+                                                  movepick::Pack(m)) !=
+                                        excluded_root_.end();
+                               }),
+                moves.end());
+  }
+  // The table's move first, or without one the previous iteration's best
+  // line. At the root the line comes first: in a multi-PV search the
+  // table's move may belong to a better line.
+  const uint16_t hash_move =
+      (tt_move != 0 && ply > 0) || ply >= last_pv_.size()
+          ? tt_move
+          : movepick::Pack(last_pv_[ply]);
+  movepick::MovePicker picker(game_, moves, hash_move, heuristics_, ply);
+
+  // Futility pruning: near the leaves, quiet moves can't raise a static
+  // evaluation this far below alpha.
+  const bool futile =
+      prune && options_.futility_ && depth <= kFutilityDepth &&
+      static_eval + kFutilityMargin[depth] <= alpha;
+
+  int best = -kInfinity;
+  Move best_move = Move();
+  Move m;
+  // The quiet moves searched so far, whose history a quiet cutoff lowers.
+  std::vector<Move> quiets_tried;
+  for (size_t i = 0; picker.Next(&m); i++) {
+    const bool quiet = !movepick::IsCapture(m);
+    game_.PlayTurn(m);
+    const bool gives_check = game_.turn_->IsKingInCheck();
+    if (futile && quiet && i > 0 && !gives_check) {
+      game_.UndoTurn();
+      best = std::max(best, static_eval + kFutilityMargin[depth]);
+      continue;
+    }
+    // Late move reductions: quiet moves ordered late are unlikely to be
+    // best, so they are searched shallower unless they prove otherwise.
+    size_t reduction = 0;
+    if (options_.lmr_ && depth >= 3 && i >= 3 && quiet && !in_check &&
+        !gives_check) {
+      reduction = std::min(Reduction(depth, i) + (pv_node ? 0 : 1),
+                           depth - 2);
+    }
+    int score;
+    if (i == 0) {
+      score = -Negamax(-beta, -alpha, depth - 1, ply + 1);
+    } else {
+      // Prove the move is no better than the first with a null window and
+      // only search it fully if that fails.
+      score = -Negamax(-alpha - 1, -alpha, depth - 1 - reduction, ply + 1);
+      if (reduction > 0 && score > alpha) {
+        score = -Negamax(-alpha - 1, -alpha, depth - 1, ply + 1);
+      }
+      if (score > alpha && score < beta) {
+        score = -Negamax(-beta, -alpha, depth - 1, ply + 1);
+      }
+    }
+    game_.UndoTurn();
+    if (stop_.load(std::memory_order_relaxed)) {
+      return 0;
+    }
+    if (score > best) {
+      best = score;
+      best_move = m;
+      if (score > alpha) {
+        alpha = score;
+        pv_[ply][0] = m;
+        std::copy(pv_[ply + 1], pv_[ply + 1] + pv_length_[ply + 1],
+                  pv_[ply] + 1);
+        pv_length_[ply] = pv_length_[ply + 1] + 1;
+      }
+      if (alpha >= beta) {
+        counters_.CountCutoff(i);
+        if (quiet) {
+          heuristics_.UpdateQuiet(game_, m, quiets_tried, depth, ply);
+        }
+        break;
+      }
+    }
+    if (quiet) {
+      quiets_tried.push_back(m);
+    }
+  }
+  // A root searched without some of its moves has no true score to store.
+  if (table_ && (ply > 0 || excluded_root_.empty())) {
+    tt::SearchValue stored;
+    stored.move_ = movepick::Pack(best_move);
+    stored.score_ = ToTable(best, ply);
+    entry.value_ = tt::PackSearch(stored);
+    entry.depth_ = static_cast<uint8_t>(depth);
+    entry.bound_ = best <= original_alpha ? tt::Bound::kUpper
+                   : best >= beta         ? tt::Bound::kLower
+                                          : tt::Bound::kExact;
+    table_->Store(game_.key_, entry);
+  }
+  return best;
+}
+
+auto Searcher::LastMoveWasNull() const -> bool {
+  return !game_.moves_.empty() && !game_.moves_.back().from_;
+}
+
+auto Searcher::Quiesce(int alpha, int beta, size_t ply) -> int {
+  pv_length_[ply] = 0;
+  counters_.CountQuiescenceNode();
+  if (CountNode()) {
+    return 0;
+  }
+  Accumulate(ply);
+  const bool in_check = game_.turn_->IsKingInCheck();
+  if (ply + 1 >= kMaxPly) {
+    return StaticEval(ply);
+  }
+
+  // In check every evasion is searched, as standing pat is no option.
+  int best = -kInfinity;
+  int stand_pat = -kInfinity;
+  std::vector<Move> moves;
+  if (in_check) {
+    moves = game_.LegalMoves(game_.turn_);
+    if (moves.empty()) {
+      return -kMateScore + static_cast<int>(ply);
+    }
+  } else {
+    stand_pat = StaticEval(ply);
+    if (stand_pat >= beta) {
+      return stand_pat;
+    }
+    best = stand_pat;
+    alpha = std::max(alpha, stand_pat);
+    moves = game_.LegalCaptures(game_.turn_);
+  }
+
+  // Out of check the picker drops captures that lose material.
+  movepick::MovePicker picker =
+      in_check ? movepick::MovePicker(game_, moves, 0, heuristics_, ply)
+               : movepick::MovePicker(game_, moves, heuristics_);
+  Move m;
+  while (picker.Next(&m)) {
+    game_.PlayTurn(m);
+    // Delta pruning: not even winning the piece would reach alpha. Checks
+    // are kept, as they may lead to mate. The capture could still be worth
+    // up to its optimistic value, so the score returned can't be lower.
+    const int optimistic =
+        stand_pat + movepick::VictimValue(m) + options_.delta_margin_;
+    if (!in_check && options_.delta_margin_ > 0 && optimistic <= alpha &&
+        !game_.turn_->IsKingInCheck()) {
+      game_.UndoTurn();
+      best = std::max(best, optimistic);
+      continue;
+    }
+    const int score = -Quiesce(-beta, -alpha, ply + 1);
+    game_.UndoTurn();
+    if (stop_.load(std::memory_order_relaxed)) {
+      return 0;
+    }
+    if (score > best) {
+      best = score;
+      if (score > alpha) {
+        alpha = score;
+        if (alpha >= beta) {
+          break;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+ParallelSearcher::ParallelSearcher(const Game& game, size_t threads,
+                                   tt::Table* table, const Options& options) {
+  for (size_t i = 0; i < std::max<size_t>(threads, 1); i++) {
+    searchers_.emplace_back(new Searcher(game, table, options));
+    searchers_.back()->helper_ = i;
+    searchers_.back()->parent_ = this;
+  }
+}
+
+auto ParallelSearcher::Search(const Limits& limits) -> Result {
+  CHESS_TRACE_SCOPE("ParallelSearcher::Search");
+  // Helpers search without limits until the main thread is done.
+  Limits helper_limits;
+  helper_limits.depth_ = limits.depth_;
+  std::vector<Result> results(searchers_.size());
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < searchers_.size(); i++) {
+    searchers_[i]->stop_.store(false, std::memory_order_relaxed);
+  }
+  for (size_t i = 1; i < searchers_.size(); i++) {
+    helpers.emplace_back([this, i, &helper_limits, &results] {
+      const numa::Topology* topology = searchers_[i]->options_.topology_;
+      if (topology) {
+        numa::PinThread(topology->CpuFor(i));
+      }
+      results[i] = searchers_[i]->Search(helper_limits);
+    });
+  }
+  results[0] = searchers_[0]->Search(limits);
+  for (size_t i = 1; i < searchers_.size(); i++) {
+    searchers_[i]->Stop();
+  }
+  for (std::thread& helper : helpers) {
+    helper.join();
+  }
+
+  Result result = results[0];
+  uint64_t pawn_probes = 0;
+  uint64_t pawn_hits = 0;
+  uint64_t bitbase_hits = 0;
+  for (const Result& r : results) {
+    pawn_probes += r.pawn_probes_;
+    pawn_hits += r.pawn_hits_;
+    bitbase_hits += r.bitbase_hits_;
+    if (r.depth_ > result.depth_ && !r.pv_.empty()) {
+      result = r;
+    }
+  }
+  result.stats_ = Stats();
+  result.nodes_ = result.stats_.nodes_;
+  result.quiescence_nodes_ = result.stats_.quiescence_nodes_;
+  result.pawn_probes_ = pawn_probes;
+  result.pawn_hits_ = pawn_hits;
+  result.bitbase_hits_ = bitbase_hits;
+  result.cutoffs_ = result.stats_.Cutoffs();
+  result.first_move_cutoffs_ = result.stats_.cutoffs_[0];
+  result.seconds_ = results[0].seconds_;
+  if (result.seconds_ > 0) {
+    result.nps_ = static_cast<uint64_t>(
+        static_cast<double>(result.nodes_) / result.seconds_);
+  }
+  return result;
+}
+
+auto ParallelSearcher::Stats() const -> stats::SearchStats {
+  stats::SearchStats total = searchers_[0]->Stats();
+  for (size_t i = 1; i < searchers_.size(); i++) {
+    total.Add(searchers_[i]->Stats());
+  }
+  return total;
+}
+
+void ParallelSearcher::Stop() {
+  for (const std::unique_ptr<Searcher>& searcher : searchers_) {
+    searcher->Stop();
+  }
+}
+
+}  // namespace engine
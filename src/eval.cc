@@ -0,0 +1,161 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/eval.h"
+
+namespace eval {
+
+namespace {
+
+// Tables are written from White's point of view with the eighth rank on the
+// first row, so that they read like a diagram. The midgame tables are
+// Michniewski's "Simplified Evaluation Function"; in the endgame the king
+// heads for the centre and passed pawns grow in value as they advance.
+const int kPawnMg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0};
+
+const int kPawnEg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0};
+
+const int kKnight[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50};
+
+const int kBishop[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20};
+
+const int kRook[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0};
+
+const int kQueen[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20};
+
+const int kKingMg[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20};
+
+const int kKingEg[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50};
+
+// Midgame and endgame material, indexed by PieceType.
+const Score kMaterial[] = {
+    {0, 0},        // kKing
+    {1025, 936},   // kQueen
+    {477, 512},    // kRook
+    {82, 94},      // kPawn
+    {337, 281},    // kKnight
+    {365, 297},    // kBishop
+};
+
+}  // namespace
+
+auto PieceSquare(piece::PieceType t, piece::Color c, size_t x, size_t y)
+    -> Score {
+  // Black's tables are White's mirrored top to bottom.
+  const size_t row = c == piece::Color::kWhite ? 7 - y : y;
+  const size_t i = row * 8 + x;
+  Score score = kMaterial[static_cast<size_t>(t)];
+  switch (t) {
+    case piece::PieceType::kPawn:
+      score.mg_ += kPawnMg[i];
+      score.eg_ += kPawnEg[i];
+      break;
+    case piece::PieceType::kKnight:
+      score.mg_ += kKnight[i];
+      score.eg_ += kKnight[i];
+      break;
+    case piece::PieceType::kBishop:
+      score.mg_ += kBishop[i];
+      score.eg_ += kBishop[i];
+      break;
+    case piece::PieceType::kRook:
+      score.mg_ += kRook[i];
+      score.eg_ += kRook[i];
+      break;
+    case piece::PieceType::kQueen:
+      score.mg_ += kQueen[i];
+      score.eg_ += kQueen[i];
+      break;
+    case piece::PieceType::kKing:
+      score.mg_ += kKingMg[i];
+      score.eg_ += kKingEg[i];
+      break;
+  }
+  return score;
+}
+
+auto PhaseWeight(piece::PieceType t) -> int {
+  switch (t) {
+    case piece::PieceType::kKnight:
+    case piece::PieceType::kBishop:
+      return 1;
+    case piece::PieceType::kRook:
+      return 2;
+    case piece::PieceType::kQueen:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+auto Blend(const Score& score, int phase) -> int {
+  if (phase > kMaxPhase) {
+    phase = kMaxPhase;
+  }
+  return (score.mg_ * phase + score.eg_ * (kMaxPhase - phase)) / kMaxPhase;
+}
+
+}  // namespace eval
@@ -7,8 +7,13 @@
 #include <assert.h>
 
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
+#include "chess/alloc.h"
 #include "chess/piece.h"
+#include "chess/trace.h"
+#include "chess/zobrist.h"
 
 namespace game {
 
@@ -32,8 +37,8 @@ Player::Player(const piece::Color c, const Square* king) {
 
 auto Player::PlayMove(const Square* from, const Square* to, Game* game)
     -> Move {
-  if (!from || !to || !game) {
-    return {this, nullptr, nullptr, 0, false};
+  if (!from || !from->piece_ || !to || !game) {
+    return {this, nullptr, nullptr, false, 0};
   }
   size_t move_number = game->move_number_;
   if (from->piece_->color_ == piece::Color::kWhite) {
@@ -58,9 +63,81 @@ Game::Game(const int id) {
   moves_ = vector<Move>();
   id_ = id;
   move_number_ = 0;
+  turn_ = white_;
+  key_ = ComputeKey();
+  pawn_key_ = ComputePawnKey();
+  psq_ = ComputePieceSquare();
+  phase_ = ComputePhase();
+}
+
+Game::Game(const std::string& fen, const int id) {
+  std::istringstream in(fen);
+  std::string placement;
+  std::string side;
+  std::string castling = "-";
+  std::string en_passant = "-";
+  size_t halfmove = 0;
+  size_t fullmove = 1;
+  in >> placement >> side >> castling >> en_passant >> halfmove >> fullmove;
+  if (side != "w" && side != "b") {
+    throw std::invalid_argument("bad FEN side to move: " + fen);
+  }
+  board_ = new Board(placement);
+  white_ = new Player(piece::Color::kWhite, nullptr);
+  black_ = new Player(piece::Color::kBlack, nullptr);
+  white_->numPieces_ = 0;
+  black_->numPieces_ = 0;
+  for (size_t j = 0; j < board::kSize; j++) {
+    for (size_t i = 0; i < board::kSize; i++) {
+      const Square* sq = board_->At(i, j);
+      if (sq->IsEmpty()) {
+        continue;
+      }
+      Player* owner = sq->piece_->color_ == piece::Color::kWhite ? white_
+                                                                  : black_;
+      owner->numPieces_++;
+      if (sq->piece_->type_ == piece::PieceType::kKing) {
+        owner->kingSquare_ = sq;
+      }
+    }
+  }
+  if (!white_->kingSquare_ || !black_->kingSquare_) {
+    delete white_;
+    delete black_;
+    delete board_;
+    throw std::invalid_argument("bad FEN, both kings are required: " + fen);
+  }
+  white_->HasKingRookMoved_ = castling.find('K') == std::string::npos;
+  white_->HasQueenRookMoved_ = castling.find('Q') == std::string::npos;
+  black_->HasKingRookMoved_ = castling.find('k') == std::string::npos;
+  black_->HasQueenRookMoved_ = castling.find('q') == std::string::npos;
+  id_ = id;
+  turn_ = side == "w" ? white_ : black_;
+  move_number_ = side == "w" ? fullmove - 1 : fullmove;
+  // The en passant rule is driven by the last move played, so record the
+  // double pawn push that created the en passant square.
+  if (en_passant.size() == 2 && en_passant[0] >= 'a' && en_passant[0] <= 'h') {
+    size_t x = en_passant[0] - 'a';
+    if (turn_ == white_) {
+      moves_.push_back({black_, board_->At(x, 6), board_->At(x, 4), false,
+                        move_number_});
+    } else {
+      moves_.push_back({white_, board_->At(x, 1), board_->At(x, 3), false,
+                        move_number_});
+    }
+  }
+  white_->PiecesChecking_ = GetPiecesChecking(white_->kingSquare_, white_);
+  black_->PiecesChecking_ = GetPiecesChecking(black_->kingSquare_, black_);
+  key_ = ComputeKey();
+  pawn_key_ = ComputePawnKey();
+  psq_ = ComputePieceSquare();
+  phase_ = ComputePhase();
 }
 
 Game::~Game() {
+  for (Undo& undo : undo_) {
+    delete undo.captured_;
+  }
   delete white_;
   delete black_;
   delete board_;
@@ -72,13 +149,22 @@ Game::Game(const Game& other) {
   board_ = new Board(*other.board_);
   id_ = other.id_;
   move_number_ = other.move_number_;
+  key_ = other.key_;
+  pawn_key_ = other.pawn_key_;
+  psq_ = other.psq_;
+  phase_ = other.phase_;
   moves_ = other.moves_;
+  undo_ = other.undo_;
+  RemapCopiedPointers(other);
 }
 
 auto Game::operator=(const Game& other) -> Game& {
   if (&other == this) {
     return *this;
   }
+  for (Undo& undo : undo_) {
+    delete undo.captured_;
+  }
   delete white_;
   delete black_;
   delete board_;
@@ -87,10 +173,49 @@ auto Game::operator=(const Game& other) -> Game& {
   board_ = new Board(*other.board_);
   id_ = other.id_;
   move_number_ = other.move_number_;
+  key_ = other.key_;
+  pawn_key_ = other.pawn_key_;
+  psq_ = other.psq_;
+  phase_ = other.phase_;
   moves_ = other.moves_;
+  undo_ = other.undo_;
+  RemapCopiedPointers(other);
   return *this;
 }
 
+void Game::RemapCopiedPointers(const Game& other) {
+  auto own_square = [this](const Square* s) -> const Square* {
+    return s ? board_->At(s->x_, s->y_) : nullptr;
+  };
+  for (Player* p : {white_, black_}) {
+    p->kingSquare_ = own_square(p->kingSquare_);
+    for (const Square*& s : p->PiecesChecking_) {
+      s = own_square(s);
+    }
+  }
+  for (Move& m : moves_) {
+    m.player_ = m.player_ == other.white_ ? white_ : black_;
+    m.from_ = own_square(m.from_);
+    m.to_ = own_square(m.to_);
+  }
+  // Captured pieces are owned by the undo records, so each copy needs its
+  // own.
+  for (Undo& undo : undo_) {
+    if (undo.captured_) {
+      undo.captured_ =
+          piece::MakePiece(undo.captured_->type_, undo.captured_->color_);
+    }
+    undo.captured_at_ = own_square(undo.captured_at_);
+    for (PlayerState* state : {&undo.white_, &undo.black_}) {
+      state->kingSquare_ = own_square(state->kingSquare_);
+      for (const Square*& sq : state->PiecesChecking_) {
+        sq = own_square(sq);
+      }
+    }
+  }
+  turn_ = other.turn_ == other.white_ ? white_ : black_;
+}
+
 auto Game::CanMove(const Square* from, const Square* to, Player* p) const
     -> bool {
   if (!from || !from->piece_ || !to || !p) {
@@ -126,17 +251,27 @@ auto Game::CanMove(const Square* from, const Square* to, Player* p) const
       if (!from->piece_->CanMove(from->x_, from->y_, to->x_, to->y_)) {
         return false;
       }
-      if (last_move && last_move->from_->x_ == to->x_ &&
-          last_move->to_->y_ == from->y_ &&
-          abs(last_move->from_->y_ - last_move->to_->y_) == 2) {
-        return true;
+      if (from->x_ != to->x_) {
+        // A diagonal pawn move must capture, either the piece on the
+        // destination or, en passant, a pawn that just moved two squares
+        // past it.
+        if (to->piece_) {
+          return true;
+        }
+        return last_move && last_move->from_ && last_move->to_->piece_ &&
+               last_move->to_->piece_->type_ == piece::PieceType::kPawn &&
+               last_move->to_->x_ == to->x_ &&
+               last_move->to_->y_ == from->y_ &&
+               abs(static_cast<int>(last_move->from_->y_) -
+                   static_cast<int>(last_move->to_->y_)) == 2;
       }
-      // if horizontal movement and not en passant return false
-      if (from->x_ != to->x_ && !to->piece_) {
+      // Can't move straight ahead if there is a piece there
+      if (!to->IsEmpty()) {
         return false;
       }
-      // Can't move straight ahead if there is a piece there
-      if (from->x_ - to->x_ == 0 && !to->IsEmpty()) {
+      // Nor jump over a piece when moving two squares.
+      if (abs(static_cast<int>(to->y_) - static_cast<int>(from->y_)) == 2 &&
+          !board_->At(from->x_, (from->y_ + to->y_) / 2)->IsEmpty()) {
         return false;
       }
       return true;
@@ -146,59 +281,58 @@ auto Game::CanMove(const Square* from, const Square* to, Player* p) const
 }
 
 auto Game::PlayTurn(const Move m) -> bool {
-  piece::Piece* from_temp = m.from_->piece_;
-  piece::Piece* to_temp = m.to_->piece_;
-  bool isKingMove;
-  const Square* last_king_square = m.player_->kingSquare_;
-  if (from_temp->type_ == piece::PieceType::kKing) {
-    isKingMove = true;
-  }
-
-  if (m.IsCastling_ && !CanCastle(m.player_, m.to_)) {
-    return false;
-  }
-
-  // try to make the move.
-  board_->Set(m.to_, from_temp);
-  board_->Set(m.from_, nullptr);
-  if (isKingMove) {
-    m.player_->kingSquare_ = m.to_;
-  }
-  // if the king is in check
-  if (!GetPiecesChecking(m.player_->kingSquare_, m.player_).empty()) {
-    // clean up and return false
-    board_->Set(m.to_, to_temp);
-    board_->Set(m.from_, from_temp);
-    if (isKingMove) {
-      m.player_->kingSquare_ = last_king_square;
-    }
+  CHESS_ALLOC_SCOPE("PlayTurn");
+  CHESS_TRACE_SCOPE("Game::PlayTurn");
+  if (!IsLegal(m)) {
     return false;
   }
-  board_->Set(m.to_, to_temp);
-  board_->Set(m.from_, from_temp);
+  // ************* By this point, the move is legal **************
+  piece::Piece* from_temp = m.from_->piece_;
+  Player* opponent = m.player_ == white_ ? black_ : white_;
+  Undo undo;
+  undo.move_number_ = move_number_;
+  undo.key_ = key_;
+  undo.pawn_key_ = pawn_key_;
+  undo.psq_ = psq_;
+  undo.phase_ = phase_;
+  key_ ^= StateKey();
+  SaveState(*white_, &undo.white_);
+  SaveState(*black_, &undo.black_);
 
-  if (!CanMove(m.from_, m.to_, m.player_)) {
-    return false;
+  // Find the captured piece, if any. An en passant capture takes the pawn
+  // which moved last rather than a piece on the destination square.
+  undo.captured_at_ = m.to_;
+  if (!m.IsCastling_ && from_temp->type_ == piece::PieceType::kPawn &&
+      m.from_->x_ != m.to_->x_ && m.to_->IsEmpty()) {
+    undo.captured_at_ = moves_.back().to_;
   }
-
-  // ************* By this point, the move is legal **************
+  undo.captured_ = undo.captured_at_->piece_;
 
   // If the move is by a rook, update the player rook movement vars
-  if (from_temp->type_ == piece::PieceType::kRook) {
+  const size_t home_row = m.player_ == white_ ? 0 : board::kSize - 1;
+  if (from_temp->type_ == piece::PieceType::kRook &&
+      m.from_->y_ == home_row) {
     if (m.from_->x_ == 0) {
       m.player_->HasQueenRookMoved_ = true;
-    } else if (m.from_->y_ == 7) {
+    } else if (m.from_->x_ == board::kSize - 1) {
       m.player_->HasKingRookMoved_ = true;
     }
   }
 
-  // If the move was a capture, update the number of pieces
-  if (to_temp) {
-    if (m.player_->color_ == piece::Color::kWhite) {
-      black_->numPieces_--;
-    } else {
-      white_->numPieces_--;
+  // If the move was a capture, update the number of pieces. Capturing a
+  // rook on its corner also takes away that side's castling.
+  if (undo.captured_) {
+    opponent->numPieces_--;
+    const size_t opponent_row = board::kSize - 1 - home_row;
+    if (undo.captured_->type_ == piece::PieceType::kRook &&
+        m.to_->y_ == opponent_row) {
+      if (m.to_->x_ == 0) {
+        opponent->HasQueenRookMoved_ = true;
+      } else if (m.to_->x_ == board::kSize - 1) {
+        opponent->HasKingRookMoved_ = true;
+      }
     }
+    RemovePiece(undo.captured_at_, &undo.changes_);
   }
 
   // If the player was white, increment the number of moves
@@ -207,41 +341,291 @@ auto Game::PlayTurn(const Move m) -> bool {
   }
 
   if (from_temp->type_ == piece::PieceType::kKing) {
-    m.player_->HasKingRookMoved_ = true;
+    m.player_->HasKingMoved_ = true;
     m.player_->kingSquare_ = m.to_;
   }
 
+  MovePiece(m.from_, m.to_, &undo.changes_);
   if (m.IsCastling_) {
-    if (m.from_->x_ > m.to_->x_) {
-      board_->Set(m.to_, m.from_->piece_);
-      board_->Set(m.from_, nullptr);
-      board_->Set(board_->At(m.to_->x_ + 1, m.from_->y_),
-                  board_->At(0, m.from_->y_)->piece_);
-      board_->Set(board_->At(0, m.from_->y_), nullptr);
-    } else {
-      board_->Set(m.to_, m.from_->piece_);
-      board_->Set(m.from_, nullptr);
-      board_->Set(board_->At(m.to_->x_ - 1, m.from_->y_),
-                  board_->At(board::kSize - 1, m.from_->y_)->piece_);
-      board_->Set(board_->At(board::kSize - 1, m.from_->y_), nullptr);
-    }
-  } else if (m.from_->piece_->type_ == piece::PieceType::kPawn &&
-             m.from_->x_ != m.to_->x_ && m.to_->IsEmpty()) {
-    board_->Set(m.to_, from_temp);
-    board_->Set(m.from_, nullptr);
-    board_->Set(moves_.back().to_, nullptr);
-  } else {
-    board_->Set(m.to_, from_temp);
-    board_->Set(m.from_, nullptr);
+    // Move the rook to the other side of the king.
+    const size_t rook_from = m.from_->x_ > m.to_->x_ ? 0 : board::kSize - 1;
+    const size_t rook_to = m.from_->x_ > m.to_->x_ ? m.to_->x_ + 1
+                                                   : m.to_->x_ - 1;
+    MovePiece(board_->At(rook_from, m.from_->y_),
+              board_->At(rook_to, m.from_->y_), &undo.changes_);
   }
 
   // update player check tracker
   white_->PiecesChecking_ = GetPiecesChecking(white_->kingSquare_, white_);
   black_->PiecesChecking_ = GetPiecesChecking(black_->kingSquare_, black_);
   moves_.emplace_back(m);
+  undo_.push_back(std::move(undo));
+  turn_ = opponent;
+  key_ ^= StateKey();
   return true;
 }
 
+auto Game::UndoTurn() -> bool {
+  if (undo_.empty()) {
+    return false;
+  }
+  const Move m = moves_.back();
+  Undo& undo = undo_.back();
+  if (!m.from_) {
+    // A null move changed nothing but the turn.
+    key_ = undo.key_;
+    turn_ = m.player_;
+    moves_.pop_back();
+    undo_.pop_back();
+    return true;
+  }
+  board_->Set(m.from_, m.to_->piece_);
+  board_->Set(m.to_, nullptr);
+  if (m.IsCastling_) {
+    // Put the rook back in its corner.
+    if (m.from_->x_ > m.to_->x_) {
+      board_->Set(board_->At(0, m.from_->y_),
+                  board_->At(m.to_->x_ + 1, m.from_->y_)->piece_);
+      board_->Set(board_->At(m.to_->x_ + 1, m.from_->y_), nullptr);
+    } else {
+      board_->Set(board_->At(board::kSize - 1, m.from_->y_),
+                  board_->At(m.to_->x_ - 1, m.from_->y_)->piece_);
+      board_->Set(board_->At(m.to_->x_ - 1, m.from_->y_), nullptr);
+    }
+  }
+  if (undo.captured_) {
+    board_->Set(undo.captured_at_, undo.captured_);
+  }
+  RestoreState(&undo.white_, white_);
+  RestoreState(&undo.black_, black_);
+  move_number_ = undo.move_number_;
+  key_ = undo.key_;
+  pawn_key_ = undo.pawn_key_;
+  psq_ = undo.psq_;
+  phase_ = undo.phase_;
+  turn_ = m.player_;
+  moves_.pop_back();
+  undo_.pop_back();
+  return true;
+}
+
+void Game::PlayNullMove() {
+  // The players are untouched, so their saved states stay zeroed.
+  Undo undo = Undo();
+  undo.move_number_ = move_number_;
+  undo.key_ = key_;
+  undo.pawn_key_ = pawn_key_;
+  undo.psq_ = psq_;
+  undo.phase_ = phase_;
+  key_ ^= StateKey();
+  moves_.push_back({turn_, nullptr, nullptr, false, move_number_});
+  undo_.push_back(std::move(undo));
+  turn_ = turn_ == white_ ? black_ : white_;
+  key_ ^= StateKey();
+}
+
+auto Game::Changes(size_t back) const -> const MoveChanges& {
+  return undo_[undo_.size() - 1 - back].changes_;
+}
+
+void Game::PutPiece(piece::Piece* p, const Square* at, MoveChanges* changes) {
+  changes->changes_[changes->size_++] = {p->type_, p->color_,
+                                         at->x_ + board::kSize * at->y_, true};
+  key_ ^= zobrist::PieceKey(p->type_, p->color_, at->x_, at->y_);
+  if (p->type_ == piece::PieceType::kPawn) {
+    pawn_key_ ^= zobrist::PieceKey(p->type_, p->color_, at->x_, at->y_);
+  }
+  if (p->color_ == piece::Color::kWhite) {
+    psq_ += eval::PieceSquare(p->type_, p->color_, at->x_, at->y_);
+  } else {
+    psq_ -= eval::PieceSquare(p->type_, p->color_, at->x_, at->y_);
+  }
+  phase_ += eval::PhaseWeight(p->type_);
+  board_->Set(at, p);
+}
+
+auto Game::RemovePiece(const Square* at, MoveChanges* changes)
+    -> piece::Piece* {
+  piece::Piece* p = at->piece_;
+  changes->changes_[changes->size_++] = {p->type_, p->color_,
+                                         at->x_ + board::kSize * at->y_, false};
+  key_ ^= zobrist::PieceKey(p->type_, p->color_, at->x_, at->y_);
+  if (p->type_ == piece::PieceType::kPawn) {
+    pawn_key_ ^= zobrist::PieceKey(p->type_, p->color_, at->x_, at->y_);
+  }
+  if (p->color_ == piece::Color::kWhite) {
+    psq_ -= eval::PieceSquare(p->type_, p->color_, at->x_, at->y_);
+  } else {
+    psq_ += eval::PieceSquare(p->type_, p->color_, at->x_, at->y_);
+  }
+  phase_ -= eval::PhaseWeight(p->type_);
+  board_->Set(at, nullptr);
+  return p;
+}
+
+void Game::MovePiece(const Square* from, const Square* to,
+                     MoveChanges* changes) {
+  PutPiece(RemovePiece(from, changes), to, changes);
+}
+
+auto Game::ComputePieceSquare() const -> eval::Score {
+  eval::Score score;
+  for (size_t x = 0; x < board::kSize; x++) {
+    for (size_t y = 0; y < board::kSize; y++) {
+      const piece::Piece* p = board_->At(x, y)->piece_;
+      if (!p) {
+        continue;
+      }
+      if (p->color_ == piece::Color::kWhite) {
+        score += eval::PieceSquare(p->type_, p->color_, x, y);
+      } else {
+        score -= eval::PieceSquare(p->type_, p->color_, x, y);
+      }
+    }
+  }
+  return score;
+}
+
+auto Game::ComputePhase() const -> int {
+  int phase = 0;
+  for (size_t x = 0; x < board::kSize; x++) {
+    for (size_t y = 0; y < board::kSize; y++) {
+      const piece::Piece* p = board_->At(x, y)->piece_;
+      if (p) {
+        phase += eval::PhaseWeight(p->type_);
+      }
+    }
+  }
+  return phase;
+}
+
+auto Game::ComputeKey() const -> uint64_t {
+  uint64_t key = 0;
+  for (size_t x = 0; x < board::kSize; x++) {
+    for (size_t y = 0; y < board::kSize; y++) {
+      const piece::Piece* p = board_->At(x, y)->piece_;
+      if (p) {
+        key ^= zobrist::PieceKey(p->type_, p->color_, x, y);
+      }
+    }
+  }
+  return key ^ StateKey();
+}
+
+auto Game::ComputePawnKey() const -> uint64_t {
+  uint64_t key = 0;
+  for (size_t x = 0; x < board::kSize; x++) {
+    for (size_t y = 0; y < board::kSize; y++) {
+      const piece::Piece* p = board_->At(x, y)->piece_;
+      if (p && p->type_ == piece::PieceType::kPawn) {
+        key ^= zobrist::PieceKey(p->type_, p->color_, x, y);
+      }
+    }
+  }
+  return key;
+}
+
+auto Game::CastlingRights() const -> unsigned {
+  unsigned rights = 0;
+  if (!white_->HasKingMoved_) {
+    rights |= white_->HasKingRookMoved_ ? 0 : zobrist::kWhiteKingSide;
+    rights |= white_->HasQueenRookMoved_ ? 0 : zobrist::kWhiteQueenSide;
+  }
+  if (!black_->HasKingMoved_) {
+    rights |= black_->HasKingRookMoved_ ? 0 : zobrist::kBlackKingSide;
+    rights |= black_->HasQueenRookMoved_ ? 0 : zobrist::kBlackQueenSide;
+  }
+  return rights;
+}
+
+auto Game::StateKey() const -> uint64_t {
+  uint64_t key = zobrist::CastlingKey(CastlingRights());
+  if (turn_ == black_) {
+    key ^= zobrist::SideKey();
+  }
+  // The en passant file only counts when a pawn of the player to move could
+  // capture there, so that transpositions are not split needlessly.
+  if (!moves_.empty() && moves_.back().from_) {
+    const Square* to = moves_.back().to_;
+    const piece::Piece* pawn = to->piece_;
+    if (pawn && pawn->type_ == piece::PieceType::kPawn &&
+        abs(static_cast<int>(moves_.back().from_->y_) -
+            static_cast<int>(to->y_)) == 2) {
+      for (int dx : {-1, 1}) {
+        const int x = static_cast<int>(to->x_) + dx;
+        if (x < 0 || x >= static_cast<int>(board::kSize)) {
+          continue;
+        }
+        const piece::Piece* p = board_->At(x, to->y_)->piece_;
+        if (p && p->type_ == piece::PieceType::kPawn &&
+            p->color_ != pawn->color_) {
+          key ^= zobrist::EnPassantKey(to->x_);
+          break;
+        }
+      }
+    }
+  }
+  return key;
+}
+
+void Game::SaveState(Player& p, PlayerState* state) {
+  state->HasKingMoved_ = p.HasKingMoved_;
+  state->HasKingRookMoved_ = p.HasKingRookMoved_;
+  state->HasQueenRookMoved_ = p.HasQueenRookMoved_;
+  state->numPieces_ = p.numPieces_;
+  state->kingSquare_ = p.kingSquare_;
+  // PlayTurn recomputes the checks, so the old vector can be moved out.
+  state->PiecesChecking_ = std::move(p.PiecesChecking_);
+}
+
+void Game::RestoreState(PlayerState* state, Player* p) {
+  p->HasKingMoved_ = state->HasKingMoved_;
+  p->HasKingRookMoved_ = state->HasKingRookMoved_;
+  p->HasQueenRookMoved_ = state->HasQueenRookMoved_;
+  p->numPieces_ = state->numPieces_;
+  p->kingSquare_ = state->kingSquare_;
+  p->PiecesChecking_ = std::move(state->PiecesChecking_);
+}
+
+auto Game::IsLegal(const Move& m) const -> bool {
+  if (!m.player_ || !m.from_ || !m.from_->piece_ || !m.to_ ||
+      m.from_->piece_->color_ != m.player_->color_ ||
+      !CanMove(m.from_, m.to_, m.player_)) {
+    return false;
+  }
+  if (m.IsCastling_ && !CanCastle(m.player_, m.to_)) {
+    return false;
+  }
+  // Try the move and check whether it leaves the king in check.
+  piece::Piece* from_temp = m.from_->piece_;
+  piece::Piece* to_temp = m.to_->piece_;
+  const Square* last_king_square = m.player_->kingSquare_;
+  // An en passant capture also removes the pawn beside the moving pawn.
+  const Square* en_passant = nullptr;
+  piece::Piece* en_passant_temp = nullptr;
+  if (from_temp->type_ == piece::PieceType::kPawn &&
+      m.from_->x_ != m.to_->x_ && !to_temp) {
+    en_passant = moves_.back().to_;
+    en_passant_temp = en_passant->piece_;
+    board_->Set(en_passant, nullptr);
+  }
+  board_->Set(m.to_, from_temp);
+  board_->Set(m.from_, nullptr);
+  if (from_temp->type_ == piece::PieceType::kKing) {
+    m.player_->kingSquare_ = m.to_;
+  }
+  bool in_check =
+      !GetPiecesChecking(m.player_->kingSquare_, m.player_).empty();
+  // Clean up.
+  board_->Set(m.to_, to_temp);
+  board_->Set(m.from_, from_temp);
+  if (en_passant) {
+    board_->Set(en_passant, en_passant_temp);
+  }
+  m.player_->kingSquare_ = last_king_square;
+  return !in_check;
+}
+
 auto Game::CheckPath(const Square* from, const Square* to) const -> bool {
   assert(from != to);
   assert(!from->IsEmpty());
@@ -264,17 +648,13 @@ auto Game::GetPiecesChecking(const Square* at, Player* player) const
   piece::Piece* temp = at->piece_;
   board_->Set(at, nullptr);
   const Square* sq;
-  Player* p = white_;
-  if (p == player) {
-    p = black_;
-  }
   for (size_t j = 0; j < board::kSize; j++) {
     for (size_t i = 0; i < board::kSize; i++) {
       sq = board_->At(i, j);
       if (!sq->piece_ || sq->piece_->color_ == player->color_) {
         continue;
       }
-      if (CanMove(sq, at, p)) {
+      if (Attacks(sq, at)) {
         squares.emplace_back(sq);
       }
     }
@@ -283,6 +663,26 @@ auto Game::GetPiecesChecking(const Square* at, Player* player) const
   return squares;
 }
 
+auto Game::Attacks(const Square* from, const Square* at) const -> bool {
+  const piece::Piece* p = from->piece_;
+  const int dx = static_cast<int>(at->x_) - static_cast<int>(from->x_);
+  const int dy = static_cast<int>(at->y_) - static_cast<int>(from->y_);
+  switch (p->type_) {
+    case piece::PieceType::kPawn:
+      // Pawns only attack one square diagonally forward.
+      return abs(dx) == 1 &&
+             dy == (p->color_ == piece::Color::kWhite ? 1 : -1);
+    case piece::PieceType::kKing:
+      // The king's castling moves are not attacks.
+      return from != at && abs(dx) <= 1 && abs(dy) <= 1;
+    case piece::PieceType::kKnight:
+      return p->CanMove(from->x_, from->y_, at->x_, at->y_);
+    default:
+      return from != at && p->CanMove(from->x_, from->y_, at->x_, at->y_) &&
+             CheckPath(from, at);
+  }
+}
+
 auto Game::GetAllPossibleKingMoves(Player* p) const -> vector<const Square*> {
   vector<const Square*> moves;
   int maxKingMove = 1;
@@ -313,6 +713,8 @@ auto Game::GetAllPossibleKingMoves(Player* p) const -> vector<const Square*> {
 }
 
 auto Game::EvaluateBoard() const -> GameState {
+  CHESS_ALLOC_SCOPE("EvaluateBoard");
+  CHESS_TRACE_SCOPE("Game::EvaluateBoard");
   if (GetAllPossibleKingMoves(white_).empty()) {
     if (white_->IsKingInCheck()) {
       return GameState::kBlackWin;
@@ -335,10 +737,7 @@ auto Game::CanCastle(Player* p, const Square* s) const -> bool {
   if (s->x_ != 2 && s->x_ != 6) {
     return false;
   }
-  bool kingSide;
-  if (s->x_ == 6) {
-    kingSide = true;
-  }
+  bool kingSide = s->x_ == 6;
   size_t row;
   if (p == white_) {
     // If the player is white make sure castling on the back row.
@@ -366,6 +765,15 @@ auto Game::CanCastle(Player* p, const Square* s) const -> bool {
     // Can't castle queenside if the queen rook has moved.
     return false;
   }
+  const Square* corner = board_->At(kingSide ? board::kSize - 1 : 0, row);
+  if (!corner->piece_ || corner->piece_->type_ != piece::PieceType::kRook ||
+      corner->piece_->color_ != p->color_) {
+    // Can't castle without the rook.
+    return false;
+  } else if (!kingSide && !board_->At(1, row)->IsEmpty()) {
+    // The queen rook passes over the b file square.
+    return false;
+  }
   if (kingSide) {
     // Look at every square between the start and end square to see if the
     // king would be in check.
@@ -403,6 +811,56 @@ auto Game::GetMoveFromStr(const std::string str, Player* p) -> Move {
   return p->PlayMove(from, to, this);
 }
 
+auto Game::LegalMoves(Player* p) -> vector<Move> {
+  vector<Move> moves;
+  for (size_t from = 0; from < board::kSize * board::kSize; from++) {
+    const Square* f = board_->At(from % board::kSize, from / board::kSize);
+    if (f->IsEmpty() || f->piece_->color_ != p->color_) {
+      continue;
+    }
+    for (size_t to = 0; to < board::kSize * board::kSize; to++) {
+      const Square* t = board_->At(to % board::kSize, to / board::kSize);
+      // The geometric check is cheap and rules out most squares.
+      if (f == t || !f->piece_->CanMove(f->x_, f->y_, t->x_, t->y_)) {
+        continue;
+      }
+      Move m = p->PlayMove(f, t, this);
+      if (IsLegal(m)) {
+        moves.push_back(m);
+      }
+    }
+  }
+  return moves;
+}
+
+auto Game::LegalCaptures(Player* p) -> vector<Move> {
+  vector<Move> moves;
+  for (size_t from = 0; from < board::kSize * board::kSize; from++) {
+    const Square* f = board_->At(from % board::kSize, from / board::kSize);
+    if (f->IsEmpty() || f->piece_->color_ != p->color_) {
+      continue;
+    }
+    const bool pawn = f->piece_->type_ == piece::PieceType::kPawn;
+    for (size_t to = 0; to < board::kSize * board::kSize; to++) {
+      const Square* t = board_->At(to % board::kSize, to / board::kSize);
+      // Only an enemy piece, or an empty square a pawn moves diagonally to
+      // capture en passant.
+      if (t->IsEmpty() ? !pawn || t->x_ == f->x_
+                       : t->piece_->color_ == p->color_) {
+        continue;
+      }
+      if (!f->piece_->CanMove(f->x_, f->y_, t->x_, t->y_)) {
+        continue;
+      }
+      Move m = p->PlayMove(f, t, this);
+      if (IsLegal(m)) {
+        moves.push_back(m);
+      }
+    }
+  }
+  return moves;
+}
+
 std::ostream& operator<<(std::ostream& os, const Move& move) {
   if (move.from_ == nullptr || move.to_ == nullptr) {
     return os;
@@ -413,4 +871,14 @@ std::ostream& operator<<(std::ostream& os, const Move& move) {
   os << move.to_->y_;
   return os;
 }
+
+auto ToUci(const Move& move) -> std::string {
+  if (move.from_ == nullptr || move.to_ == nullptr) {
+    return "0000";
+  }
+  return {static_cast<char>('a' + move.from_->x_),
+          static_cast<char>('1' + move.from_->y_),
+          static_cast<char>('a' + move.to_->x_),
+          static_cast<char>('1' + move.to_->y_)};
+}
 }  // namespace game
\ No newline at end of file
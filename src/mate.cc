@@ -0,0 +1,273 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/mate.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "chess/trace.h"
+
+namespace mate {
+
+using game::Move;
+
+namespace {
+
+const Numbers kWin = {0, kInfinity};
+const Numbers kLoss = {kInfinity, 0};
+
+// Keeps the table at most this full, in quarters.
+const size_t kMaxLoadQuarters = 3;
+// Lets the child being searched fall this fraction, as a divisor, behind
+// its best sibling before switching to it (the 1 + epsilon trick of
+// Pawlewicz and Lew), so the search switches between siblings less often.
+const uint32_t kEpsilonDivisor = 4;
+// Fewer slots than this cannot hold the path being searched and the
+// siblings along it, and the search would thrash.
+const size_t kMinSlots = 1024;
+
+auto Saturate(uint64_t n) -> uint32_t {
+  return static_cast<uint32_t>(std::min<uint64_t>(n, kInfinity));
+}
+
+}  // namespace
+
+Table::Table(size_t megabytes) : size_(0), collections_(0) {
+  size_t slots = kMinSlots;
+  while (slots * 2 * sizeof(Entry) <= (megabytes << 20)) {
+    slots *= 2;
+  }
+  entries_.resize(slots);
+  Clear();
+}
+
+void Table::Clear() {
+  for (Entry& e : entries_) {
+    e.key_ = 0;
+  }
+  size_ = 0;
+}
+
+auto Table::Slot(uint64_t key) const -> size_t {
+  const size_t mask = entries_.size() - 1;
+  size_t slot = static_cast<size_t>(key) & mask;
+  while (entries_[slot].key_ != 0 && entries_[slot].key_ != key) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+auto Table::Probe(uint64_t key) const -> Numbers {
+  const Entry& e = entries_[Slot(key)];
+  return e.key_ == key ? e.numbers_ : Numbers();
+}
+
+void Table::Store(uint64_t key, const Numbers& numbers, uint64_t work) {
+  Entry& e = entries_[Slot(key)];
+  if (e.key_ == key) {
+    e.numbers_ = numbers;
+    e.work_ += work;
+    return;
+  }
+  e.key_ = key;
+  e.numbers_ = numbers;
+  e.work_ = work;
+  if (++size_ * 4 > entries_.size() * kMaxLoadQuarters) {
+    Collect();
+  }
+}
+
+void Table::Collect() {
+  CHESS_TRACE_SCOPE("mate::Table::Collect");
+  collections_++;
+  std::vector<Entry> kept;
+  kept.reserve(size_);
+  for (const Entry& e : entries_) {
+    if (e.key_ != 0) {
+      kept.push_back(e);
+    }
+  }
+  // Keep the entries that took more work than the median.
+  std::vector<uint64_t> work;
+  work.reserve(kept.size());
+  for (const Entry& e : kept) {
+    work.push_back(e.work_);
+  }
+  const auto median = work.begin() + static_cast<ptrdiff_t>(work.size() / 2);
+  std::nth_element(work.begin(), median, work.end());
+  const uint64_t threshold = *median;
+  Clear();
+  for (const Entry& e : kept) {
+    if (e.work_ > threshold) {
+      entries_[Slot(e.key_)] = e;
+      size_++;
+    }
+  }
+}
+
+Solver::Solver(size_t megabytes)
+    : table_(megabytes), game_(0), nodes_(0), max_nodes_(0) {}
+
+auto Solver::Key(size_t plies) const -> uint64_t {
+  // Numbers depend on the plies left too: a mate in 3 is no mate in 2.
+  const uint64_t key = game_.key_ ^ ((plies + 1) * 0x9E3779B97F4A7C15ULL);
+  return key ? key : 1;
+}
+
+auto Solver::Solve(const game::Game& game, size_t moves, uint64_t max_nodes)
+    -> Result {
+  CHESS_TRACE_SCOPE("mate::Solver::Solve");
+  const auto start = std::chrono::steady_clock::now();
+  game_ = game;
+  nodes_ = 0;
+  max_nodes_ = max_nodes;
+  Result result;
+  if (moves > 0) {
+    const size_t plies = 2 * moves - 1;
+    const Numbers root = Mid(plies, true, kInfinity, kInfinity);
+    result.mate_ = root.phi_ == 0;
+    result.solved_ = root.phi_ == 0 || root.delta_ == 0;
+    if (result.mate_) {
+      // Mate is proven; solving parts of the proof again for its line must
+      // not stop short.
+      max_nodes_ = 0;
+      ProofLine(plies, true, &result.pv_);
+    }
+  }
+  result.nodes_ = nodes_;
+  result.seconds_ = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  result.entries_ = table_.Size();
+  result.collections_ = table_.Collections();
+  return result;
+}
+
+auto Solver::MateIn(const game::Game& game, size_t max_moves,
+                    uint64_t max_nodes, Result* result) -> size_t {
+  Result last;
+  size_t mate = 0;
+  for (size_t moves = 1; moves <= max_moves; moves++) {
+    last = Solve(game, moves, max_nodes);
+    if (last.mate_ || !last.solved_) {
+      mate = last.mate_ ? moves : 0;
+      break;
+    }
+  }
+  if (result) {
+    *result = last;
+  }
+  return mate;
+}
+
+auto Solver::Mid(size_t plies, bool attacker, uint32_t phi_threshold,
+                 uint32_t delta_threshold) -> Numbers {
+  const uint64_t start_nodes = nodes_++;
+  const uint64_t key = Key(plies);
+  Numbers numbers = table_.Probe(key);
+  if (numbers.phi_ >= phi_threshold || numbers.delta_ >= delta_threshold) {
+    return numbers;
+  }
+
+  // The children and their keys. On the attacker's last move only checks
+  // can mate.
+  std::vector<Move> moves = game_.LegalMoves(game_.turn_);
+  const bool in_check = game_.turn_->IsKingInCheck();
+  std::vector<uint64_t> keys;
+  if (plies > 0) {
+    size_t kept = 0;
+    for (const Move& m : moves) {
+      game_.PlayTurn(m);
+      if (!attacker || plies > 1 || game_.turn_->IsKingInCheck()) {
+        keys.push_back(Key(plies - 1));
+        moves[kept++] = m;
+      }
+      game_.UndoTurn();
+    }
+    moves.resize(kept);
+  }
+  if (moves.empty() || plies == 0) {
+    // Out of moves or plies: the attacker has failed to mate, and the
+    // defender has escaped unless mated.
+    numbers = attacker || (moves.empty() && in_check) ? kLoss : kWin;
+    table_.Store(key, numbers, 1);
+    return numbers;
+  }
+
+  // The children's numbers, kept here as well as in the table, which may
+  // drop them while their siblings are searched.
+  std::vector<Numbers> children;
+  children.reserve(keys.size());
+  for (uint64_t child_key : keys) {
+    children.push_back(table_.Probe(child_key));
+  }
+  while (true) {
+    // The player to move succeeds if any child fails for the opponent, and
+    // fails only if every child succeeds.
+    uint64_t delta_sum = 0;
+    uint32_t best_delta = kInfinity;
+    uint32_t second_delta = kInfinity;
+    size_t best = 0;
+    uint32_t best_phi = 0;
+    for (size_t i = 0; i < children.size(); i++) {
+      const Numbers& child = children[i];
+      delta_sum += child.phi_;
+      if (child.delta_ < best_delta) {
+        second_delta = best_delta;
+        best_delta = child.delta_;
+        best_phi = child.phi_;
+        best = i;
+      } else if (child.delta_ < second_delta) {
+        second_delta = child.delta_;
+      }
+    }
+    numbers.phi_ = best_delta;
+    numbers.delta_ = Saturate(delta_sum);
+    if (numbers.phi_ >= phi_threshold || numbers.delta_ >= delta_threshold ||
+        (max_nodes_ != 0 && nodes_ >= max_nodes_)) {
+      break;
+    }
+    // Search the most promising child until it is no longer the most
+    // promising, or its numbers would push this node past a threshold.
+    const uint32_t child_phi_threshold = Saturate(
+        static_cast<uint64_t>(delta_threshold) - numbers.delta_ + best_phi);
+    const uint32_t child_delta_threshold = std::min<uint32_t>(
+        phi_threshold,
+        Saturate(second_delta + 1ULL + second_delta / kEpsilonDivisor));
+    game_.PlayTurn(moves[best]);
+    children[best] =
+        Mid(plies - 1, !attacker, child_phi_threshold, child_delta_threshold);
+    game_.UndoTurn();
+  }
+  table_.Store(key, numbers, nodes_ - start_nodes);
+  return numbers;
+}
+
+void Solver::ProofLine(size_t plies, bool attacker,
+                       std::vector<std::string>* pv) {
+  if (plies == 0) {
+    return;
+  }
+  // The attacker plays a move proven to mate; the defender any move, all
+  // of which are. Garbage collection may have dropped the numbers of the
+  // proof's nodes, so if no child is known to be proven, children are
+  // solved again in turn.
+  const std::vector<Move> moves = game_.LegalMoves(game_.turn_);
+  for (bool search : {false, true}) {
+    for (const Move& m : moves) {
+      game_.PlayTurn(m);
+      Numbers child = table_.Probe(Key(plies - 1));
+      if (search && child.phi_ != 0 && child.delta_ != 0) {
+        child = Mid(plies - 1, !attacker, kInfinity, kInfinity);
+      }
+      if (attacker ? child.delta_ == 0 : child.phi_ == 0) {
+        pv->push_back(game::ToUci(m));
+        ProofLine(plies - 1, !attacker, pv);
+        game_.UndoTurn();
+        return;
+      }
+      game_.UndoTurn();
+    }
+  }
+}
+
+}  // namespace mate
@@ -0,0 +1,383 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/mcts.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "chess/engine.h"
+#include "chess/movepick.h"
+#include "chess/trace.h"
+
+namespace mcts {
+
+using game::Game;
+using game::Move;
+
+namespace {
+
+// The centipawn scale of the squashing of evaluations into values: a
+// position this much up is worth tanh(1), about 0.76.
+const double kEvalScale = 400;
+// The centipawn scale of the softmax over captures' static exchange values
+// that gives the priors. Quiet moves count as an even exchange.
+const double kPriorScale = 200;
+
+// The move of a node, on the game's position before it.
+auto Unpack(uint16_t packed, Game* game) -> Move {
+  const size_t from = packed >> 6;
+  const size_t to = packed & 63;
+  return game->turn_->PlayMove(
+      game->board_->At(from % board::kSize, from / board::kSize),
+      game->board_->At(to % board::kSize, to / board::kSize), game);
+}
+
+auto Fixed(double value) -> int64_t {
+  return static_cast<int64_t>(value * kValueScale);
+}
+
+}  // namespace
+
+const uint32_t NodePool::kFull;
+
+void Node::CopyFrom(const Node& other) {
+  move_ = other.move_;
+  children_ = other.children_;
+  state_.store(other.state_.load(std::memory_order_relaxed),
+               std::memory_order_relaxed);
+  first_child_ = other.first_child_;
+  prior_ = other.prior_;
+  visits_.store(other.visits_.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+  value_.store(other.value_.load(std::memory_order_relaxed),
+               std::memory_order_relaxed);
+}
+
+NodePool::NodePool(size_t bytes)
+    : capacity_(std::max<size_t>(bytes / sizeof(Node), 1)), used_(0) {
+  nodes_.reset(new Node[capacity_]);
+}
+
+auto NodePool::Allocate(size_t n) -> uint32_t {
+  uint32_t used = used_.load(std::memory_order_relaxed);
+  do {
+    if (used + n > capacity_) {
+      return kFull;
+    }
+  } while (!used_.compare_exchange_weak(used, static_cast<uint32_t>(used + n),
+                                        std::memory_order_relaxed));
+  return used;
+}
+
+void NodePool::Resize(size_t size) {
+  used_.store(static_cast<uint32_t>(size), std::memory_order_relaxed);
+}
+
+Searcher::Searcher(const Game& game, const Options& options)
+    : game_(game), options_(options),
+      pool_(options.memory_mb_ << 20), stop_(false), playouts_(0) {
+  options_.threads_ = std::max<size_t>(options_.threads_, 1);
+  Reset();
+}
+
+void Searcher::Reset() {
+  pool_.Resize(0);
+  Node& root = pool_[pool_.Allocate(1)];
+  root.move_ = 0;
+  root.children_ = 0;
+  root.state_.store(kUnexpanded, std::memory_order_relaxed);
+  root.first_child_ = 0;
+  root.prior_ = 1;
+  root.visits_.store(0, std::memory_order_relaxed);
+  root.value_.store(0, std::memory_order_relaxed);
+}
+
+void Searcher::Stop() { stop_.store(true, std::memory_order_relaxed); }
+
+auto Searcher::RootVisits() const -> uint32_t {
+  return pool_[0].visits_.load(std::memory_order_relaxed);
+}
+
+auto Searcher::Search(const Limits& limits) -> Result {
+  CHESS_TRACE_SCOPE("mcts::Searcher::Search");
+  const auto start = std::chrono::steady_clock::now();
+  stop_.store(false, std::memory_order_relaxed);
+  playouts_.store(0, std::memory_order_relaxed);
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < options_.threads_; i++) {
+    helpers.emplace_back(&Searcher::Work, this, game_, limits);
+  }
+  Work(game_, limits);
+  for (std::thread& helper : helpers) {
+    helper.join();
+  }
+
+  Result result;
+  result.seconds_ = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  result.playouts_ = std::min(playouts_.load(std::memory_order_relaxed),
+                              limits.playouts_ ? limits.playouts_ : UINT64_MAX);
+  if (result.seconds_ > 0) {
+    result.playouts_per_second_ =
+        static_cast<double>(result.playouts_) / result.seconds_;
+  }
+  result.nodes_ = pool_.Size();
+  result.memory_bytes_ = result.nodes_ * sizeof(Node);
+  // Follow the most visited children down the tree.
+  Game game = game_;
+  uint32_t node = 0;
+  while (pool_[node].state_.load(std::memory_order_relaxed) == kExpanded) {
+    const Node& parent = pool_[node];
+    uint32_t best = parent.first_child_;
+    for (uint32_t c = best + 1; c < parent.first_child_ + parent.children_;
+         c++) {
+      if (pool_[c].visits_.load(std::memory_order_relaxed) >
+          pool_[best].visits_.load(std::memory_order_relaxed)) {
+        best = c;
+      }
+    }
+    const uint32_t visits = pool_[best].visits_.load(std::memory_order_relaxed);
+    if (visits == 0) {
+      break;
+    }
+    if (node == 0) {
+      result.visits_ = visits;
+      result.value_ = static_cast<double>(
+                          pool_[best].value_.load(std::memory_order_relaxed)) /
+                      kValueScale / visits;
+    }
+    const Move m = Unpack(pool_[best].move_, &game);
+    result.pv_.push_back(game::ToUci(m));
+    game.PlayTurn(m);
+    node = best;
+  }
+  return result;
+}
+
+void Searcher::Work(Game game, const Limits& limits) {
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(limits.move_time_ms_);
+  std::vector<uint32_t> path;
+  while (!stop_.load(std::memory_order_relaxed)) {
+    // Claim a playout first, so threads never run more than the limit.
+    if (limits.playouts_ != 0 &&
+        playouts_.fetch_add(1, std::memory_order_relaxed) >=
+            limits.playouts_) {
+      break;
+    }
+    // A collision with another thread's expansion is retried.
+    while (!Playout(&game, &path)) {
+      std::this_thread::yield();
+    }
+    if (limits.playouts_ == 0) {
+      playouts_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (limits.move_time_ms_ > 0 &&
+        std::chrono::steady_clock::now() >= deadline) {
+      Stop();
+    }
+  }
+}
+
+auto Searcher::Select(uint32_t node) const -> uint32_t {
+  const Node& parent = pool_[node];
+  const double sqrt_visits = std::sqrt(static_cast<double>(
+      std::max<uint32_t>(parent.visits_.load(std::memory_order_relaxed), 1)));
+  uint32_t best = parent.first_child_;
+  double best_score = -1e9;
+  for (uint32_t c = parent.first_child_;
+       c < parent.first_child_ + parent.children_; c++) {
+    const Node& child = pool_[c];
+    const uint32_t visits = child.visits_.load(std::memory_order_relaxed);
+    // Unvisited moves count as even until tried.
+    const double q =
+        visits ? static_cast<double>(
+                     child.value_.load(std::memory_order_relaxed)) /
+                     kValueScale / visits
+               : 0;
+    const double score =
+        q + options_.c_puct_ * child.prior_ * sqrt_visits / (1 + visits);
+    if (score > best_score) {
+      best_score = score;
+      best = c;
+    }
+  }
+  return best;
+}
+
+void Searcher::Expand(uint32_t node, Game* game) {
+  uint8_t expected = kUnexpanded;
+  if (pool_.Size() + kMaxChildren > pool_.Capacity() ||
+      !pool_[node].state_.compare_exchange_strong(
+          expected, kExpanding, std::memory_order_acquire,
+          std::memory_order_relaxed)) {
+    return;
+  }
+  const std::vector<Move> moves = game->LegalMoves(game->turn_);
+  Node& parent = pool_[node];
+  if (moves.empty()) {
+    parent.state_.store(game->turn_->IsKingInCheck() ? kMate : kStalemate,
+                        std::memory_order_release);
+    return;
+  }
+  const uint32_t first = pool_.Allocate(moves.size());
+  if (first == NodePool::kFull) {
+    // Another thread took the room meanwhile.
+    parent.state_.store(kUnexpanded, std::memory_order_release);
+    return;
+  }
+  // Priors: a softmax over the material each move wins in an exchange.
+  std::vector<double> weights(moves.size());
+  double total = 0;
+  for (size_t i = 0; i < moves.size(); i++) {
+    const double gain =
+        movepick::IsCapture(moves[i]) ? movepick::See(*game, moves[i]) : 0;
+    weights[i] = std::exp(gain / kPriorScale);
+    total += weights[i];
+  }
+  for (size_t i = 0; i < moves.size(); i++) {
+    Node& child = pool_[first + static_cast<uint32_t>(i)];
+    child.move_ = movepick::Pack(moves[i]);
+    child.children_ = 0;
+    child.state_.store(kUnexpanded, std::memory_order_relaxed);
+    child.first_child_ = 0;
+    child.prior_ = static_cast<float>(weights[i] / total);
+    child.visits_.store(0, std::memory_order_relaxed);
+    child.value_.store(0, std::memory_order_relaxed);
+  }
+  parent.first_child_ = first;
+  parent.children_ = static_cast<uint8_t>(moves.size());
+  parent.state_.store(kExpanded, std::memory_order_release);
+}
+
+auto Searcher::Playout(Game* game, std::vector<uint32_t>* path) -> bool {
+  const uint32_t loss = options_.virtual_loss_;
+  path->clear();
+  pool_[0].visits_.fetch_add(1, std::memory_order_relaxed);
+  uint32_t node = 0;
+  while (pool_[node].state_.load(std::memory_order_acquire) == kExpanded) {
+    node = Select(node);
+    Node& child = pool_[node];
+    child.visits_.fetch_add(loss, std::memory_order_relaxed);
+    child.value_.fetch_sub(Fixed(loss), std::memory_order_relaxed);
+    path->push_back(node);
+    game->PlayTurn(Unpack(child.move_, game));
+  }
+  if (pool_[node].state_.load(std::memory_order_acquire) == kUnexpanded) {
+    Expand(node, game);
+  }
+  const uint8_t state = pool_[node].state_.load(std::memory_order_acquire);
+  if (state == kExpanding) {
+    // Another thread is adding the leaf's children. Back out rather than
+    // score the leaf again: on few cores, the others could otherwise spend
+    // every playout on it before its children are in.
+    for (size_t i = path->size(); i-- > 0;) {
+      Node& n = pool_[(*path)[i]];
+      n.value_.fetch_add(Fixed(loss), std::memory_order_relaxed);
+      n.visits_.fetch_sub(loss, std::memory_order_relaxed);
+      game->UndoTurn();
+    }
+    pool_[0].visits_.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+  // The value of the leaf to the player to move there.
+  double value;
+  switch (state) {
+    case kMate:
+      value = -1;
+      break;
+    case kStalemate:
+      value = 0;
+      break;
+    default:
+      value = std::tanh(engine::Evaluate(*game) / kEvalScale);
+      break;
+  }
+  // Each node holds the value to the player who moved into it, the
+  // opponent of the player to move there. Undo the virtual losses as the
+  // real value goes in.
+  for (size_t i = path->size(); i-- > 0;) {
+    Node& n = pool_[(*path)[i]];
+    n.value_.fetch_add(Fixed(-value + loss), std::memory_order_relaxed);
+    n.visits_.fetch_sub(loss - 1, std::memory_order_relaxed);
+    value = -value;
+    game->UndoTurn();
+  }
+  return true;
+}
+
+auto Searcher::Advance(const std::string& move) -> bool {
+  const std::vector<Move> moves = game_.LegalMoves(game_.turn_);
+  const auto it =
+      std::find_if(moves.begin(), moves.end(), [&move](const Move& m) {
+        return game::ToUci(m) == move;
+      });
+  if (it == moves.end()) {
+    throw std::invalid_argument("illegal move " + move);
+  }
+  game_.PlayTurn(*it);
+  const Node& root = pool_[0];
+  const uint16_t packed = movepick::Pack(*it);
+  if (root.state_.load(std::memory_order_relaxed) == kExpanded) {
+    for (uint32_t c = root.first_child_;
+         c < root.first_child_ + root.children_; c++) {
+      if (pool_[c].move_ == packed) {
+        Reroot(c);
+        return true;
+      }
+    }
+  }
+  Reset();
+  return false;
+}
+
+void Searcher::Reroot(uint32_t node) {
+  // Mark: the child blocks of the subtree, each as its first node and size.
+  std::vector<std::pair<uint32_t, uint32_t>> blocks;
+  std::vector<uint32_t> stack = {node};
+  while (!stack.empty()) {
+    const Node& n = pool_[stack.back()];
+    stack.pop_back();
+    if (n.state_.load(std::memory_order_relaxed) != kExpanded) {
+      continue;
+    }
+    blocks.emplace_back(n.first_child_, n.children_);
+    for (uint32_t c = n.first_child_; c < n.first_child_ + n.children_; c++) {
+      stack.push_back(c);
+    }
+  }
+  // The old root is at 0 and in no block, so the new one can take its
+  // place. Then slide the blocks down in pool order: a block only moves to
+  // lower indices, over nodes already moved or dropped.
+  pool_[0].CopyFrom(pool_[node]);
+  std::sort(blocks.begin(), blocks.end());
+  std::vector<uint32_t> moved_to(blocks.size());
+  uint32_t size = 1;
+  for (size_t b = 0; b < blocks.size(); b++) {
+    moved_to[b] = size;
+    for (uint32_t i = 0; i < blocks[b].second; i++) {
+      if (blocks[b].first + i != size) {
+        pool_[size].CopyFrom(pool_[blocks[b].first + i]);
+      }
+      size++;
+    }
+  }
+  // Point the parents at where their children went.
+  for (uint32_t i = 0; i < size; i++) {
+    Node& n = pool_[i];
+    if (n.state_.load(std::memory_order_relaxed) != kExpanded) {
+      continue;
+    }
+    const auto block = std::lower_bound(
+        blocks.begin(), blocks.end(),
+        std::make_pair(n.first_child_, static_cast<uint32_t>(0)));
+    n.first_child_ = moved_to[block - blocks.begin()];
+  }
+  pool_.Resize(size);
+}
+
+}  // namespace mcts
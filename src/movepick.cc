@@ -0,0 +1,349 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/movepick.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "chess/tt.h"
+
+namespace movepick {
+
+using game::Game;
+using game::Move;
+using piece::PieceType;
+
+namespace {
+
+auto ColorIndex(piece::Color c) -> size_t {
+  return c == piece::Color::kWhite ? 1 : 0;
+}
+
+auto SquareIndex(const board::Square* s) -> size_t {
+  return s->x_ + s->y_ * board::kSize;
+}
+
+// Finds the least valuable piece of the color attacking square (tx, ty),
+// treating the squares in removed as empty. Returns its square index and
+// sets value, or returns -1.
+auto LeastValuableAttacker(const Game& game, int tx, int ty, piece::Color c,
+                           const bool removed[64], int* value) -> int {
+  auto piece_at = [&](int x, int y) -> const piece::Piece* {
+    if (x < 0 || y < 0 || x >= 8 || y >= 8 || removed[x + 8 * y]) {
+      return nullptr;
+    }
+    return game.board_->At(x, y)->piece_;
+  };
+  int best = -1;
+  int best_value = 0;
+  auto consider = [&](int x, int y, const piece::Piece* p) {
+    const int v = PieceValue(p->type_);
+    if (best < 0 || v < best_value) {
+      best = x + 8 * y;
+      best_value = v;
+    }
+  };
+  // Pawns attack diagonally forward, so they stand diagonally behind.
+  const int behind = c == piece::Color::kWhite ? -1 : 1;
+  for (int dx : {-1, 1}) {
+    const piece::Piece* p = piece_at(tx + dx, ty + behind);
+    if (p && p->color_ == c && p->type_ == PieceType::kPawn) {
+      consider(tx + dx, ty + behind, p);
+    }
+  }
+  if (best >= 0) {
+    *value = best_value;
+    return best;
+  }
+  const int knight[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2},
+                            {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+  for (const auto& d : knight) {
+    const piece::Piece* p = piece_at(tx + d[0], ty + d[1]);
+    if (p && p->color_ == c && p->type_ == PieceType::kKnight) {
+      consider(tx + d[0], ty + d[1], p);
+    }
+  }
+  // Sliders: the first piece along each ray, x-rays included as pieces are
+  // removed.
+  const int rays[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1},
+                          {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+  for (size_t r = 0; r < 8; r++) {
+    const bool diagonal = r >= 4;
+    for (int step = 1; step < 8; step++) {
+      const int x = tx + rays[r][0] * step;
+      const int y = ty + rays[r][1] * step;
+      if (x < 0 || y < 0 || x >= 8 || y >= 8) {
+        break;
+      }
+      const piece::Piece* p = piece_at(x, y);
+      if (!p) {
+        continue;
+      }
+      if (p->color_ == c &&
+          (p->type_ == PieceType::kQueen ||
+           (p->type_ == PieceType::kKing && step == 1) ||
+           (diagonal && p->type_ == PieceType::kBishop) ||
+           (!diagonal && p->type_ == PieceType::kRook))) {
+        consider(x, y, p);
+      }
+      break;
+    }
+  }
+  *value = best_value;
+  return best;
+}
+
+}  // namespace
+
+auto PieceValue(PieceType t) -> int {
+  switch (t) {
+    case PieceType::kPawn:
+      return 100;
+    case PieceType::kKnight:
+      return 320;
+    case PieceType::kBishop:
+      return 330;
+    case PieceType::kRook:
+      return 500;
+    case PieceType::kQueen:
+      return 900;
+    case PieceType::kKing:
+      return 20000;
+  }
+  return 0;
+}
+
+auto Pack(const Move& m) -> uint16_t {
+  if (!m.from_ || !m.to_) {
+    return 0;
+  }
+  return tt::PackMove(m.from_->x_, m.from_->y_, m.to_->x_, m.to_->y_);
+}
+
+auto IsCapture(const Move& m) -> bool {
+  return m.to_->piece_ ||
+         (m.from_->piece_->type_ == PieceType::kPawn &&
+          m.from_->x_ != m.to_->x_);
+}
+
+auto VictimValue(const Move& m) -> int {
+  return m.to_->piece_ ? PieceValue(m.to_->piece_->type_)
+                       : PieceValue(PieceType::kPawn);
+}
+
+auto See(const Game& game, const Move& m) -> int {
+  bool removed[64] = {};
+  int gain[32];
+  const int tx = static_cast<int>(m.to_->x_);
+  const int ty = static_cast<int>(m.to_->y_);
+  piece::Color side = m.from_->piece_->color_;
+  gain[0] = VictimValue(m);
+  // The value of the piece standing on the target, next to be captured.
+  int on_target = PieceValue(m.from_->piece_->type_);
+  removed[SquareIndex(m.from_)] = true;
+  size_t d = 0;
+  while (d + 1 < 32) {
+    side = side == piece::Color::kWhite ? piece::Color::kBlack
+                                        : piece::Color::kWhite;
+    int value;
+    const int attacker =
+        LeastValuableAttacker(game, tx, ty, side, removed, &value);
+    if (attacker < 0) {
+      break;
+    }
+    d++;
+    gain[d] = on_target - gain[d - 1];
+    // Neither side can gain by continuing.
+    if (std::max(-gain[d - 1], gain[d]) < 0) {
+      break;
+    }
+    removed[attacker] = true;
+    on_target = value;
+  }
+  while (d > 0) {
+    gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    d--;
+  }
+  return gain[0];
+}
+
+Heuristics::Heuristics() { Clear(); }
+
+void Heuristics::Clear() {
+  std::memset(killers_, 0, sizeof(killers_));
+  std::memset(history_, 0, sizeof(history_));
+  std::memset(countermoves_, 0, sizeof(countermoves_));
+}
+
+void Heuristics::AddHistory(piece::Color c, const Move& m, int bonus) {
+  int& h = history_[ColorIndex(c)][SquareIndex(m.from_)][SquareIndex(m.to_)];
+  h += bonus - h * std::abs(bonus) / kMaxHistory;
+}
+
+void Heuristics::UpdateQuiet(const Game& game, const Move& best,
+                             const std::vector<Move>& tried, size_t depth,
+                             size_t ply) {
+  const uint16_t packed = Pack(best);
+  if (ply < kMaxPly && killers_[ply][0] != packed) {
+    killers_[ply][1] = killers_[ply][0];
+    killers_[ply][0] = packed;
+  }
+  const int bonus = static_cast<int>(std::min<size_t>(depth * depth, 400));
+  const piece::Color c = best.from_->piece_->color_;
+  AddHistory(c, best, bonus);
+  for (const Move& m : tried) {
+    AddHistory(c, m, -bonus);
+  }
+  if (!game.moves_.empty() && game.moves_.back().from_) {
+    const Move& previous = game.moves_.back();
+    countermoves_[SquareIndex(previous.from_)][SquareIndex(previous.to_)] =
+        packed;
+  }
+}
+
+auto Heuristics::History(piece::Color c, const Move& m) const -> int {
+  return history_[ColorIndex(c)][SquareIndex(m.from_)][SquareIndex(m.to_)];
+}
+
+auto Heuristics::Countermove(const Game& game) const -> uint16_t {
+  if (game.moves_.empty() || !game.moves_.back().from_) {
+    return 0;
+  }
+  const Move& previous = game.moves_.back();
+  return countermoves_[SquareIndex(previous.from_)][SquareIndex(previous.to_)];
+}
+
+MovePicker::MovePicker(const Game& game, const std::vector<Move>& moves,
+                       uint16_t hash_move, const Heuristics& heuristics,
+                       size_t ply)
+    : game_(game), heuristics_(heuristics), ply_(ply),
+      stage_(Stage::kHashMove), killer_(0), has_hash_move_(false),
+      next_bad_capture_(0), captures_only_(false) {
+  for (const Move& m : moves) {
+    if (hash_move != 0 && Pack(m) == hash_move) {
+      hash_move_ = m;
+      has_hash_move_ = true;
+    } else if (IsCapture(m)) {
+      AddCapture(m);
+    } else {
+      // Quiet moves are scored when their stage is reached.
+      quiets_.push_back({m, 0});
+    }
+  }
+}
+
+MovePicker::MovePicker(const Game& game, const std::vector<Move>& moves,
+                       const Heuristics& heuristics)
+    : game_(game), heuristics_(heuristics), ply_(0),
+      stage_(Stage::kGoodCaptures), killer_(0), has_hash_move_(false),
+      next_bad_capture_(0), captures_only_(true) {
+  for (const Move& m : moves) {
+    if (IsCapture(m)) {
+      AddCapture(m);
+    }
+  }
+}
+
+void MovePicker::AddCapture(const Move& m) {
+  // Most valuable victim, then least valuable attacker.
+  captures_.push_back(
+      {m, 10 * VictimValue(m) - PieceValue(m.from_->piece_->type_) / 10});
+}
+
+auto MovePicker::PickBest(std::vector<Scored>* list) -> Move {
+  size_t best = 0;
+  for (size_t i = 1; i < list->size(); i++) {
+    if ((*list)[i].score_ > (*list)[best].score_) {
+      best = i;
+    }
+  }
+  const Move m = (*list)[best].move_;
+  (*list)[best] = list->back();
+  list->pop_back();
+  return m;
+}
+
+auto MovePicker::TakeQuiet(uint16_t packed, Move* m) -> bool {
+  if (packed == 0) {
+    return false;
+  }
+  for (size_t i = 0; i < quiets_.size(); i++) {
+    if (Pack(quiets_[i].move_) == packed) {
+      *m = quiets_[i].move_;
+      quiets_[i] = quiets_.back();
+      quiets_.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+auto MovePicker::Next(Move* m) -> bool {
+  switch (stage_) {
+    case Stage::kHashMove:
+      stage_ = Stage::kGoodCaptures;
+      if (has_hash_move_) {
+        *m = hash_move_;
+        return true;
+      }
+      // Falls through.
+    case Stage::kGoodCaptures:
+      while (!captures_.empty()) {
+        const Move capture = PickBest(&captures_);
+        // Losing captures wait until after the quiet moves.
+        if (See(game_, capture) < 0) {
+          if (!captures_only_) {
+            bad_captures_.push_back(capture);
+          }
+          continue;
+        }
+        *m = capture;
+        return true;
+      }
+      if (captures_only_) {
+        stage_ = Stage::kDone;
+        return false;
+      }
+      stage_ = Stage::kKillers;
+      // Falls through.
+    case Stage::kKillers:
+      while (killer_ < 2 && ply_ < kMaxPly) {
+        if (TakeQuiet(heuristics_.Killer(ply_, killer_++), m)) {
+          return true;
+        }
+      }
+      stage_ = Stage::kCountermove;
+      // Falls through.
+    case Stage::kCountermove:
+      stage_ = Stage::kQuiets;
+      // Scored first: taking the countermove returns before kQuiets.
+      for (Scored& quiet : quiets_) {
+        quiet.score_ = heuristics_.History(
+            quiet.move_.from_->piece_->color_, quiet.move_);
+      }
+      if (TakeQuiet(heuristics_.Countermove(game_), m)) {
+        return true;
+      }
+      // Falls through.
+    case Stage::kQuiets:
+      if (!quiets_.empty()) {
+        *m = PickBest(&quiets_);
+        return true;
+      }
+      stage_ = Stage::kBadCaptures;
+      // Falls through.
+    case Stage::kBadCaptures:
+      if (next_bad_capture_ < bad_captures_.size()) {
+        *m = bad_captures_[next_bad_capture_++];
+        return true;
+      }
+      stage_ = Stage::kDone;
+      // Falls through.
+    case Stage::kDone:
+      return false;
+  }
+  return false;
+}
+
+}  // namespace movepick
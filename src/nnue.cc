@@ -0,0 +1,442 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/nnue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// CHESS_NNUE_SCALAR forces the portable kernels, to check the others
+// against them.
+#if !defined(CHESS_NNUE_SCALAR) && defined(__AVX2__)
+#define NNUE_AVX2
+#include <immintrin.h>
+#elif !defined(CHESS_NNUE_SCALAR) && defined(__SSSE3__)
+#define NNUE_SSSE3
+#include <tmmintrin.h>
+#elif !defined(CHESS_NNUE_SCALAR) && defined(__SSE2__)
+#define NNUE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace nnue {
+
+namespace {
+
+const size_t kHeaderWords = 6;
+// At most 15 pieces other than the king per side, 30 in all.
+const size_t kMaxActive = 32;
+
+// Byte offsets of the file's sections.
+struct Layout {
+  size_t feature_biases_;
+  size_t feature_weights_;
+  size_t layer1_biases_;
+  size_t layer1_weights_;
+  size_t layer2_biases_;
+  size_t layer2_weights_;
+  size_t output_bias_;
+  size_t output_weights_;
+  size_t size_;
+};
+
+auto Align(size_t offset) -> size_t { return (offset + 63) & ~size_t{63}; }
+
+auto FileLayout() -> Layout {
+  Layout l;
+  l.feature_biases_ = Align(kHeaderWords * sizeof(uint32_t));
+  l.feature_weights_ = Align(l.feature_biases_ + kHidden * sizeof(int16_t));
+  l.layer1_biases_ =
+      Align(l.feature_weights_ + kFeatures * kHidden * sizeof(int16_t));
+  l.layer1_weights_ = Align(l.layer1_biases_ + kLayer1 * sizeof(int32_t));
+  l.layer2_biases_ = Align(l.layer1_weights_ + kLayer1 * 2 * kHidden);
+  l.layer2_weights_ = Align(l.layer2_biases_ + kLayer2 * sizeof(int32_t));
+  l.output_bias_ = Align(l.layer2_weights_ + kLayer2 * kLayer1);
+  l.output_weights_ = Align(l.output_bias_ + sizeof(int32_t));
+  l.size_ = Align(l.output_weights_ + kLayer2);
+  return l;
+}
+
+// out = in plus the weight rows of the added features minus those of the
+// removed ones, kHidden values each.
+void Accumulate(const int16_t* in, const int16_t* weights,
+                const size_t* added, size_t num_added, const size_t* removed,
+                size_t num_removed, int16_t* out) {
+#if defined(NNUE_AVX2)
+  const size_t kLanes = 16;
+  for (size_t i = 0; i < kHidden; i += kLanes) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    for (size_t r = 0; r < num_removed; r++) {
+      v = _mm256_sub_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                                  weights + removed[r] * kHidden + i)));
+    }
+    for (size_t a = 0; a < num_added; a++) {
+      v = _mm256_add_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                                  weights + added[a] * kHidden + i)));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+  }
+#elif defined(NNUE_SSSE3) || defined(NNUE_SSE2)
+  const size_t kLanes = 8;
+  for (size_t i = 0; i < kHidden; i += kLanes) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    for (size_t r = 0; r < num_removed; r++) {
+      v = _mm_sub_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                               weights + removed[r] * kHidden + i)));
+    }
+    for (size_t a = 0; a < num_added; a++) {
+      v = _mm_add_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                               weights + added[a] * kHidden + i)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+  }
+#else
+  std::copy(in, in + kHidden, out);
+  for (size_t r = 0; r < num_removed; r++) {
+    const int16_t* row = weights + removed[r] * kHidden;
+    for (size_t i = 0; i < kHidden; i++) {
+      out[i] = static_cast<int16_t>(out[i] - row[i]);
+    }
+  }
+  for (size_t a = 0; a < num_added; a++) {
+    const int16_t* row = weights + added[a] * kHidden;
+    for (size_t i = 0; i < kHidden; i++) {
+      out[i] = static_cast<int16_t>(out[i] + row[i]);
+    }
+  }
+#endif
+}
+
+// Clips kHidden accumulator values to [0, 127] as bytes.
+void ClipAccumulator(const int16_t* in, uint8_t* out) {
+#if defined(NNUE_AVX2)
+  const __m256i zero = _mm256_setzero_si256();
+  for (size_t i = 0; i < kHidden; i += 32) {
+    const __m256i a = _mm256_max_epi16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), zero);
+    const __m256i b = _mm256_max_epi16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 16)),
+        zero);
+    // Packing works within 128-bit lanes, so the quarters are put back in
+    // order afterwards.
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(out + i),
+        _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xd8));
+  }
+#elif defined(NNUE_SSSE3) || defined(NNUE_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (size_t i = 0; i < kHidden; i += 16) {
+    const __m128i a = _mm_max_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), zero);
+    const __m128i b = _mm_max_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8)), zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packs_epi16(a, b));
+  }
+#else
+  for (size_t i = 0; i < kHidden; i++) {
+    out[i] = static_cast<uint8_t>(std::min<int>(std::max<int>(in[i], 0), 127));
+  }
+#endif
+}
+
+// The dot product of n activations in [0, 127] and n weights, n a multiple
+// of 32. The products of two neighbours can't saturate 16 bits:
+// 2 * 127 * 128 < 32768.
+auto Dot(const uint8_t* in, const int8_t* w, size_t n) -> int32_t {
+#if defined(NNUE_AVX2)
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i sum = _mm256_setzero_si256();
+  for (size_t i = 0; i < n; i += 32) {
+    const __m256i products = _mm256_maddubs_epi16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i)));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+  }
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                            _mm256_extracti128_si256(sum, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+  return _mm_cvtsi128_si32(s);
+#elif defined(NNUE_SSSE3) || defined(NNUE_SSE2)
+  __m128i sum = _mm_setzero_si128();
+  for (size_t i = 0; i < n; i += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i));
+#if defined(NNUE_SSSE3)
+    sum = _mm_add_epi32(
+        sum, _mm_madd_epi16(_mm_maddubs_epi16(x, y), _mm_set1_epi16(1)));
+#else
+    // Widen to 16 bits: activations with zeros, weights with their sign.
+    const __m128i zero = _mm_setzero_si128();
+    sum = _mm_add_epi32(
+        sum, _mm_madd_epi16(_mm_unpacklo_epi8(x, zero),
+                            _mm_srai_epi16(_mm_unpacklo_epi8(y, y), 8)));
+    sum = _mm_add_epi32(
+        sum, _mm_madd_epi16(_mm_unpackhi_epi8(x, zero),
+                            _mm_srai_epi16(_mm_unpackhi_epi8(y, y), 8)));
+#endif
+  }
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+  return _mm_cvtsi128_si32(sum);
+#else
+  int32_t sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += in[i] * w[i];
+  }
+  return sum;
+#endif
+}
+
+// A hidden layer: n inputs to m outputs, clipped to [0, 127].
+void Layer(const uint8_t* in, size_t n, const int32_t* biases,
+           const int8_t* weights, size_t m, uint8_t* out) {
+  for (size_t i = 0; i < m; i++) {
+    const int32_t sum = (biases[i] + Dot(in, weights + i * n, n)) >>
+                        kWeightShift;
+    out[i] = static_cast<uint8_t>(std::min(std::max(sum, 0), 127));
+  }
+}
+
+// xorshift64.
+auto NextRandom(uint64_t* seed) -> uint64_t {
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  return *seed;
+}
+
+// A uniform random integer in [lo, hi].
+auto Uniform(uint64_t* seed, int lo, int hi) -> int {
+  return lo + static_cast<int>(NextRandom(seed) %
+                               static_cast<uint64_t>(hi - lo + 1));
+}
+
+template <typename T>
+void Fill(std::vector<char>* file, size_t offset, size_t count, int lo,
+          int hi, uint64_t* seed) {
+  for (size_t i = 0; i < count; i++) {
+    const T value = static_cast<T>(Uniform(seed, lo, hi));
+    std::memcpy(file->data() + offset + i * sizeof(T), &value, sizeof(T));
+  }
+}
+
+}  // namespace
+
+auto Feature(piece::Color perspective, size_t kx, size_t ky, piece::Color c,
+             piece::PieceType t, size_t x, size_t y) -> size_t {
+  if (perspective == piece::Color::kBlack) {
+    ky = 7 - ky;
+    y = 7 - y;
+  }
+  // Kings are excluded, leaving five kinds per color, own pieces first.
+  const size_t kind = 2 * (static_cast<size_t>(t) - 1) + (c != perspective);
+  return ((kx + 8 * ky) * 10 + kind) * 64 + x + 8 * y;
+}
+
+auto Simd() -> const char* {
+#if defined(NNUE_AVX2)
+  return "avx2";
+#elif defined(NNUE_SSSE3)
+  return "ssse3";
+#elif defined(NNUE_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+auto Network::Load(const std::string& path) -> std::unique_ptr<Network> {
+  const Layout layout = FileLayout();
+  std::unique_ptr<Network> network(new Network());
+#if defined(__unix__) || defined(__APPLE__)
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("can't open network file " + path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != layout.size_) {
+    close(fd);
+    throw std::runtime_error(path + " is not a network of this layout");
+  }
+  void* data = mmap(nullptr, layout.size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error("can't map network file " + path);
+  }
+  network->mapped_ = true;
+#else
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw std::runtime_error("can't open network file " + path);
+  }
+  if (static_cast<size_t>(in.tellg()) != layout.size_) {
+    throw std::runtime_error(path + " is not a network of this layout");
+  }
+  void* data = ::operator new(layout.size_);
+  in.seekg(0);
+  in.read(static_cast<char*>(data), static_cast<std::streamsize>(layout.size_));
+#endif
+  network->data_ = data;
+  network->size_ = layout.size_;
+
+  const char* base = static_cast<const char*>(data);
+  uint32_t header[kHeaderWords];
+  std::memcpy(header, base, sizeof(header));
+  const uint32_t expected[kHeaderWords] = {
+      kMagic, kVersion, kFeatures, kHidden, kLayer1, kLayer2};
+  if (!std::equal(header, header + kHeaderWords, expected)) {
+    throw std::runtime_error(path + " is not a network of this layout");
+  }
+  network->feature_biases_ =
+      reinterpret_cast<const int16_t*>(base + layout.feature_biases_);
+  network->feature_weights_ =
+      reinterpret_cast<const int16_t*>(base + layout.feature_weights_);
+  network->layer1_biases_ =
+      reinterpret_cast<const int32_t*>(base + layout.layer1_biases_);
+  network->layer1_weights_ =
+      reinterpret_cast<const int8_t*>(base + layout.layer1_weights_);
+  network->layer2_biases_ =
+      reinterpret_cast<const int32_t*>(base + layout.layer2_biases_);
+  network->layer2_weights_ =
+      reinterpret_cast<const int8_t*>(base + layout.layer2_weights_);
+  network->output_bias_ =
+      reinterpret_cast<const int32_t*>(base + layout.output_bias_);
+  network->output_weights_ =
+      reinterpret_cast<const int8_t*>(base + layout.output_weights_);
+  return network;
+}
+
+void Network::WriteRandom(const std::string& path, uint64_t seed) {
+  const Layout layout = FileLayout();
+  std::vector<char> file(layout.size_, 0);
+  const uint32_t header[kHeaderWords] = {
+      kMagic, kVersion, kFeatures, kHidden, kLayer1, kLayer2};
+  std::memcpy(file.data(), header, sizeof(header));
+  // Ranges that keep about half of each layer's outputs off their clips.
+  seed |= 1;
+  Fill<int16_t>(&file, layout.feature_biases_, kHidden, 0, 64, &seed);
+  Fill<int16_t>(&file, layout.feature_weights_, kFeatures * kHidden, -24, 24,
+                &seed);
+  Fill<int8_t>(&file, layout.layer1_weights_, kLayer1 * 2 * kHidden, -8, 8,
+               &seed);
+  Fill<int8_t>(&file, layout.layer2_weights_, kLayer2 * kLayer1, -32, 32,
+               &seed);
+  Fill<int8_t>(&file, layout.output_weights_, kLayer2, -16, 16, &seed);
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(file.data(), static_cast<std::streamsize>(file.size()));
+  if (!out) {
+    throw std::runtime_error("can't write network file " + path);
+  }
+}
+
+Network::~Network() {
+  if (!data_) {
+    return;
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapped_) {
+    munmap(data_, size_);
+    return;
+  }
+#endif
+  ::operator delete(data_);
+}
+
+void Network::RefreshSide(const game::Game& game, piece::Color perspective,
+                          Accumulator* out) const {
+  const board::Square* king = perspective == piece::Color::kWhite
+                                  ? game.white_->kingSquare_
+                                  : game.black_->kingSquare_;
+  size_t active[kMaxActive];
+  size_t num_active = 0;
+  for (size_t x = 0; x < board::kSize; x++) {
+    for (size_t y = 0; y < board::kSize; y++) {
+      const piece::Piece* p = game.board_->At(x, y)->piece_;
+      if (p && p->type_ != piece::PieceType::kKing &&
+          num_active < kMaxActive) {
+        active[num_active++] = Feature(perspective, king->x_, king->y_,
+                                       p->color_, p->type_, x, y);
+      }
+    }
+  }
+  Accumulate(feature_biases_, feature_weights_, active, num_active, nullptr,
+             0, out->values_[static_cast<size_t>(perspective)]);
+}
+
+void Network::Refresh(const game::Game& game, Accumulator* out) const {
+  RefreshSide(game, piece::Color::kWhite, out);
+  RefreshSide(game, piece::Color::kBlack, out);
+}
+
+void Network::Update(const game::Game& game, const Accumulator& previous,
+                     Accumulator* out) const {
+  const game::MoveChanges& changes = game.Changes();
+  for (piece::Color perspective :
+       {piece::Color::kWhite, piece::Color::kBlack}) {
+    const board::Square* king = perspective == piece::Color::kWhite
+                                    ? game.white_->kingSquare_
+                                    : game.black_->kingSquare_;
+    size_t added[4];
+    size_t removed[4];
+    size_t num_added = 0;
+    size_t num_removed = 0;
+    bool king_moved = false;
+    for (size_t i = 0; i < changes.size_; i++) {
+      const game::PieceChange& c = changes.changes_[i];
+      if (c.type_ == piece::PieceType::kKing) {
+        king_moved = king_moved || c.color_ == perspective;
+        continue;
+      }
+      const size_t feature =
+          Feature(perspective, king->x_, king->y_, c.color_, c.type_,
+                  c.square_ % board::kSize, c.square_ / board::kSize);
+      if (c.added_) {
+        added[num_added++] = feature;
+      } else {
+        removed[num_removed++] = feature;
+      }
+    }
+    // Every feature depends on the king's square.
+    if (king_moved) {
+      RefreshSide(game, perspective, out);
+      continue;
+    }
+    const size_t side = static_cast<size_t>(perspective);
+    Accumulate(previous.values_[side], feature_weights_, added, num_added,
+               removed, num_removed, out->values_[side]);
+  }
+}
+
+auto Network::Evaluate(const Accumulator& acc, piece::Color to_move) const
+    -> int {
+  alignas(32) uint8_t input[2 * kHidden];
+  alignas(32) uint8_t hidden1[kLayer1];
+  alignas(32) uint8_t hidden2[kLayer2];
+  const size_t us = static_cast<size_t>(to_move);
+  ClipAccumulator(acc.values_[us], input);
+  ClipAccumulator(acc.values_[1 - us], input + kHidden);
+  Layer(input, 2 * kHidden, layer1_biases_, layer1_weights_, kLayer1,
+        hidden1);
+  Layer(hidden1, kLayer1, layer2_biases_, layer2_weights_, kLayer2, hidden2);
+  return (*output_bias_ + Dot(hidden2, output_weights_, kLayer2)) /
+         kOutputScale;
+}
+
+auto Network::Evaluate(const game::Game& game) const -> int {
+  Accumulator acc;
+  Refresh(game, &acc);
+  return Evaluate(acc, game.turn_->color_);
+}
+
+}  // namespace nnue
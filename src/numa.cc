@@ -0,0 +1,221 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/numa.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace numa {
+
+namespace {
+
+// From the kernel's <linux/mempolicy.h>, which not every system installs.
+const int kInterleave = 3;
+const unsigned kMoveFlag = 1u << 1;
+
+// The CPUs the process may run on, or none if that can't be told.
+auto AllowedCpus() -> std::vector<size_t> {
+  std::vector<size_t> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (size_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
+
+auto ReadFile(const std::string& path, std::string* contents) -> bool {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  contents->assign(std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>());
+  return true;
+}
+
+}  // namespace
+
+auto ParseCpuList(const std::string& list) -> std::vector<size_t> {
+  std::vector<size_t> cpus;
+  std::stringstream ranges(list);
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    range.erase(std::remove_if(range.begin(), range.end(),
+                               [](char c) { return std::isspace(c); }),
+                range.end());
+    if (range.empty()) {
+      continue;
+    }
+    const size_t dash = range.find('-');
+    const std::string first = range.substr(0, dash);
+    const std::string last =
+        dash == std::string::npos ? first : range.substr(dash + 1);
+    const auto digits = [](const std::string& s) {
+      return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) {
+        return std::isdigit(c) != 0;
+      });
+    };
+    if (!digits(first) || !digits(last)) {
+      throw std::invalid_argument("bad CPU list: " + list);
+    }
+    const size_t from = std::stoul(first);
+    const size_t to = std::stoul(last);
+    if (to < from) {
+      throw std::invalid_argument("bad CPU list: " + list);
+    }
+    for (size_t cpu = from; cpu <= to; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+Topology::Topology() {
+  Node node = {0, AllowedCpus()};
+  if (node.cpus_.empty()) {
+    const size_t n = std::max(std::thread::hardware_concurrency(), 1u);
+    for (size_t cpu = 0; cpu < n; cpu++) {
+      node.cpus_.push_back(cpu);
+    }
+  }
+  nodes_.push_back(node);
+}
+
+Topology::Topology(std::vector<Node> nodes) : nodes_(std::move(nodes)) {}
+
+auto Topology::Detect() -> Topology {
+  Topology topology;
+  try {
+    topology = Read("/sys/devices/system/node");
+  } catch (const std::exception&) {
+    return Topology();
+  }
+  // Keep the CPUs the process is allowed, e.g. under taskset or a
+  // container's cpuset.
+  const std::vector<size_t> allowed = AllowedCpus();
+  if (allowed.empty()) {
+    return topology;
+  }
+  std::vector<Node> nodes;
+  for (Node node : topology.nodes_) {
+    node.cpus_.erase(
+        std::remove_if(node.cpus_.begin(), node.cpus_.end(),
+                       [&allowed](size_t cpu) {
+                         return !std::binary_search(allowed.begin(),
+                                                    allowed.end(), cpu);
+                       }),
+        node.cpus_.end());
+    if (!node.cpus_.empty()) {
+      nodes.push_back(node);
+    }
+  }
+  return nodes.empty() ? Topology() : Topology(nodes);
+}
+
+auto Topology::Read(const std::string& directory) -> Topology {
+  std::string online;
+  if (!ReadFile(directory + "/online", &online)) {
+    throw std::runtime_error("no NUMA nodes listed in " + directory);
+  }
+  std::vector<Node> nodes;
+  for (size_t id : ParseCpuList(online)) {
+    std::string cpus;
+    if (!ReadFile(directory + "/node" + std::to_string(id) + "/cpulist",
+                  &cpus)) {
+      continue;
+    }
+    Node node = {id, ParseCpuList(cpus)};
+    if (!node.cpus_.empty()) {
+      nodes.push_back(node);
+    }
+  }
+  if (nodes.empty()) {
+    throw std::runtime_error("no NUMA nodes with CPUs in " + directory);
+  }
+  return Topology(nodes);
+}
+
+auto Topology::Cpus() const -> size_t {
+  size_t n = 0;
+  for (const Node& node : nodes_) {
+    n += node.cpus_.size();
+  }
+  return n;
+}
+
+auto Topology::NodeFor(size_t worker) const -> size_t {
+  return worker % nodes_.size();
+}
+
+auto Topology::CpuFor(size_t worker) const -> size_t {
+  const Node& node = nodes_[NodeFor(worker)];
+  return node.cpus_[(worker / nodes_.size()) % node.cpus_.size()];
+}
+
+auto Topology::Restrict(size_t n) const -> Topology {
+  n = std::max<size_t>(std::min(n, nodes_.size()), 1);
+  return Topology(std::vector<Node>(
+      nodes_.begin(), nodes_.begin() + static_cast<ptrdiff_t>(n)));
+}
+
+auto PinThread(size_t cpu) -> bool {
+#ifdef __linux__
+  if (cpu >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  // A pid of 0 is the calling thread.
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+auto Interleave(void* memory, size_t bytes, const Topology& topology)
+    -> bool {
+#if defined(__linux__) && defined(SYS_mbind)
+  if (topology.Nodes().size() < 2 || bytes == 0) {
+    return false;
+  }
+  const size_t bits = 8 * sizeof(unsigned long);
+  size_t max_id = 0;
+  for (const Node& node : topology.Nodes()) {
+    max_id = std::max(max_id, node.id_);
+  }
+  std::vector<unsigned long> mask(max_id / bits + 1, 0);
+  for (const Node& node : topology.Nodes()) {
+    mask[node.id_ / bits] |= 1UL << (node.id_ % bits);
+  }
+  // The kernel reads one bit fewer than it is told.
+  return syscall(SYS_mbind, memory, bytes, kInterleave, mask.data(),
+                 mask.size() * bits + 1, kMoveFlag) == 0;
+#else
+  (void)memory;
+  (void)bytes;
+  (void)topology;
+  return false;
+#endif
+}
+
+}  // namespace numa
@@ -0,0 +1,167 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/pawns.h"
+
+#include <algorithm>
+
+namespace pawns {
+
+namespace {
+
+const eval::Score kDoubled = {-10, -25};
+const eval::Score kIsolated = {-10, -15};
+const eval::Score kBackward = {-8, -12};
+// By the rank of the passed pawn counted from its own back rank.
+const eval::Score kPassed[8] = {{0, 0},   {5, 10},  {10, 15}, {15, 25},
+                                {30, 50}, {55, 90}, {90, 140}, {0, 0}};
+// Shield pawns on the king's and the neighbouring files, by the rank of
+// the least advanced one counted from the side's own back rank, 0 for an
+// open file.
+const int kShield[8] = {-15, 12, 6, 0, 0, 0, 0, 0};
+
+// Bit x + 8 * y is set for a pawn on square (x, y).
+auto Bit(int x, int y) -> uint64_t { return uint64_t{1} << (x + 8 * y); }
+
+auto Has(uint64_t pawns, int x, int y) -> bool {
+  return x >= 0 && x < 8 && y >= 0 && y < 8 && (pawns & Bit(x, y)) != 0;
+}
+
+// Whether any pawn stands on file x from rank y on in direction dy.
+auto OnFileFrom(uint64_t pawns, int x, int y, int dy) -> bool {
+  for (; y >= 0 && y < 8; y += dy) {
+    if (Has(pawns, x, y)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// The structure score of the side whose pawns are own, moving in direction
+// dy, against the enemy pawns. Records the front of each file.
+auto SideScore(uint64_t own, uint64_t enemy, int dy, uint8_t front[8])
+    -> eval::Score {
+  eval::Score score;
+  for (int x = 0; x < 8; x++) {
+    int count = 0;
+    for (int y = 0; y < 8; y++) {
+      if (!Has(own, x, y)) {
+        continue;
+      }
+      count++;
+      const int rank = dy > 0 ? y : 7 - y;
+      if (front[x] == 0 || rank < front[x]) {
+        front[x] = static_cast<uint8_t>(rank);
+      }
+      bool isolated = true;
+      bool supported = false;
+      for (int dx : {-1, 1}) {
+        if (OnFileFrom(own, x + dx, 0, 1)) {
+          isolated = false;
+        }
+        // A neighbour level with or behind the pawn can still defend it.
+        if (OnFileFrom(own, x + dx, y, -dy)) {
+          supported = true;
+        }
+      }
+      const bool passed = !OnFileFrom(enemy, x, y + dy, dy) &&
+                          !OnFileFrom(enemy, x - 1, y + dy, dy) &&
+                          !OnFileFrom(enemy, x + 1, y + dy, dy) &&
+                          !OnFileFrom(own, x, y + dy, dy);
+      if (isolated) {
+        score += kIsolated;
+      } else if (!supported && (Has(enemy, x - 1, y + 2 * dy) ||
+                                Has(enemy, x + 1, y + 2 * dy))) {
+        // Backward: no pawn can come to its aid and its advance is
+        // covered by an enemy pawn.
+        score += kBackward;
+      }
+      if (passed) {
+        score += kPassed[rank];
+      }
+    }
+    for (int extra = 1; extra < count; extra++) {
+      score += kDoubled;
+    }
+  }
+  return score;
+}
+
+auto SideShelter(const uint8_t front[8], const board::Square* king,
+                 bool white) -> int {
+  const int rank = white ? static_cast<int>(king->y_)
+                         : 7 - static_cast<int>(king->y_);
+  // A king that has left its back ranks has no shield to speak of.
+  if (rank > 1) {
+    return 0;
+  }
+  int shelter = 0;
+  const int file = static_cast<int>(king->x_);
+  for (int x = std::max(file - 1, 0); x <= std::min(file + 1, 7); x++) {
+    shelter += kShield[front[x]];
+  }
+  return shelter;
+}
+
+}  // namespace
+
+auto Compute(const game::Game& game) -> Entry {
+  uint64_t white = 0;
+  uint64_t black = 0;
+  for (size_t x = 0; x < board::kSize; x++) {
+    for (size_t y = 0; y < board::kSize; y++) {
+      const piece::Piece* p = game.board_->At(x, y)->piece_;
+      if (p && p->type_ == piece::PieceType::kPawn) {
+        (p->color_ == piece::Color::kWhite ? white : black) |=
+            Bit(static_cast<int>(x), static_cast<int>(y));
+      }
+    }
+  }
+  Entry entry;
+  entry.key_ = game.pawn_key_;
+  entry.score_ = SideScore(white, black, 1, entry.front_[0]);
+  entry.score_ -= SideScore(black, white, -1, entry.front_[1]);
+  return entry;
+}
+
+auto Shelter(const Entry& entry, const game::Game& game) -> eval::Score {
+  eval::Score score;
+  if (game.white_->kingSquare_ && game.black_->kingSquare_) {
+    score.mg_ = SideShelter(entry.front_[0], game.white_->kingSquare_, true) -
+                SideShelter(entry.front_[1], game.black_->kingSquare_, false);
+  }
+  return score;
+}
+
+Table::Table(size_t entries) {
+  size_t size = 1;
+  while (size * 2 <= std::max<size_t>(entries, 1)) {
+    size *= 2;
+  }
+  entries_.resize(size);
+}
+
+auto Table::Probe(const game::Game& game) -> const Entry& {
+  probes_++;
+  Entry& entry = entries_[game.pawn_key_ & (entries_.size() - 1)];
+  if (entry.key_ == game.pawn_key_) {
+    hits_++;
+  } else {
+    entry = Compute(game);
+  }
+  return entry;
+}
+
+void Table::Clear() {
+  std::fill(entries_.begin(), entries_.end(), Entry());
+  probes_ = 0;
+  hits_ = 0;
+}
+
+auto Evaluate(const game::Game& game, Table* table) -> eval::Score {
+  const Entry& entry = table->Probe(game);
+  eval::Score score = entry.score_;
+  score += Shelter(entry, game);
+  return score;
+}
+
+}  // namespace pawns
@@ -0,0 +1,120 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/perft.h"
+
+#include <atomic>
+#include <sstream>
+
+namespace perft {
+
+using game::Game;
+using game::Move;
+
+namespace {
+
+// Counts the leaves below the position, playing and taking back each move.
+// With a table, counts of subtrees at least two plies deep are cached.
+auto PerftInPlace(Game* game, size_t depth, tt::Table* table = nullptr)
+    -> uint64_t {
+  tt::Entry entry;
+  if (table && depth > 1 && table->Probe(game->key_, &entry) &&
+      entry.depth_ == depth) {
+    return entry.value_;
+  }
+  std::vector<Move> moves = game->LegalMoves(game->turn_);
+  if (depth == 1) {
+    return moves.size();
+  }
+  uint64_t nodes = 0;
+  for (const Move& m : moves) {
+    game->PlayTurn(m);
+    nodes += PerftInPlace(game, depth - 1, table);
+    game->UndoTurn();
+  }
+  if (table && nodes <= tt::kMaxValue) {
+    entry.value_ = nodes;
+    entry.depth_ = static_cast<uint8_t>(depth);
+    entry.bound_ = tt::Bound::kExact;
+    table->Store(game->key_, entry);
+  }
+  return nodes;
+}
+
+// Plays the move from (fx, fy) to (tx, ty) on the game.
+void PlayOnCopy(Game* game, size_t fx, size_t fy, size_t tx, size_t ty) {
+  game->PlayTurn(game->turn_->PlayMove(game->board_->At(fx, fy),
+                                       game->board_->At(tx, ty), game));
+}
+
+}  // namespace
+
+auto Perft(const Game& game, size_t depth) -> uint64_t {
+  if (depth == 0) {
+    return 1;
+  }
+  Game position(game);
+  return PerftInPlace(&position, depth);
+}
+
+auto Perft(const Game& game, size_t depth, tt::Table* table) -> uint64_t {
+  if (depth == 0) {
+    return 1;
+  }
+  Game position(game);
+  return PerftInPlace(&position, depth, table);
+}
+
+auto ParallelPerft(const Game& game, size_t depth, pool::ThreadPool* pool)
+    -> uint64_t {
+  if (depth <= 2) {
+    return Perft(game, depth);
+  }
+  std::atomic<uint64_t> nodes(0);
+  Game root(game);
+  std::vector<Move> moves = root.LegalMoves(root.turn_);
+  pool::TaskGroup group(pool);
+  for (const Move& m : moves) {
+    // Tasks can't share the root's board, so each move is named by its
+    // coordinates and played on a copy.
+    const size_t fx = m.from_->x_, fy = m.from_->y_;
+    const size_t tx = m.to_->x_, ty = m.to_->y_;
+    group.Run([&root, &nodes, pool, depth, fx, fy, tx, ty] {
+      Game child(root);
+      PlayOnCopy(&child, fx, fy, tx, ty);
+      pool::TaskGroup replies(pool);
+      for (const Move& reply : child.LegalMoves(child.turn_)) {
+        const size_t rfx = reply.from_->x_, rfy = reply.from_->y_;
+        const size_t rtx = reply.to_->x_, rty = reply.to_->y_;
+        replies.Run([&child, &nodes, depth, rfx, rfy, rtx, rty] {
+          Game grandchild(child);
+          PlayOnCopy(&grandchild, rfx, rfy, rtx, rty);
+          nodes.fetch_add(PerftInPlace(&grandchild, depth - 2),
+                          std::memory_order_relaxed);
+        });
+      }
+      replies.Wait();
+    });
+  }
+  group.Wait();
+  return nodes.load();
+}
+
+auto Divide(const Game& game, size_t depth)
+    -> std::vector<std::pair<std::string, uint64_t>> {
+  std::vector<std::pair<std::string, uint64_t>> counts;
+  if (depth == 0) {
+    return counts;
+  }
+  Game position(game);
+  for (const Move& m : position.LegalMoves(position.turn_)) {
+    std::stringstream move;
+    move << m;
+    position.PlayTurn(m);
+    counts.emplace_back(move.str(),
+                        depth == 1 ? 1 : PerftInPlace(&position, depth - 1));
+    position.UndoTurn();
+  }
+  return counts;
+}
+
+}  // namespace perft
@@ -0,0 +1,255 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/pgn.h"
+
+#include <cctype>
+#include <cstdlib>
+
+#include "chess/board.h"
+
+namespace pgn {
+
+using board::Square;
+using piece::PieceType;
+
+namespace {
+
+auto IsResult(const std::string& token) -> bool {
+  return token == "1-0" || token == "0-1" || token == "1/2-1/2" ||
+         token == "*";
+}
+
+// Characters that end a movetext token.
+auto EndsToken(int c) -> bool {
+  return std::isspace(c) || c == '{' || c == '}' || c == '(' || c == ')' ||
+         c == ';' || c == '[';
+}
+
+auto TypeOf(char c, PieceType* type) -> bool {
+  switch (c) {
+    case 'K':
+      *type = PieceType::kKing;
+      return true;
+    case 'Q':
+      *type = PieceType::kQueen;
+      return true;
+    case 'R':
+      *type = PieceType::kRook;
+      return true;
+    case 'B':
+      *type = PieceType::kBishop;
+      return true;
+    case 'N':
+      *type = PieceType::kKnight;
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+auto Reader::Get() -> int {
+  if (pending_ >= 0) {
+    const int c = pending_;
+    pending_ = -1;
+    return c;
+  }
+  return in_->rdbuf()->sbumpc();
+}
+
+void Reader::SkipTo(int end) {
+  int c;
+  while ((c = Get()) != EOF && c != end) {
+  }
+}
+
+auto Reader::ReadTag(Record* record) -> bool {
+  // [Name "Value"], the value's quotes and backslashes escaped.
+  std::string name;
+  int c;
+  while ((c = Get()) != EOF && c != '"' && c != ']') {
+    if (!std::isspace(c)) {
+      name += static_cast<char>(c);
+    }
+  }
+  if (c != '"') {
+    return c == ']';
+  }
+  std::string value;
+  while ((c = Get()) != EOF && c != '"') {
+    if (c == '\\') {
+      c = Get();
+    }
+    if (c != EOF) {
+      value += static_cast<char>(c);
+    }
+  }
+  SkipTo(']');
+  record->tags_[name] = value;
+  return true;
+}
+
+auto Reader::Next(Record* record) -> bool {
+  record->tags_.clear();
+  record->moves_.clear();
+  record->result_.clear();
+  bool any = false;
+  int c;
+  while ((c = Get()) != EOF) {
+    if (std::isspace(c)) {
+      continue;
+    }
+    if (c == '[') {
+      // A tag after moves starts the next game, which lacked a result.
+      if (!record->moves_.empty()) {
+        pending_ = c;
+        break;
+      }
+      any = ReadTag(record) || any;
+      continue;
+    }
+    if (c == '{') {
+      SkipTo('}');
+      continue;
+    }
+    if (c == ';' || c == '%') {
+      SkipTo('\n');
+      continue;
+    }
+    if (c == '(') {
+      // Variations nest.
+      size_t depth = 1;
+      while (depth > 0 && (c = Get()) != EOF) {
+        if (c == '{') {
+          SkipTo('}');
+        } else if (c == '(') {
+          depth++;
+        } else if (c == ')') {
+          depth--;
+        }
+      }
+      continue;
+    }
+    std::string token(1, static_cast<char>(c));
+    while ((c = Get()) != EOF && !EndsToken(c)) {
+      token += static_cast<char>(c);
+    }
+    if (c != EOF && !std::isspace(c)) {
+      pending_ = c;
+    }
+    any = true;
+    if (IsResult(token)) {
+      record->result_ = token;
+      break;
+    }
+    // Move numbers, "12." or "12...", may be joined to the move.
+    size_t start = 0;
+    while (start < token.size() && std::isdigit(token[start])) {
+      start++;
+    }
+    if (start > 0 && start < token.size() && token[start] == '.') {
+      while (start < token.size() && token[start] == '.') {
+        start++;
+      }
+    } else {
+      start = 0;
+    }
+    if (start < token.size() && token[start] != '$' && token[start] != ')') {
+      record->moves_.push_back(token.substr(start));
+    }
+  }
+  if (record->result_.empty()) {
+    const auto tag = record->tags_.find("Result");
+    if (tag != record->tags_.end() && IsResult(tag->second)) {
+      record->result_ = tag->second;
+    }
+  }
+  return any;
+}
+
+auto ParseSan(game::Game* game, const std::string& san, game::Move* move)
+    -> bool {
+  // Drop check, mate and annotation marks.
+  std::string s = san;
+  while (!s.empty() && (s.back() == '+' || s.back() == '#' ||
+                        s.back() == '!' || s.back() == '?')) {
+    s.pop_back();
+  }
+  game::Player* player = game->turn_;
+  const size_t home = player == game->white_ ? 0 : board::kSize - 1;
+  const Square* king = player->kingSquare_;
+  if (s == "O-O" || s == "0-0" || s == "O-O-O" || s == "0-0-0") {
+    if (king->x_ != 4 || king->y_ != home) {
+      return false;
+    }
+    const size_t to = s.size() == 3 ? 6 : 2;
+    *move = player->PlayMove(king, game->board_->At(to, home), game);
+    if (!game->PlayTurn(*move)) {
+      return false;
+    }
+    game->UndoTurn();
+    return true;
+  }
+  if (s.find('=') != std::string::npos || s.size() < 2) {
+    return false;
+  }
+
+  PieceType type = PieceType::kPawn;
+  size_t begin = 0;
+  if (TypeOf(s[0], &type)) {
+    begin = 1;
+  }
+  const char file = s[s.size() - 2];
+  const char rank = s[s.size() - 1];
+  if (file < 'a' || file > 'h' || rank < '1' || rank > '8') {
+    return false;
+  }
+  const Square* to = game->board_->At(static_cast<size_t>(file - 'a'),
+                                      static_cast<size_t>(rank - '1'));
+  // What is left names the origin's file, rank or both, and a capture.
+  int from_file = -1;
+  int from_rank = -1;
+  for (size_t i = begin; i + 2 < s.size(); i++) {
+    if (s[i] >= 'a' && s[i] <= 'h') {
+      from_file = s[i] - 'a';
+    } else if (s[i] >= '1' && s[i] <= '8') {
+      from_rank = s[i] - '1';
+    } else if (s[i] != 'x' && s[i] != ':') {
+      return false;
+    }
+  }
+
+  size_t found = 0;
+  for (size_t y = 0; y < board::kSize; y++) {
+    if (from_rank >= 0 && static_cast<size_t>(from_rank) != y) {
+      continue;
+    }
+    for (size_t x = 0; x < board::kSize; x++) {
+      if (from_file >= 0 && static_cast<size_t>(from_file) != x) {
+        continue;
+      }
+      const Square* from = game->board_->At(x, y);
+      const piece::Piece* p = from->piece_;
+      if (!p || p->type_ != type || p->color_ != player->color_ ||
+          !game->CanMove(from, to, player)) {
+        continue;
+      }
+      // A king's two-square move is castling, written otherwise.
+      if (type == PieceType::kKing &&
+          std::abs(static_cast<int>(x) - static_cast<int>(to->x_)) > 1) {
+        continue;
+      }
+      const game::Move m = player->PlayMove(from, to, game);
+      if (!game->PlayTurn(m)) {
+        continue;
+      }
+      game->UndoTurn();
+      *move = m;
+      found++;
+    }
+  }
+  return found == 1;
+}
+
+}  // namespace pgn
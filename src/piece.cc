@@ -1,7 +1,6 @@
 // Copyright (c) 2020 Andrea Roy. All rights reserved.
 
 #include <chess/piece.h>
-#include <cinder/app/App.h>
 
 #include <cassert>
 
@@ -166,7 +165,7 @@ auto Rook::Path(const size_t x_old, const size_t y_old, const size_t x_new,
       if (x_new == i || x_old == i) {
         continue;
       }
-      path.emplace_back(make_tuple(x_new, i));
+      path.emplace_back(make_tuple(i, y_new));
     }
   }
   return path;
@@ -206,7 +205,7 @@ auto Queen::Path(const size_t x_old, const size_t y_old, const size_t x_new,
       if (x_new == i || x_old == i) {
         continue;
       }
-      path.emplace_back(make_tuple(x_new, i));
+      path.emplace_back(make_tuple(i, y_new));
     }
     return path;
   }
@@ -250,15 +249,34 @@ auto King::Path(size_t x_old, size_t y_old, size_t x_new, size_t y_new) const
     path.emplace_back(x_old, y_new);
     return path;
   }
+  // A castling king passes over every square up to and including its
+  // destination, a regular king move only over its destination.
   if (x_old < x_new) {
-    for (size_t x = x_new + 1; x <= x_old; x++) {
-      path.emplace_back(x, y_old);
+    for (size_t x = x_old + 1; x <= x_new; x++) {
+      path.emplace_back(x, y_new);
     }
     return path;
   }
-  for (size_t x = x_new - 1; x >= x_old; x--) {
-    path.emplace_back(x, y_old);
+  for (size_t x = x_old; x-- > x_new;) {
+    path.emplace_back(x, y_new);
   }
   return path;
 }
+
+auto MakePiece(const PieceType t, const Color c) -> Piece* {
+  switch (t) {
+    case PieceType::kPawn:
+      return new Pawn(c);
+    case PieceType::kKnight:
+      return new Knight(c);
+    case PieceType::kBishop:
+      return new Bishop(c);
+    case PieceType::kRook:
+      return new Rook(c);
+    case PieceType::kQueen:
+      return new Queen(c);
+    default:
+      return new King(c);
+  }
+}
 }  // namespace piece
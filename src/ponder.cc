@@ -0,0 +1,98 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/ponder.h"
+
+#include <chrono>
+
+namespace ponder {
+
+Ponderer::Ponderer(tt::Table* table, const engine::Options& options,
+                   size_t replies)
+    : table_(table), options_(options), depth_(0), done_(true) {
+  options_.multi_pv_ = replies;
+}
+
+Ponderer::~Ponderer() { Stop(); }
+
+void Ponderer::Start(const game::Game& game) {
+  Stop();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    answers_.clear();
+    depth_ = 0;
+    done_ = false;
+  }
+  // The searcher copies the game here, so it may change once Start returns.
+  searcher_.reset(new engine::Searcher(game, table_, options_));
+  thread_ = std::thread([this] {
+    engine::Limits limits;
+    limits.on_iteration_ = [this](const engine::Result& result) {
+      Record(result);
+    };
+    searcher_->Search(limits);
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    done_changed_.notify_all();
+  });
+}
+
+void Ponderer::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  // A search clears the stop request when it starts, so one made before
+  // the thread gets there would be lost: repeat it until the search ends.
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!done_changed_.wait_for(lock, std::chrono::milliseconds(1),
+                                   [this] { return done_; })) {
+      searcher_->Stop();
+    }
+  }
+  thread_.join();
+  searcher_.reset();
+}
+
+void Ponderer::Record(const engine::Result& result) {
+  std::map<std::string, Answer> answers;
+  for (const engine::Line& line : result.lines_) {
+    // A line cut short by mate or the first iteration has no answer.
+    if (line.pv_.size() < 2) {
+      continue;
+    }
+    Answer& answer = answers[line.pv_[0]];
+    answer.move_ = line.pv_[1];
+    answer.score_ = -line.score_;
+    answer.depth_ = result.depth_ - 1;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  answers_.swap(answers);
+  depth_ = result.depth_;
+}
+
+auto Ponderer::Lookup(const std::string& reply, Answer* answer) const
+    -> bool {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = answers_.find(reply);
+  if (it == answers_.end()) {
+    return false;
+  }
+  *answer = it->second;
+  return true;
+}
+
+auto Ponderer::Replies() const -> std::vector<std::string> {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> replies;
+  for (const auto& entry : answers_) {
+    replies.push_back(entry.first);
+  }
+  return replies;
+}
+
+auto Ponderer::Depth() const -> size_t {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return depth_;
+}
+
+}  // namespace ponder
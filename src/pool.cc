@@ -0,0 +1,222 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/pool.h"
+
+#include <algorithm>
+
+namespace pool {
+
+namespace {
+
+// The pool and index of the worker running on this thread.
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local int current_index = -1;
+
+// xorshift64, for picking steal victims.
+auto NextRandom(uint64_t* seed) -> uint64_t {
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  return *seed;
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t threads, bool pin_threads)
+    : injected_count_(0), queued_(0), sleepers_(0), stop_(false) {
+  if (threads == 0) {
+    threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  if (pin_threads) {
+    const numa::Topology topology = numa::Topology::Detect();
+    Start(threads, &topology);
+  } else {
+    Start(threads, nullptr);
+  }
+}
+
+ThreadPool::ThreadPool(size_t threads, const numa::Topology& topology)
+    : injected_count_(0), queued_(0), sleepers_(0), stop_(false) {
+  Start(threads ? threads : topology.Cpus(), &topology);
+}
+
+void ThreadPool::Start(size_t threads, const numa::Topology* topology) {
+  // Every deque exists before any worker can try to steal from it.
+  for (size_t i = 0; i < threads; i++) {
+    workers_.emplace_back(new Worker());
+  }
+  for (size_t i = 0; i < threads; i++) {
+    const int cpu = topology ? static_cast<int>(topology->CpuFor(i)) : -1;
+    workers_[i]->thread_ = std::thread(&ThreadPool::WorkerLoop, this, i, cpu);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_.store(true);
+  }
+  wake_.notify_all();
+  for (const std::unique_ptr<Worker>& worker : workers_) {
+    worker->thread_.join();
+  }
+}
+
+auto ThreadPool::WorkerIndex() const -> int {
+  return current_pool == this ? current_index : -1;
+}
+
+void ThreadPool::Submit(std::function<void()> fn) {
+  Push(new Task{std::move(fn), nullptr});
+}
+
+void ThreadPool::Push(Task* task) {
+  const int self = WorkerIndex();
+  if (self >= 0) {
+    workers_[self]->deque_.Push(task);
+  } else {
+    std::lock_guard<std::mutex> lock(mutex_);
+    injected_.push_back(task);
+    injected_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Either a worker going to sleep sees the task, or we see the sleeper
+  // and wake it.
+  queued_.fetch_add(1);
+  if (sleepers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_.notify_one();
+  }
+}
+
+auto ThreadPool::Take(int self, uint64_t* seed) -> Task* {
+  Task* task = nullptr;
+  if (self >= 0) {
+    task = workers_[self]->deque_.Pop();
+  }
+  if (!task && queued_.load(std::memory_order_relaxed) > 0) {
+    if (injected_count_.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!injected_.empty()) {
+        task = injected_.front();
+        injected_.pop_front();
+        injected_count_.fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+    // Try every other deque once, starting from a random victim.
+    const size_t n = workers_.size();
+    const size_t start = NextRandom(seed) % n;
+    for (size_t i = 0; !task && i < n; i++) {
+      const size_t victim = (start + i) % n;
+      if (static_cast<int>(victim) != self) {
+        task = workers_[victim]->deque_.Steal();
+      }
+    }
+  }
+  if (task) {
+    queued_.fetch_sub(1);
+  }
+  return task;
+}
+
+void ThreadPool::Execute(Task* task) {
+  TaskGroup* group = task->group_;
+  std::function<void()> fn = std::move(task->fn_);
+  delete task;
+  if (!group) {
+    fn();
+    return;
+  }
+  if (!group->Cancelled()) {
+    try {
+      fn();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(group->mutex_);
+      if (!group->error_) {
+        group->error_ = std::current_exception();
+      }
+    }
+  }
+  // The group may be destroyed as soon as its count drops, so the task's
+  // captures go first.
+  fn = nullptr;
+  group->pending_.fetch_sub(1, std::memory_order_release);
+}
+
+auto ThreadPool::RunOne(uint64_t* seed) -> bool {
+  Task* task = Take(WorkerIndex(), seed);
+  if (!task) {
+    return false;
+  }
+  Execute(task);
+  return true;
+}
+
+void ThreadPool::WorkerLoop(size_t index, int cpu) {
+  current_pool = this;
+  current_index = static_cast<int>(index);
+  if (cpu >= 0) {
+    numa::PinThread(static_cast<size_t>(cpu));
+  }
+  uint64_t seed = 0x9E3779B97F4A7C15ULL * (index + 1);
+  while (true) {
+    Task* task = Take(static_cast<int>(index), &seed);
+    if (task) {
+      Execute(task);
+      continue;
+    }
+    // Spin briefly before sleeping: fork-join tasks tend to come in bursts.
+    bool found = false;
+    for (int spin = 0; spin < 64 && !found; spin++) {
+      found = queued_.load(std::memory_order_relaxed) > 0;
+      std::this_thread::yield();
+    }
+    if (found) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    sleepers_.fetch_add(1);
+    wake_.wait(lock, [this] { return stop_.load() || queued_.load() > 0; });
+    sleepers_.fetch_sub(1);
+    if (stop_.load() && queued_.load() == 0) {
+      return;
+    }
+  }
+}
+
+TaskGroup::TaskGroup(ThreadPool* pool)
+    : pool_(pool), pending_(0), cancelled_(false) {}
+
+TaskGroup::~TaskGroup() {
+  try {
+    Wait();
+  } catch (...) {
+  }
+}
+
+void TaskGroup::Run(std::function<void()> fn) {
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  pool_->Push(new ThreadPool::Task{std::move(fn), this});
+}
+
+void TaskGroup::Wait() {
+  uint64_t seed = reinterpret_cast<uintptr_t>(this) | 1;
+  while (pending_.load(std::memory_order_acquire) > 0) {
+    if (!pool_->RunOne(&seed)) {
+      std::this_thread::yield();
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void TaskGroup::Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+auto TaskGroup::Cancelled() const -> bool {
+  return cancelled_.load(std::memory_order_relaxed);
+}
+
+}  // namespace pool
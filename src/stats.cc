@@ -0,0 +1,171 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/stats.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+namespace stats {
+
+namespace {
+
+auto Ratio(uint64_t part, uint64_t whole) -> double {
+  return whole ? static_cast<double>(part) / static_cast<double>(whole) : 0;
+}
+
+auto NowNs() -> int64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+void SearchStats::Add(const SearchStats& other) {
+  nodes_ += other.nodes_;
+  quiescence_nodes_ += other.quiescence_nodes_;
+  hash_probes_ += other.hash_probes_;
+  hash_hits_ += other.hash_hits_;
+  for (size_t i = 0; i < kMoveIndices; i++) {
+    cutoffs_[i] += other.cutoffs_[i];
+  }
+  null_move_tries_ += other.null_move_tries_;
+  null_move_cutoffs_ += other.null_move_cutoffs_;
+  threads_ += other.threads_;
+}
+
+auto SearchStats::Cutoffs() const -> uint64_t {
+  uint64_t total = 0;
+  for (uint64_t c : cutoffs_) {
+    total += c;
+  }
+  return total;
+}
+
+auto SearchStats::FirstMoveCutoffRate() const -> double {
+  return Ratio(cutoffs_[0], Cutoffs());
+}
+
+auto SearchStats::HashHitRate() const -> double {
+  return Ratio(hash_hits_, hash_probes_);
+}
+
+auto SearchStats::NullMoveSuccessRate() const -> double {
+  return Ratio(null_move_cutoffs_, null_move_tries_);
+}
+
+auto SearchStats::NodesPerSecond() const -> double {
+  return seconds_ > 0 ? static_cast<double>(nodes_) / seconds_ : 0;
+}
+
+auto SearchStats::EffectiveBranchingFactor() const -> double {
+  // Iterations too small to time are skipped.
+  const Iteration* first = nullptr;
+  const Iteration* last = nullptr;
+  for (const Iteration& it : iterations_) {
+    if (it.nodes_ == 0) {
+      continue;
+    }
+    if (!first) {
+      first = &it;
+    }
+    last = &it;
+  }
+  if (!first || last->depth_ == first->depth_) {
+    return 0;
+  }
+  return std::pow(Ratio(last->nodes_, first->nodes_),
+                  1.0 / static_cast<double>(last->depth_ - first->depth_));
+}
+
+void SearchStats::WriteJson(std::ostream& out) const {
+  const std::ios::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(4);
+  out << "{\"threads\":" << threads_ << ",\"seconds\":" << seconds_
+      << ",\"nodes\":" << nodes_ << ",\"nps\":"
+      << static_cast<uint64_t>(NodesPerSecond())
+      << ",\"quiescence_nodes\":" << quiescence_nodes_
+      << ",\"hash_probes\":" << hash_probes_
+      << ",\"hash_hits\":" << hash_hits_
+      << ",\"hash_hit_rate\":" << HashHitRate() << ",\"cutoffs\":[";
+  for (size_t i = 0; i < kMoveIndices; i++) {
+    out << (i ? "," : "") << cutoffs_[i];
+  }
+  out << "],\"first_move_cutoff_rate\":" << FirstMoveCutoffRate()
+      << ",\"null_move_tries\":" << null_move_tries_
+      << ",\"null_move_cutoffs\":" << null_move_cutoffs_
+      << ",\"null_move_success_rate\":" << NullMoveSuccessRate()
+      << ",\"effective_branching_factor\":" << EffectiveBranchingFactor()
+      << ",\"iterations\":[";
+  for (size_t i = 0; i < iterations_.size(); i++) {
+    const Iteration& it = iterations_[i];
+    out << (i ? "," : "") << "{\"depth\":" << it.depth_
+        << ",\"nodes\":" << it.nodes_ << ",\"seconds\":" << it.seconds_
+        << ",\"elapsed\":" << it.elapsed_ << "}";
+  }
+  out << "]}";
+  out.flags(flags);
+  out.precision(precision);
+}
+
+Counters::Counters() { Start(); }
+
+void Counters::Start() {
+  for (std::atomic<uint64_t>* c :
+       {&nodes_, &quiescence_nodes_, &hash_probes_, &hash_hits_,
+        &null_move_tries_, &null_move_cutoffs_}) {
+    c->store(0, std::memory_order_relaxed);
+  }
+  for (std::atomic<uint64_t>& c : cutoffs_) {
+    c.store(0, std::memory_order_relaxed);
+  }
+  start_ns_.store(NowNs(), std::memory_order_relaxed);
+  finish_ns_.store(0, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  iterations_.clear();
+  iteration_start_nodes_ = 0;
+}
+
+void Counters::Finish() {
+  finish_ns_.store(NowNs(), std::memory_order_relaxed);
+}
+
+auto Counters::Elapsed() const -> double {
+  const int64_t finish = finish_ns_.load(std::memory_order_relaxed);
+  return static_cast<double>((finish ? finish : NowNs()) -
+                             start_ns_.load(std::memory_order_relaxed)) /
+         1e9;
+}
+
+void Counters::CompleteIteration(size_t depth) {
+  Iteration it;
+  it.depth_ = depth;
+  it.nodes_ = Nodes() - iteration_start_nodes_;
+  it.elapsed_ = Elapsed();
+  std::lock_guard<std::mutex> lock(mutex_);
+  it.seconds_ =
+      it.elapsed_ - (iterations_.empty() ? 0 : iterations_.back().elapsed_);
+  iterations_.push_back(it);
+  iteration_start_nodes_ = Nodes();
+}
+
+auto Counters::Snapshot() const -> SearchStats {
+  SearchStats s;
+  s.nodes_ = Nodes();
+  s.quiescence_nodes_ = quiescence_nodes_.load(std::memory_order_relaxed);
+  s.hash_probes_ = hash_probes_.load(std::memory_order_relaxed);
+  s.hash_hits_ = hash_hits_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < kMoveIndices; i++) {
+    s.cutoffs_[i] = cutoffs_[i].load(std::memory_order_relaxed);
+  }
+  s.null_move_tries_ = null_move_tries_.load(std::memory_order_relaxed);
+  s.null_move_cutoffs_ = null_move_cutoffs_.load(std::memory_order_relaxed);
+  s.seconds_ = Elapsed();
+  std::lock_guard<std::mutex> lock(mutex_);
+  s.iterations_ = iterations_;
+  return s;
+}
+
+}  // namespace stats
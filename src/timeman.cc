@@ -0,0 +1,81 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/timeman.h"
+
+#include <algorithm>
+
+namespace timeman {
+
+namespace {
+
+// Without a time control, plan as if this many moves remained.
+const int64_t kDefaultMovesToGo = 30;
+// The hard limit is this many times the soft one, within the time left.
+const int64_t kHardFactor = 4;
+// An iteration usually takes longer than all the previous ones together, so
+// none starts after this share of the soft limit.
+const double kIterationShare = 0.6;
+// Soft limit scale by the number of iterations the best move has held,
+// capped at the last entry: more time while it changes, less once settled.
+const double kStabilityScale[] = {1.6, 1.2, 1.0, 0.8, 0.6, 0.5};
+const size_t kStabilityLevels =
+    sizeof(kStabilityScale) / sizeof(kStabilityScale[0]);
+
+}  // namespace
+
+TimeManager::TimeManager(Clock::time_point start, int64_t soft_ms,
+                         int64_t hard_ms, bool scale)
+    : start_(start), soft_ms_(soft_ms),
+      hard_(start + std::chrono::milliseconds(hard_ms)), scale_(scale),
+      best_move_(0), stable_iterations_(0) {}
+
+TimeManager::TimeManager(const TimeControl& control)
+    : TimeManager(Clock::now(), 0, 0, true) {
+  const int64_t moves_to_go =
+      control.moves_to_go_ ? static_cast<int64_t>(control.moves_to_go_)
+                           : kDefaultMovesToGo;
+  const int64_t available =
+      std::max<int64_t>(control.time_ms_ - control.overhead_ms_, 1);
+  soft_ms_ = std::min(available / moves_to_go + control.increment_ms_ * 3 / 4,
+                      available);
+  // available already keeps the overhead in reserve.
+  const int64_t hard_ms = std::min(soft_ms_ * kHardFactor, available);
+  soft_ms_ = std::min(soft_ms_, hard_ms);
+  hard_ = start_ + std::chrono::milliseconds(hard_ms);
+}
+
+auto TimeManager::FixedTime(int64_t move_time_ms) -> TimeManager {
+  return TimeManager(Clock::now(), move_time_ms, move_time_ms, false);
+}
+
+auto TimeManager::StartIteration(uint16_t best_move) -> bool {
+  if (best_move == best_move_) {
+    stable_iterations_++;
+  } else {
+    best_move_ = best_move;
+    stable_iterations_ = 0;
+  }
+  const int64_t elapsed = ElapsedMs();
+  if (!scale_) {
+    return elapsed < soft_ms_;
+  }
+  const double scale =
+      kStabilityScale[std::min(stable_iterations_, kStabilityLevels - 1)];
+  return static_cast<double>(elapsed) <
+             static_cast<double>(soft_ms_) * scale * kIterationShare &&
+         Clock::now() < hard_;
+}
+
+auto TimeManager::ElapsedMs() const -> int64_t {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             Clock::now() - start_).count();
+}
+
+auto TimeManager::SoftLimitMs() const -> int64_t { return soft_ms_; }
+
+auto TimeManager::HardLimitMs() const -> int64_t {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(hard_ - start_)
+      .count();
+}
+
+}  // namespace timeman
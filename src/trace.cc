@@ -0,0 +1,153 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+struct Event {
+  const char* name;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+};
+
+// Single producer ring buffer. Only the owning thread writes events; head_
+// is published with release semantics so exporters see complete events.
+struct ThreadBuffer {
+  explicit ThreadBuffer(size_t id) : tid(id), head(0) {}
+  size_t tid;
+  std::atomic<uint64_t> head;
+  Event events[kBufferSize];
+};
+
+std::atomic<bool> enabled(false);
+const std::chrono::steady_clock::time_point epoch =
+    std::chrono::steady_clock::now();
+std::mutex registry_mutex;
+// Buffers of every thread that ever recorded an event. Buffers are never
+// freed so that events of exited threads can still be exported.
+std::vector<ThreadBuffer*>& Registry() {
+  static std::vector<ThreadBuffer*>* registry =
+      new std::vector<ThreadBuffer*>();
+  return *registry;
+}
+
+// Buffers of exited threads. A thread recording its first event takes one
+// over, keeping its events until they are overwritten, so that threads
+// started per search don't each hold on to a buffer of their own.
+std::vector<ThreadBuffer*>& FreeList() {
+  static std::vector<ThreadBuffer*>* free_list =
+      new std::vector<ThreadBuffer*>();
+  return *free_list;
+}
+
+// Returns the thread's buffer to the free list when the thread exits.
+struct BufferOwner {
+  ~BufferOwner() {
+    if (buffer != nullptr) {
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      FreeList().push_back(buffer);
+    }
+  }
+  ThreadBuffer* buffer = nullptr;
+};
+
+auto CurrentBuffer() -> ThreadBuffer* {
+  thread_local BufferOwner owner;
+  if (owner.buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    if (FreeList().empty()) {
+      owner.buffer = new ThreadBuffer(Registry().size() + 1);
+      Registry().push_back(owner.buffer);
+    } else {
+      owner.buffer = FreeList().back();
+      FreeList().pop_back();
+    }
+  }
+  return owner.buffer;
+}
+
+// Writes a string as a JSON string literal.
+void WriteJsonString(std::ostream& out, const char* s) {
+  out << '"';
+  for (; *s != '\0'; s++) {
+    if (*s == '"' || *s == '\\') {
+      out << '\\';
+    }
+    out << *s;
+  }
+  out << '"';
+}
+
+}  // namespace
+
+void SetEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+
+auto IsEnabled() -> bool { return enabled.load(std::memory_order_relaxed); }
+
+auto Now() -> uint64_t {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - epoch)
+          .count());
+}
+
+void Record(const char* name, uint64_t start_ns, uint64_t duration_ns) {
+  ThreadBuffer* buffer = CurrentBuffer();
+  uint64_t head = buffer->head.load(std::memory_order_relaxed);
+  buffer->events[head % kBufferSize] = {name, start_ns, duration_ns};
+  buffer->head.store(head + 1, std::memory_order_release);
+}
+
+Scope::Scope(const char* name)
+    : name_(name), active_(IsEnabled()), start_ns_(active_ ? Now() : 0) {}
+
+Scope::~Scope() {
+  if (active_) {
+    Record(name_, start_ns_, Now() - start_ns_);
+  }
+}
+
+void Clear() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (ThreadBuffer* buffer : Registry()) {
+    // Only safe against a concurrently recording thread in the sense that
+    // the thread's next events land after the cleared ones.
+    buffer->head.store(0, std::memory_order_release);
+  }
+}
+
+void WriteChromeTrace(std::ostream& out) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (ThreadBuffer* buffer : Registry()) {
+    uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t begin = head > kBufferSize ? head - kBufferSize : 0;
+    for (uint64_t i = begin; i < head; i++) {
+      Event e = buffer->events[i % kBufferSize];
+      // Skip events the owning thread overwrote while we were reading.
+      if (buffer->head.load(std::memory_order_acquire) - i > kBufferSize) {
+        continue;
+      }
+      out << (first ? "" : ",") << "\n{\"name\":";
+      WriteJsonString(out, e.name);
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+          << ",\"ts\":" << static_cast<double>(e.start_ns) / 1000.0
+          << ",\"dur\":" << static_cast<double>(e.duration_ns) / 1000.0
+          << "}";
+      first = false;
+    }
+  }
+  out << "\n]}\n";
+}
+
+}  // namespace trace
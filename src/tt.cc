@@ -0,0 +1,264 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/tt.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+namespace tt {
+
+namespace {
+
+// Entry data layout: depth in bits 0-7, bound in bits 8-9, generation in
+// bits 10-15 and the value in bits 16-63. Generations start at 1, so a
+// stored entry never has zero data.
+const unsigned kBoundShift = 8;
+const unsigned kGenerationShift = 10;
+const unsigned kValueShift = 16;
+const uint8_t kGenerations = 64;
+// Clear(pool) hands out at least this much of the table at a time.
+const size_t kClearShareBytes = 1 << 20;
+
+auto DepthOf(uint64_t data) -> uint8_t { return data & 0xFF; }
+auto BoundOf(uint64_t data) -> Bound {
+  return static_cast<Bound>((data >> kBoundShift) & 3);
+}
+auto GenerationOf(uint64_t data) -> uint8_t {
+  return (data >> kGenerationShift) & (kGenerations - 1);
+}
+
+}  // namespace
+
+auto PackSearch(const SearchValue& v) -> uint64_t {
+  return uint64_t{v.move_} | uint64_t{static_cast<uint16_t>(v.score_)} << 16 |
+         uint64_t{static_cast<uint16_t>(v.eval_)} << 32;
+}
+
+auto UnpackSearch(uint64_t value) -> SearchValue {
+  SearchValue v;
+  v.move_ = static_cast<uint16_t>(value);
+  v.score_ = static_cast<int16_t>(static_cast<uint16_t>(value >> 16));
+  v.eval_ = static_cast<int16_t>(static_cast<uint16_t>(value >> 32));
+  return v;
+}
+
+auto PackMove(size_t fx, size_t fy, size_t tx, size_t ty) -> uint16_t {
+  return static_cast<uint16_t>((fx + 8 * fy) << 6 | (tx + 8 * ty));
+}
+
+Table::Table(size_t megabytes, bool huge_pages)
+    : buckets_(nullptr), num_buckets_(0), mapped_(false), huge_pages_(false),
+      generation_(1) {
+  Allocate(megabytes, huge_pages);
+}
+
+Table::~Table() { Free(); }
+
+void Table::Resize(size_t megabytes, bool huge_pages) {
+  Free();
+  Allocate(megabytes, huge_pages);
+}
+
+void Table::Allocate(size_t megabytes, bool huge_pages) {
+  num_buckets_ = 1;
+  while (num_buckets_ * 2 * sizeof(Bucket) <= megabytes << 20) {
+    num_buckets_ *= 2;
+  }
+  const size_t bytes = Bytes();
+  void* memory = nullptr;
+#if defined(__unix__) || defined(__APPLE__)
+#ifdef MAP_HUGETLB
+  // Explicit huge pages need pages reserved by the administrator, so fall
+  // back quietly when there are none.
+  if (huge_pages) {
+    memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory == MAP_FAILED) {
+      memory = nullptr;
+    } else {
+      huge_pages_ = true;
+    }
+  }
+#endif
+  if (!memory) {
+    memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    // Otherwise ask for transparent huge pages.
+    if (huge_pages && madvise(memory, bytes, MADV_HUGEPAGE) == 0) {
+      huge_pages_ = true;
+    }
+#endif
+  }
+  mapped_ = true;
+#else
+  (void)huge_pages;
+  // Over-allocate so the buckets can start on a cache line, keeping the
+  // start of the allocation just before them for Free.
+  void* raw = std::malloc(bytes + sizeof(Bucket) + sizeof(void*));
+  if (!raw) {
+    throw std::bad_alloc();
+  }
+  uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) +
+                       sizeof(Bucket) - 1) & ~uintptr_t{sizeof(Bucket) - 1};
+  memory = reinterpret_cast<void*>(aligned);
+  reinterpret_cast<void**>(memory)[-1] = raw;
+  mapped_ = false;
+#endif
+  buckets_ = static_cast<Bucket*>(memory);
+  for (size_t i = 0; i < num_buckets_; i++) {
+    new (&buckets_[i]) Bucket;
+  }
+  if (mapped_) {
+    // A fresh mapping reads as zeros, which are empty entries. Leaving its
+    // pages untouched lets whoever clears it first decide where they go.
+    generation_.store(1, std::memory_order_relaxed);
+  } else {
+    Clear();
+  }
+}
+
+void Table::Free() {
+  if (!buckets_) {
+    return;
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapped_) {
+    munmap(buckets_, Bytes());
+  }
+#else
+  std::free(reinterpret_cast<void**>(buckets_)[-1]);
+#endif
+  buckets_ = nullptr;
+  huge_pages_ = false;
+}
+
+void Table::Clear() {
+  for (size_t i = 0; i < num_buckets_; i++) {
+    for (Slot& slot : buckets_[i].slots_) {
+      slot.key_.store(0, std::memory_order_relaxed);
+      slot.data_.store(0, std::memory_order_relaxed);
+    }
+  }
+  generation_.store(1, std::memory_order_relaxed);
+}
+
+void Table::Clear(pool::ThreadPool* pool) {
+  // Small shares, so that workers which finish early take more of them and
+  // every worker touches some.
+  const size_t share = std::max<size_t>(
+      kClearShareBytes / sizeof(Bucket),
+      (num_buckets_ + 4 * pool->Size() - 1) / (4 * pool->Size()));
+  pool::TaskGroup group(pool);
+  for (size_t begin = 0; begin < num_buckets_; begin += share) {
+    const size_t end = std::min(begin + share, num_buckets_);
+    group.Run([this, begin, end] {
+      for (size_t i = begin; i < end; i++) {
+        for (Slot& slot : buckets_[i].slots_) {
+          slot.key_.store(0, std::memory_order_relaxed);
+          slot.data_.store(0, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+  group.Wait();
+  generation_.store(1, std::memory_order_relaxed);
+}
+
+auto Table::Interleave(const numa::Topology& topology) -> bool {
+  return mapped_ && numa::Interleave(buckets_, Bytes(), topology);
+}
+
+void Table::NewSearch() {
+  const uint8_t generation = generation_.load(std::memory_order_relaxed);
+  generation_.store(
+      static_cast<uint8_t>(generation % (kGenerations - 1) + 1),
+      std::memory_order_relaxed);
+}
+
+auto Table::BucketFor(uint64_t key) const -> Bucket* {
+  return &buckets_[key & (num_buckets_ - 1)];
+}
+
+auto Table::Probe(uint64_t key, Entry* out) const -> bool {
+  for (const Slot& slot : BucketFor(key)->slots_) {
+    const uint64_t data = slot.data_.load(std::memory_order_relaxed);
+    if (data != 0 &&
+        (slot.key_.load(std::memory_order_relaxed) ^ data) == key) {
+      out->value_ = data >> kValueShift;
+      out->depth_ = DepthOf(data);
+      out->bound_ = BoundOf(data);
+      return true;
+    }
+  }
+  return false;
+}
+
+void Table::Store(uint64_t key, const Entry& entry) {
+  const uint8_t generation = generation_.load(std::memory_order_relaxed);
+  Bucket* bucket = BucketFor(key);
+  Slot* victim = nullptr;
+  int victim_worth = 0;
+  for (Slot& slot : bucket->slots_) {
+    const uint64_t data = slot.data_.load(std::memory_order_relaxed);
+    if (data == 0) {
+      // An empty slot, unless the key turns up later in the bucket.
+      victim = &slot;
+      victim_worth = std::numeric_limits<int>::min();
+      continue;
+    }
+    if ((slot.key_.load(std::memory_order_relaxed) ^ data) == key) {
+      // Keep a much deeper result of the current search over a shallow
+      // one, unless the new one is exact.
+      if (GenerationOf(data) == generation &&
+          entry.bound_ != Bound::kExact && entry.depth_ + 4 < DepthOf(data)) {
+        return;
+      }
+      victim = &slot;
+      break;
+    }
+    // Otherwise replace the shallowest entry, counting each search of age
+    // as eight plies of depth.
+    const int age = (generation - GenerationOf(data)) & (kGenerations - 1);
+    const int worth = DepthOf(data) - 8 * age;
+    if (!victim || worth < victim_worth) {
+      victim = &slot;
+      victim_worth = worth;
+    }
+  }
+  const uint64_t data = (entry.value_ & kMaxValue) << kValueShift |
+                        uint64_t{generation} << kGenerationShift |
+                        uint64_t{static_cast<uint8_t>(entry.bound_)}
+                            << kBoundShift |
+                        entry.depth_;
+  victim->key_.store(key ^ data, std::memory_order_relaxed);
+  victim->data_.store(data, std::memory_order_relaxed);
+}
+
+auto Table::Hashfull() const -> size_t {
+  const uint8_t generation = generation_.load(std::memory_order_relaxed);
+  const size_t sample = num_buckets_ < 250 ? num_buckets_ : 250;
+  size_t used = 0;
+  for (size_t i = 0; i < sample; i++) {
+    for (const Slot& slot : buckets_[i].slots_) {
+      const uint64_t data = slot.data_.load(std::memory_order_relaxed);
+      if (data != 0 && GenerationOf(data) == generation) {
+        used++;
+      }
+    }
+  }
+  return used * 1000 / (sample * 4);
+}
+
+auto Table::Bytes() const -> size_t { return num_buckets_ * sizeof(Bucket); }
+
+}  // namespace tt
@@ -0,0 +1,438 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/uci.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+namespace uci {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int64_t kMaxHashMb = 65536;
+const int64_t kMaxThreads = 512;
+const int64_t kMaxMultiPv = 256;
+const int64_t kMaxOverheadMs = 5000;
+
+auto Split(const std::string& line) -> std::vector<std::string> {
+  std::vector<std::string> words;
+  std::istringstream in(line);
+  std::string word;
+  while (in >> word) {
+    words.push_back(word);
+  }
+  return words;
+}
+
+auto Lower(std::string s) -> std::string {
+  std::transform(s.begin(), s.end(), s.begin(), [](char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  });
+  return s;
+}
+
+// Parses a whole number and clamps it to [min, max]. Throws
+// std::invalid_argument if it is not one.
+auto ParseNumber(const std::string& s, int64_t min, int64_t max) -> int64_t {
+  size_t end = 0;
+  const int64_t n = std::stoll(s, &end);
+  if (end != s.size()) {
+    throw std::invalid_argument("not a number: " + s);
+  }
+  return std::min(std::max(n, min), max);
+}
+
+// Plays the move, given in UCI notation, if it is legal.
+auto PlayUci(game::Game* game, const std::string& uci) -> bool {
+  for (const game::Move& move : game->LegalMoves(game->turn_)) {
+    if (game::ToUci(move) == uci) {
+      return game->PlayTurn(move);
+    }
+  }
+  return false;
+}
+
+// True if the move, in UCI notation, takes a pawn to its last rank. The
+// game doesn't promote: the pawn stays a pawn there.
+auto Promotes(const game::Game& game, const std::string& uci) -> bool {
+  if (uci.size() != 4 || (uci[3] != '1' && uci[3] != '8')) {
+    return false;
+  }
+  const size_t x = static_cast<size_t>(uci[0] - 'a');
+  const size_t y = static_cast<size_t>(uci[1] - '1');
+  const piece::Piece* p = game.board_->At(x, y)->piece_;
+  return p && p->type_ == piece::PieceType::kPawn;
+}
+
+// The line from the game's position as a GUI can read it. A pawn reaching
+// the last rank is sent as a queen's promotion, the nearest move UCI has,
+// and ends the line, since the rest assumes it stayed a pawn.
+auto ForGui(game::Game game, const std::vector<std::string>& pv)
+    -> std::vector<std::string> {
+  std::vector<std::string> line;
+  for (const std::string& move : pv) {
+    if (Promotes(game, move)) {
+      line.push_back(move + "q");
+      break;
+    }
+    line.push_back(move);
+    if (!PlayUci(&game, move)) {
+      break;
+    }
+  }
+  return line;
+}
+
+}  // namespace
+
+auto FormatScore(int score) -> std::string {
+  const int mate_bound = engine::kMateScore - static_cast<int>(engine::kMaxPly);
+  if (std::abs(score) < mate_bound) {
+    return "cp " + std::to_string(score);
+  }
+  // Mate in n plies scores kMateScore - n; UCI counts moves.
+  const int moves = (engine::kMateScore - std::abs(score) + 1) / 2;
+  return "mate " + std::to_string(score > 0 ? moves : -moves);
+}
+
+Engine::Engine(std::ostream* out)
+    : out_(out),
+      game_(new game::Game(0)),
+      threads_(1),
+      overhead_ms_(timeman::TimeControl().overhead_ms_),
+      stop_requested_(false),
+      hold_(false),
+      silent_(false),
+      pondering_(false) {}
+
+Engine::~Engine() { Stop(true); }
+
+void Engine::Run(std::istream* in) {
+  std::string line;
+  while (std::getline(*in, line)) {
+    if (!Handle(line)) {
+      return;
+    }
+  }
+  // Piped input ends with its last command: let a search with limits
+  // finish, as if its output were awaited.
+  bool unlimited;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unlimited = hold_;
+  }
+  if (unlimited) {
+    Stop();
+  } else {
+    Wait();
+  }
+}
+
+auto Engine::Handle(const std::string& line) -> bool {
+  std::vector<std::string> args = Split(line);
+  if (args.empty()) {
+    return true;
+  }
+  const std::string command = args[0];
+  args.erase(args.begin());
+  if (command == "uci") {
+    Uci();
+  } else if (command == "isready") {
+    Send("readyok");
+  } else if (command == "ucinewgame") {
+    Stop();
+    table_.Clear();
+  } else if (command == "setoption") {
+    SetOption(args);
+  } else if (command == "position") {
+    Position(args);
+  } else if (command == "go") {
+    Go(args);
+  } else if (command == "stop") {
+    Stop();
+  } else if (command == "ponderhit") {
+    PonderHit();
+  } else if (command == "quit") {
+    Stop();
+    return false;
+  } else {
+    Send("info string unknown command " + command);
+  }
+  return true;
+}
+
+void Engine::Wait() {
+  if (thread_.joinable()) {
+    thread_.join();
+    searcher_.reset();
+  }
+}
+
+void Engine::Send(const std::string& line) {
+  std::lock_guard<std::mutex> lock(out_mutex_);
+  *out_ << line << std::endl;
+}
+
+void Engine::Uci() {
+  Send("id name Chess");
+  Send("id author Andrea Roy");
+  Send("option name Hash type spin default " +
+       std::to_string(table_.Bytes() >> 20) + " min 1 max " +
+       std::to_string(kMaxHashMb));
+  Send("option name Threads type spin default 1 min 1 max " +
+       std::to_string(kMaxThreads));
+  Send("option name MultiPV type spin default 1 min 1 max " +
+       std::to_string(kMaxMultiPv));
+  Send("option name Ponder type check default false");
+  Send("option name Move Overhead type spin default " +
+       std::to_string(overhead_ms_) + " min 0 max " +
+       std::to_string(kMaxOverheadMs));
+  Send("option name Clear Hash type button");
+  Send("uciok");
+}
+
+void Engine::SetOption(const std::vector<std::string>& args) {
+  // "name" and "value" may both be several words.
+  std::string name;
+  std::string value;
+  std::string* field = nullptr;
+  for (const std::string& arg : args) {
+    if (arg == "name") {
+      field = &name;
+    } else if (arg == "value") {
+      field = &value;
+    } else if (field) {
+      *field += (field->empty() ? "" : " ") + arg;
+    }
+  }
+  // Options are only set between searches, but be safe.
+  Stop();
+  const std::string option = Lower(name);
+  try {
+    if (option == "hash") {
+      table_.Resize(static_cast<size_t>(ParseNumber(value, 1, kMaxHashMb)));
+    } else if (option == "threads") {
+      threads_ = static_cast<size_t>(ParseNumber(value, 1, kMaxThreads));
+    } else if (option == "multipv") {
+      options_.multi_pv_ =
+          static_cast<size_t>(ParseNumber(value, 1, kMaxMultiPv));
+    } else if (option == "ponder") {
+      // Only says the GUI may send "go ponder"; nothing to change.
+    } else if (option == "move overhead") {
+      overhead_ms_ = ParseNumber(value, 0, kMaxOverheadMs);
+    } else if (option == "clear hash") {
+      table_.Clear();
+    } else {
+      Send("info string unknown option " + name);
+    }
+  } catch (const std::exception&) {
+    Send("info string bad value for " + name + ": " + value);
+  }
+}
+
+void Engine::Position(const std::vector<std::string>& args) {
+  std::unique_ptr<game::Game> game;
+  size_t i = 1;
+  try {
+    if (!args.empty() && args[0] == "startpos") {
+      game.reset(new game::Game(0));
+    } else if (!args.empty() && args[0] == "fen") {
+      std::string fen;
+      for (; i < args.size() && args[i] != "moves"; i++) {
+        fen += (fen.empty() ? "" : " ") + args[i];
+      }
+      game.reset(new game::Game(fen, 0));
+    } else {
+      Send("info string position needs startpos or fen");
+      return;
+    }
+  } catch (const std::invalid_argument& e) {
+    Send(std::string("info string ") + e.what());
+    return;
+  }
+  if (i < args.size() && args[i] == "moves") {
+    for (i++; i < args.size(); i++) {
+      if (args[i].size() == 5) {
+        // The game can't promote, so no later position would match the
+        // GUI's: refuse the position rather than search another one.
+        Send("info string promotion unsupported: " + args[i]);
+        game_.reset();
+        return;
+      }
+      if (!PlayUci(game.get(), args[i])) {
+        Send("info string illegal move " + args[i]);
+        break;
+      }
+    }
+  }
+  game_ = std::move(game);
+}
+
+void Engine::Go(const std::vector<std::string>& args) {
+  if (!game_) {
+    Stop();
+    Send("info string no position to search");
+    Send("bestmove 0000");
+    return;
+  }
+  engine::Limits limits;
+  limits.clock_.overhead_ms_ = overhead_ms_;
+  const bool white = game_->turn_ == game_->white_;
+  bool infinite = false;
+  bool ponder = false;
+  try {
+    for (size_t i = 0; i < args.size(); i++) {
+      const std::string& arg = args[i];
+      if (arg == "infinite") {
+        infinite = true;
+        continue;
+      }
+      if (arg == "ponder") {
+        ponder = true;
+        continue;
+      }
+      // The rest take a number; "searchmoves" and its moves are ignored.
+      if (i + 1 == args.size()) {
+        break;
+      }
+      const std::string& value = args[i + 1];
+      if (arg == (white ? "wtime" : "btime")) {
+        // A flagging clock still leaves a move to make.
+        limits.clock_.time_ms_ = ParseNumber(value, 1, INT64_MAX);
+      } else if (arg == (white ? "winc" : "binc")) {
+        limits.clock_.increment_ms_ = ParseNumber(value, 0, INT64_MAX);
+      } else if (arg == "movestogo") {
+        limits.clock_.moves_to_go_ =
+            static_cast<size_t>(ParseNumber(value, 0, INT64_MAX));
+      } else if (arg == "depth") {
+        limits.depth_ = static_cast<size_t>(
+            ParseNumber(value, 1, static_cast<int64_t>(engine::kMaxPly)));
+      } else if (arg == "nodes") {
+        limits.nodes_ = static_cast<uint64_t>(ParseNumber(value, 1, INT64_MAX));
+      } else if (arg == "movetime") {
+        limits.move_time_ms_ = ParseNumber(value, 1, INT64_MAX);
+      } else if (arg == "mate") {
+        // Mate in n moves is found within 2n - 1 plies.
+        limits.depth_ = static_cast<size_t>(ParseNumber(
+            value, 1, static_cast<int64_t>(engine::kMaxPly) / 2) * 2 - 1);
+      } else {
+        continue;
+      }
+      i++;
+    }
+  } catch (const std::exception&) {
+    Send("info string bad go arguments");
+    return;
+  }
+  Stop();
+  if (ponder) {
+    // The opponent's move is a guess until "ponderhit": think without
+    // limits, then search again with them, the table keeping the work.
+    ponder_limits_ = limits;
+    pondering_ = true;
+    engine::Limits pondering;
+    pondering.depth_ = limits.depth_;
+    Launch(pondering, true);
+  } else {
+    Launch(limits, infinite);
+  }
+}
+
+void Engine::Launch(engine::Limits limits, bool hold) {
+  searcher_.reset(
+      new engine::ParallelSearcher(*game_, threads_, &table_, options_));
+  stop_requested_ = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hold_ = hold;
+    silent_ = false;
+  }
+  const Clock::time_point start = Clock::now();
+  // Lines are sent from the search's thread, while game_ may be replaced.
+  const std::shared_ptr<const game::Game> root(new game::Game(*game_));
+  limits.on_iteration_ = [this, start, root](const engine::Result& result) {
+    SendInfo(*root, result, start);
+    if (stop_requested_) {
+      searcher_->Stop();
+    }
+  };
+  limits.on_stats_ = [this](const stats::SearchStats&) {
+    if (stop_requested_) {
+      searcher_->Stop();
+    }
+  };
+  thread_ = std::thread([this, limits, root] {
+    const engine::Result result = searcher_->Search(limits);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      released_.wait(lock, [this] { return !hold_; });
+      if (silent_) {
+        return;
+      }
+    }
+    // Result::pv_ is in the game's own notation; the lines are UCI.
+    const std::vector<std::string> pv =
+        result.lines_.empty() ? std::vector<std::string>()
+                              : ForGui(*root, result.lines_[0].pv_);
+    std::string best = "bestmove " + (pv.empty() ? "0000" : pv[0]);
+    if (pv.size() > 1) {
+      best += " ponder " + pv[1];
+    }
+    Send(best);
+  });
+}
+
+void Engine::Stop(bool silent) {
+  pondering_ = false;
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hold_ = false;
+    silent_ = silent;
+  }
+  released_.notify_all();
+  stop_requested_ = true;
+  searcher_->Stop();
+  thread_.join();
+  searcher_.reset();
+}
+
+void Engine::PonderHit() {
+  if (!pondering_) {
+    return;
+  }
+  Stop(true);
+  Launch(ponder_limits_, false);
+}
+
+void Engine::SendInfo(const game::Game& root, const engine::Result& result,
+                      Clock::time_point start) {
+  const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Clock::now() - start).count();
+  const uint64_t nodes = searcher_->Stats().nodes_;
+  const uint64_t nps =
+      ms > 0 ? nodes * 1000 / static_cast<uint64_t>(ms) : nodes * 1000;
+  for (size_t i = 0; i < result.lines_.size(); i++) {
+    const engine::Line& line = result.lines_[i];
+    std::ostringstream info;
+    info << "info depth " << result.depth_;
+    if (options_.multi_pv_ > 1) {
+      info << " multipv " << i + 1;
+    }
+    info << " score " << FormatScore(line.score_) << " nodes " << nodes
+         << " nps " << nps << " time " << ms << " pv";
+    for (const std::string& move : ForGui(root, line.pv_)) {
+      info << " " << move;
+    }
+    Send(info.str());
+  }
+}
+
+}  // namespace uci
@@ -0,0 +1,77 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include "chess/zobrist.h"
+
+#include "chess/board.h"
+
+namespace zobrist {
+
+namespace {
+
+const size_t kPieceTypes = 6;
+const size_t kColors = 2;
+
+struct Keys {
+  Keys() {
+    // Fixed seed so that keys, and anything stored by key, are the same on
+    // every run.
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    auto next = [&state]() {
+      // splitmix64
+      uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    };
+    for (auto& color : pieces) {
+      for (auto& type : color) {
+        for (uint64_t& key : type) {
+          key = next();
+        }
+      }
+    }
+    side = next();
+    uint64_t rights[4];
+    for (uint64_t& key : rights) {
+      key = next();
+    }
+    for (unsigned mask = 0; mask < 16; mask++) {
+      castling[mask] = 0;
+      for (unsigned bit = 0; bit < 4; bit++) {
+        if (mask & (1u << bit)) {
+          castling[mask] ^= rights[bit];
+        }
+      }
+    }
+    for (uint64_t& key : en_passant) {
+      key = next();
+    }
+  }
+  uint64_t pieces[kColors][kPieceTypes][board::kSize * board::kSize];
+  uint64_t side;
+  uint64_t castling[16];
+  uint64_t en_passant[board::kSize];
+};
+
+auto Get() -> const Keys& {
+  static const Keys keys;
+  return keys;
+}
+
+}  // namespace
+
+auto PieceKey(piece::PieceType t, piece::Color c, size_t x, size_t y)
+    -> uint64_t {
+  return Get().pieces[static_cast<size_t>(c)][static_cast<size_t>(t)]
+                     [x + y * board::kSize];
+}
+
+auto SideKey() -> uint64_t { return Get().side; }
+
+auto CastlingKey(unsigned rights) -> uint64_t {
+  return Get().castling[rights & 15];
+}
+
+auto EnPassantKey(size_t file) -> uint64_t { return Get().en_passant[file]; }
+
+}  // namespace zobrist
@@ -0,0 +1,158 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/bitbase.h>
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+
+// KQK, KRK and KPK, generated once.
+auto TestTables() -> const bitbase::Tables& {
+  static bitbase::Tables tables = [] {
+    pool::ThreadPool pool(2);
+    bitbase::Tables generated;
+    generated.Generate("KRK", &pool);
+    generated.Generate("KPK", &pool);
+    return generated;
+  }();
+  return tables;
+}
+
+auto Probe(const std::string& fen) -> bitbase::Wdl {
+  return TestTables().Probe(game::Game(fen, 0));
+}
+
+// A FEN with the pieces on the squares and the rest empty.
+auto Fen(const std::string& pieces, const size_t* squares, bool white_to_move)
+    -> std::string {
+  char board[64];
+  std::fill(board, board + 64, '.');
+  for (size_t i = 0; i < pieces.size(); i++) {
+    board[squares[i]] = pieces[i];
+  }
+  std::string fen;
+  for (size_t y = 8; y-- > 0;) {
+    size_t empty = 0;
+    for (size_t x = 0; x < 8; x++) {
+      if (board[x + 8 * y] == '.') {
+        empty++;
+        continue;
+      }
+      if (empty) {
+        fen += static_cast<char>('0' + empty);
+        empty = 0;
+      }
+      fen += board[x + 8 * y];
+    }
+    if (empty) {
+      fen += static_cast<char>('0' + empty);
+    }
+    fen += y ? "/" : "";
+  }
+  return fen + (white_to_move ? " w - - 0 1" : " b - - 0 1");
+}
+
+}  // namespace
+
+TEST_CASE("Endgame Bitbases", "[bitbase]") {
+  using bitbase::Wdl;
+
+  SECTION("Names put the stronger side first") {
+    REQUIRE(bitbase::CanonicalName("KPKR") == "KRKP");
+    REQUIRE(bitbase::CanonicalName("KNBK") == "KBNK");
+    REQUIRE(bitbase::CanonicalName("KQKQ") == "KQKQ");
+    REQUIRE_THROWS(bitbase::CanonicalName("KQRBK"));
+    REQUIRE_THROWS(bitbase::CanonicalName("QKK"));
+  }
+
+  SECTION("Promotion generates the queen's endgame first") {
+    REQUIRE(TestTables().Find("KQK"));
+    REQUIRE(TestTables().Size() == 3);
+    // A queen or a rook always wins with its side to move.
+    REQUIRE(TestTables().Find("KQK")->Generated(true).draws_ == 0);
+    REQUIRE(TestTables().Find("KRK")->Generated(true).draws_ == 0);
+  }
+
+  SECTION("King and pawn against king") {
+    // The king in front of its pawn on the sixth wins either way.
+    REQUIRE(Probe("4k3/8/4K3/4P3/8/8/8/8 w - - 0 1") == Wdl::kWin);
+    REQUIRE(Probe("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1") == Wdl::kLoss);
+    REQUIRE(Probe("8/8/8/8/8/4k3/4P3/4K3 w - - 0 1") == Wdl::kDraw);
+    // A rook pawn draws with the king in the corner, and wins when the
+    // king is outside the pawn's square.
+    REQUIRE(Probe("k7/8/8/8/8/8/P7/K7 w - - 0 1") == Wdl::kDraw);
+    REQUIRE(Probe("7k/8/8/8/8/8/P7/K7 w - - 0 1") == Wdl::kWin);
+  }
+
+  SECTION("Colors reversed and kings alone") {
+    REQUIRE(Probe("kr6/8/8/8/3K4/8/8/8 b - - 0 1") == Wdl::kWin);
+    REQUIRE(Probe("kr6/8/8/8/3K4/8/8/8 w - - 0 1") == Wdl::kLoss);
+    REQUIRE(Probe("8/8/8/8/8/8/1k6/K7 w - - 0 1") == Wdl::kDraw);
+    REQUIRE(Probe("8/8/8/8/8/8/1k6/KB6 w - - 0 1") == Wdl::kUnknown);
+    REQUIRE(Probe("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1") ==
+            Wdl::kUnknown);
+  }
+
+  SECTION("Agrees with the game's moves") {
+    // A position is won if a move reaches a lost one, lost if every move
+    // reaches a won one, and otherwise drawn.
+    std::mt19937_64 random(7);
+    size_t checked = 0;
+    while (checked < 300) {
+      size_t squares[3];
+      for (size_t& sq : squares) {
+        sq = random() % 64;
+      }
+      const bool white_to_move = random() % 2 == 0;
+      const std::string pieces = random() % 2 ? "KkR" : "KkP";
+      // The game doesn't promote, so pawns stay off the seventh rank.
+      if (squares[0] == squares[1] || squares[0] == squares[2] ||
+          squares[1] == squares[2] ||
+          (pieces[2] == 'P' && (squares[2] < 16 || squares[2] >= 48))) {
+        continue;
+      }
+      game::Game game(Fen(pieces, squares, white_to_move), 0);
+      game::Player* waiting = game.turn_ == game.white_ ? game.black_ : game.white_;
+      if (waiting->IsKingInCheck()) {
+        continue;
+      }
+      const Wdl wdl = TestTables().Probe(game);
+      bool any_lost = false;
+      bool all_won = true;
+      for (const game::Move& m : game.LegalMoves(game.turn_)) {
+        game.PlayTurn(m);
+        const Wdl next = TestTables().Probe(game);
+        any_lost = any_lost || next == Wdl::kLoss;
+        all_won = all_won && next == Wdl::kWin;
+        game.UndoTurn();
+      }
+      const bool in_check = game.turn_->IsKingInCheck();
+      const bool no_moves = game.LegalMoves(game.turn_).empty();
+      Wdl expected = any_lost ? Wdl::kWin : all_won ? Wdl::kLoss : Wdl::kDraw;
+      if (no_moves) {
+        expected = in_check ? Wdl::kLoss : Wdl::kDraw;
+      }
+      REQUIRE(wdl == expected);
+      checked++;
+    }
+  }
+
+  SECTION("Files map back what was written") {
+    const bitbase::Bitbase* generated = TestTables().Find("KPK");
+    generated->Write("KPK.bb");
+    bitbase::Tables loaded;
+    REQUIRE(loaded.Load(".") == 1);
+    std::remove("KPK.bb");
+    REQUIRE(loaded.Find("KPK")->Bytes() == generated->Bytes());
+    size_t squares[3] = {4, 60, 12};
+    for (size_t sq = 8; sq < 56; sq++) {
+      squares[2] = sq;
+      REQUIRE(loaded.Find("KPK")->Probe(squares, true) ==
+              generated->Probe(squares, true));
+    }
+    REQUIRE_THROWS(bitbase::Bitbase::Load("no-such-file.bb"));
+  }
+}
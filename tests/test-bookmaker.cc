@@ -0,0 +1,101 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/bookmaker.h>
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace {
+
+const char* const kGames =
+    "[Result \"1-0\"]\n1. e4 e5 2. Nf3 Nc6 1-0\n"
+    "[Result \"0-1\"]\n1. e4 c5 2. Nf3 d6 0-1\n"
+    "[Result \"1/2-1/2\"]\n1. d4 d5 1/2-1/2\n"
+    "[Result \"1-0\"]\n1. e4 e5 2. Bc4 Nc6 1-0\n"
+    "[Result \"*\"]\n1. c4 *\n"
+    "[FEN \"4k3/8/8/8/8/8/8/4K3 w - - 0 1\"]\n1. Kd2 1-0\n"
+    "[Result \"0-1\"]\n1. e4 e5 2. Nf3 Nf6 3. Qh9 0-1\n";
+
+auto Build(const bookmaker::Options& options, const std::string& path)
+    -> bookmaker::Report {
+  pool::ThreadPool pool(2);
+  bookmaker::Builder builder(options);
+  std::istringstream in(kGames);
+  builder.Read(&in, &pool);
+  return builder.Write(path);
+}
+
+auto Contents(const std::string& path) -> std::string {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+auto Weight(const polyglot::Book& book, const game::Game& game,
+            const std::string& uci) -> int {
+  for (const polyglot::BookMove& m : book.Probe(game)) {
+    if (polyglot::Decode(m.move_, game) == uci) {
+      return m.weight_;
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
+TEST_CASE("Opening Book Builder", "[bookmaker]") {
+  bookmaker::Options options;
+  options.batch_ = 2;
+
+  SECTION("Moves are weighted by the half points they scored") {
+    const bookmaker::Report report = Build(options, "made.bin");
+    std::unique_ptr<polyglot::Book> book = polyglot::Book::Open("made.bin");
+    std::remove("made.bin");
+    REQUIRE(report.games_ == 5);
+    REQUIRE(report.skipped_ == 2);
+    REQUIRE(report.truncated_ == 1);
+    REQUIRE(report.moves_ == 4 + 4 + 2 + 4 + 4);
+    REQUIRE(report.runs_ == 0);
+    REQUIRE(report.entries_ == book->Size());
+
+    game::Game game(0);
+    // 1. e4 won twice and lost twice; 1. d4 drew.
+    REQUIRE(book->Probe(game).size() == 2);
+    REQUIRE(Weight(*book, game, "e2e4") == 4);
+    REQUIRE(Weight(*book, game, "d2d4") == 1);
+    game::Move e4;
+    REQUIRE(pgn::ParseSan(&game, "e4", &e4));
+    game.PlayTurn(e4);
+    REQUIRE(Weight(*book, game, "e7e5") == 2);
+    REQUIRE(Weight(*book, game, "c7c5") == 2);
+  }
+
+  SECTION("Rarely played moves can be left out") {
+    options.min_games_ = 2;
+    Build(options, "made.bin");
+    std::unique_ptr<polyglot::Book> book = polyglot::Book::Open("made.bin");
+    std::remove("made.bin");
+    game::Game game(0);
+    REQUIRE(book->Probe(game).size() == 1);
+    REQUIRE(Weight(*book, game, "d2d4") == -1);
+  }
+
+  SECTION("Spilling to run files writes the same book") {
+    Build(options, "memory.bin");
+    options.memory_mb_ = 0;
+    const bookmaker::Report report = Build(options, "spilled.bin");
+    REQUIRE(report.runs_ > 1);
+    REQUIRE(Contents("spilled.bin") == Contents("memory.bin"));
+    // Merged two runs at a time, in several passes.
+    options.fan_in_ = 2;
+    Build(options, "spilled.bin");
+    REQUIRE(Contents("spilled.bin") == Contents("memory.bin"));
+    REQUIRE_FALSE(Contents("memory.bin").empty());
+    std::remove("memory.bin");
+    std::remove("spilled.bin");
+  }
+}
@@ -0,0 +1,246 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/engine.h>
+#include <catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("Searcher Finds Mate In One", "[engine][search]") {
+  game::Game game("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 0);
+  engine::Searcher searcher(game);
+  engine::Limits limits;
+  limits.depth_ = 3;
+  engine::Result result = searcher.Search(limits);
+  REQUIRE(!result.pv_.empty());
+  REQUIRE(result.pv_[0] == "0007");
+  REQUIRE(result.score_ == engine::kMateScore - 1);
+}
+
+TEST_CASE("Searcher Takes Hanging Queen", "[engine][search]") {
+  game::Game game("4k3/8/8/3q4/8/8/3R4/4K3 w - - 0 1", 0);
+  engine::Searcher searcher(game);
+  engine::Limits limits;
+  limits.depth_ = 3;
+  engine::Result result = searcher.Search(limits);
+  REQUIRE(result.depth_ == 3);
+  REQUIRE(result.pv_[0] == "3134");
+  REQUIRE(result.score_ > 0);
+}
+
+TEST_CASE("Quiescence Search", "[engine][search][quiescence]") {
+  // Qxd6 wins a pawn at depth 1, but c7 recaptures past the horizon.
+  game::Game game("4k3/2p5/3p4/8/8/8/3Q4/4K3 w - - 0 1", 0);
+  engine::Limits limits;
+  limits.depth_ = 1;
+
+  SECTION("Without quiescence the horizon hides the recapture") {
+    engine::Options options;
+    options.quiescence_ = false;
+    engine::Searcher searcher(game, nullptr, options);
+    engine::Result result = searcher.Search(limits);
+    REQUIRE(result.pv_[0] == "3135");
+    REQUIRE(result.quiescence_nodes_ == 0);
+  }
+
+  SECTION("Quiescence search plays out the exchange") {
+    engine::Searcher searcher(game, nullptr);
+    engine::Result result = searcher.Search(limits);
+    REQUIRE(result.pv_[0] != "3135");
+    REQUIRE(result.quiescence_nodes_ > 0);
+    REQUIRE(result.score_ > 500);
+  }
+
+  SECTION("Check evasions are searched") {
+    // Rxa8 is mate. Without searching evasions, standing pat would hide it.
+    game::Game mate("r5k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 0);
+    engine::Searcher searcher(mate, nullptr);
+    engine::Result result = searcher.Search(limits);
+    REQUIRE(result.pv_[0] == "0007");
+    REQUIRE(result.score_ == engine::kMateScore - 1);
+  }
+}
+
+TEST_CASE("Selective Search", "[engine][search][pruning]") {
+  // Every pruning technique on, and each alone, still finds the tactics.
+  std::vector<engine::Options> variants(7);
+  variants[1].null_move_ = false;
+  variants[2].lmr_ = false;
+  variants[3].futility_ = false;
+  variants[4].reverse_futility_ = false;
+  variants[5].razoring_ = true;
+  variants[6].aspiration_ = false;
+  engine::Limits limits;
+  limits.depth_ = 5;
+  for (const engine::Options& options : variants) {
+    game::Game mate("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 0);
+    engine::Searcher mate_searcher(mate, nullptr, options);
+    engine::Result result = mate_searcher.Search(limits);
+    REQUIRE(result.pv_[0] == "0007");
+    REQUIRE(result.score_ == engine::kMateScore - 1);
+
+    tt::Table table(1);
+    game::Game queen("4k3/8/8/3q4/8/8/3R4/4K3 w - - 0 1", 0);
+    engine::Searcher queen_searcher(queen, &table, options);
+    result = queen_searcher.Search(limits);
+    REQUIRE(result.depth_ == 5);
+    REQUIRE(result.pv_[0] == "3134");
+  }
+
+  SECTION("Pruning searches fewer nodes") {
+    game::Game game("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/"
+                    "R3K2R w KQkq - 0 1", 0);
+    engine::Options full_width;
+    full_width.null_move_ = false;
+    full_width.lmr_ = false;
+    full_width.futility_ = false;
+    full_width.reverse_futility_ = false;
+    full_width.aspiration_ = false;
+    limits.depth_ = 4;
+    tt::Table table(1);
+    engine::Searcher pruned(game, &table);
+    const uint64_t pruned_nodes = pruned.Search(limits).nodes_;
+    table.Clear();
+    engine::Searcher full(game, &table, full_width);
+    REQUIRE(pruned_nodes < full.Search(limits).nodes_);
+  }
+}
+
+TEST_CASE("Searcher Limits", "[engine][search]") {
+  game::Game game(0);
+  engine::Searcher searcher(game);
+
+  SECTION("Node limit") {
+    engine::Limits limits;
+    limits.nodes_ = 2000;
+    engine::Result result = searcher.Search(limits);
+    REQUIRE(!result.pv_.empty());
+    // The limit is checked at every node.
+    REQUIRE(result.nodes_ <= 2000);
+  }
+
+  SECTION("Stop from another thread") {
+    engine::Result result;
+    std::thread worker([&] { result = searcher.Search(engine::Limits()); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    searcher.Stop();
+    worker.join();
+    REQUIRE(!result.pv_.empty());
+    REQUIRE(result.depth_ < engine::kMaxPly);
+  }
+
+  SECTION("Searching leaves the game untouched") {
+    engine::Limits limits;
+    limits.depth_ = 2;
+    searcher.Search(limits);
+    REQUIRE(game.moves_.empty());
+    REQUIRE(game.turn_ == game.white_);
+  }
+}
+
+TEST_CASE("Parallel Searcher", "[engine][search][smp]") {
+  game::Game game("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 0);
+  tt::Table table(1);
+  engine::ParallelSearcher searcher(game, 4, &table);
+  engine::Limits limits;
+  limits.depth_ = 3;
+  engine::Result result = searcher.Search(limits);
+  REQUIRE(!result.pv_.empty());
+  REQUIRE(result.pv_[0] == "0007");
+  REQUIRE(result.score_ == engine::kMateScore - 1);
+
+  SECTION("Stop from another thread") {
+    game::Game start(0);
+    engine::ParallelSearcher parallel(start, 3, &table);
+    std::thread worker([&] { result = parallel.Search(engine::Limits()); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    parallel.Stop();
+    worker.join();
+    REQUIRE(!result.pv_.empty());
+  }
+}
+
+TEST_CASE("Multi-PV Search", "[engine][search][multipv]") {
+  game::Game game("4k3/8/8/3q4/8/8/3R4/4K3 w - - 0 1", 0);
+  tt::Table table(1);
+  engine::Options options;
+  options.multi_pv_ = 3;
+  engine::Limits limits;
+  limits.depth_ = 4;
+
+  SECTION("Lines are distinct and best first") {
+    std::vector<size_t> depths;
+    limits.on_iteration_ = [&depths](const engine::Result& r) {
+      depths.push_back(r.depth_);
+      REQUIRE(r.lines_.size() == 3);
+    };
+    engine::Searcher searcher(game, &table, options);
+    const engine::Result result = searcher.Search(limits);
+    REQUIRE(depths == std::vector<size_t>({1, 2, 3, 4}));
+    REQUIRE(result.lines_.size() == 3);
+    REQUIRE(result.lines_[0].pv_[0] == "d2d5");
+    REQUIRE(result.lines_[0].score_ == result.score_);
+    REQUIRE(result.lines_[0].pv_.size() == result.pv_.size());
+    for (size_t i = 1; i < result.lines_.size(); i++) {
+      REQUIRE(result.lines_[i].score_ <= result.lines_[i - 1].score_);
+      for (size_t j = 0; j < i; j++) {
+        REQUIRE(result.lines_[i].pv_[0] != result.lines_[j].pv_[0]);
+      }
+    }
+  }
+
+  SECTION("No more lines than legal moves") {
+    options.multi_pv_ = 10;
+    engine::Searcher searcher(game::Game("7k/8/8/8/8/8/8/K7 w - - 0 1", 0),
+                              &table, options);
+    REQUIRE(searcher.Search(limits).lines_.size() == 3);
+  }
+
+  SECTION("A single line matches the principal variation") {
+    engine::Searcher searcher(game, &table);
+    const engine::Result result = searcher.Search(limits);
+    REQUIRE(result.lines_.size() == 1);
+    REQUIRE(result.lines_[0].pv_[0] ==
+            game::ToUci(game.GetMoveFromStr(result.pv_[0], game.turn_)));
+  }
+}
+
+TEST_CASE("Bitbases Score Endgames", "[engine][search][bitbase]") {
+  pool::ThreadPool pool(1);
+  bitbase::Tables tables;
+  tables.Generate("KRK", &pool);
+  // Taking the rook leaves a won rook endgame.
+  game::Game game("8/8/8/8/8/2k5/r7/R3K3 w - - 0 1", 0);
+  engine::Options options;
+  options.bitbases_ = &tables;
+  engine::Searcher searcher(game, nullptr, options);
+  engine::Limits limits;
+  limits.depth_ = 3;
+  const engine::Result result = searcher.Search(limits);
+  REQUIRE(result.pv_[0] == "0001");
+  REQUIRE(result.score_ >= engine::kKnownWin - 3);
+  REQUIRE(result.score_ <
+          engine::kMateScore - static_cast<int>(engine::kMaxPly));
+  REQUIRE(result.bitbase_hits_ > 0);
+}
+
+TEST_CASE("Pawn Bitbases Wait For Promotion", "[engine][search][bitbase]") {
+  pool::ThreadPool pool(1);
+  bitbase::Tables tables;
+  tables.Generate("KPK", &pool);
+  // Taking the knight leaves king and pawn against king, which the bitbase
+  // wins by promoting. The game can't promote, so it is searched instead.
+  game::Game game("4k3/8/4K3/8/3n4/4P3/8/8 w - - 0 1", 0);
+  game::Game taken = game;
+  taken.PlayTurn(taken.GetMoveFromStr("4233", taken.turn_));
+  REQUIRE(tables.Probe(taken) == bitbase::Wdl::kLoss);
+  engine::Options options;
+  options.bitbases_ = &tables;
+  engine::Searcher searcher(game, nullptr, options);
+  engine::Limits limits;
+  limits.depth_ = 3;
+  const engine::Result result = searcher.Search(limits);
+  REQUIRE(result.bitbase_hits_ == 0);
+  REQUIRE(result.score_ <
+          engine::kKnownWin - static_cast<int>(engine::kMaxPly));
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/engine.h>
+#include <chess/eval.h>
+#include <chess/game.h>
+#include <catch2/catch.hpp>
+
+namespace {
+
+auto Play(game::Game* game, const std::string& move) -> bool {
+  return game->PlayTurn(game->GetMoveFromStr(move, game->turn_));
+}
+
+}  // namespace
+
+TEST_CASE("Piece Square Tables", "[eval]") {
+  // Mirrored squares score the same for both colors.
+  for (size_t x = 0; x < 8; x++) {
+    for (size_t y = 0; y < 8; y++) {
+      eval::Score white = eval::PieceSquare(piece::PieceType::kKnight,
+                                            piece::Color::kWhite, x, y);
+      eval::Score black = eval::PieceSquare(piece::PieceType::kKnight,
+                                            piece::Color::kBlack, x, 7 - y);
+      REQUIRE(white.mg_ == black.mg_);
+      REQUIRE(white.eg_ == black.eg_);
+    }
+  }
+  eval::Score score;
+  score.mg_ = 100;
+  score.eg_ = -100;
+  REQUIRE(eval::Blend(score, eval::kMaxPhase) == 100);
+  REQUIRE(eval::Blend(score, 0) == -100);
+  REQUIRE(eval::Blend(score, eval::kMaxPhase / 2) == 0);
+}
+
+TEST_CASE("Incremental Evaluation", "[eval][game]") {
+  game::Game game(0);
+  REQUIRE(game.psq_.mg_ == 0);
+  REQUIRE(game.psq_.eg_ == 0);
+  REQUIRE(game.phase_ == eval::kMaxPhase);
+  REQUIRE(engine::Evaluate(game) == 0);
+
+  SECTION("Matches a full computation after every move and undo") {
+    // An en passant capture, a capture and castling on both sides.
+    for (const char* move :
+         {"4143", "0605", "4344", "5654", "4455", "6755", "6052", "4645",
+          "5023", "5746", "4060", "4767"}) {
+      REQUIRE(Play(&game, move));
+      REQUIRE(game.psq_.mg_ == game.ComputePieceSquare().mg_);
+      REQUIRE(game.psq_.eg_ == game.ComputePieceSquare().eg_);
+      REQUIRE(game.phase_ == game.ComputePhase());
+    }
+    while (game.UndoTurn()) {
+      REQUIRE(game.psq_.mg_ == game.ComputePieceSquare().mg_);
+      REQUIRE(game.phase_ == game.ComputePhase());
+    }
+    REQUIRE(game.psq_.mg_ == 0);
+  }
+
+  SECTION("Phase drops as pieces come off") {
+    game::Game ending("8/8/4k3/8/8/3K4/3R4/8 w - - 0 1", 0);
+    REQUIRE(ending.phase_ == 2);
+    // White is a rook up, scored from the side to move.
+    REQUIRE(engine::Evaluate(ending) > 400);
+  }
+}
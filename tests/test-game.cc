@@ -120,4 +120,53 @@ TEST_CASE("Test Illegal Game Moves", "[game][illegal]") {
      REQUIRE_FALSE(game.PlayTurn(game.white_->PlayMove(game.board_->At(1, 7),
                                         game.board_->At(0, 4), &game)));
   }
-}
\ No newline at end of file
+}
+TEST_CASE("Game From FEN", "[game][fen]") {
+  SECTION("Test Starting Position Matches Default Game") {
+    game::Game fen_game(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0);
+    game::Game game(0);
+    for (size_t i = 0; i < board::kSize; i++) {
+      for (size_t j = 0; j < board::kSize; j++) {
+        const board::Square* a = fen_game.board_->At(i, j);
+        const board::Square* b = game.board_->At(i, j);
+        REQUIRE(a->IsEmpty() == b->IsEmpty());
+        if (!a->IsEmpty()) {
+          REQUIRE(a->piece_->type_ == b->piece_->type_);
+          REQUIRE(a->piece_->color_ == b->piece_->color_);
+        }
+      }
+    }
+    REQUIRE(fen_game.turn_ == fen_game.white_);
+    REQUIRE(fen_game.white_->kingSquare_ == fen_game.board_->At(4, 0));
+  }
+  SECTION("Test Side To Move And En Passant") {
+    game::Game game(
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0);
+    REQUIRE(game.turn_ == game.white_);
+    REQUIRE(game.PlayTurn(game.white_->PlayMove(game.board_->At(4, 4),
+                                                game.board_->At(5, 5), &game)));
+    REQUIRE(game.board_->At(5, 4)->IsEmpty());
+    REQUIRE(game.turn_ == game.black_);
+  }
+  SECTION("Test Malformed FEN") {
+    REQUIRE_THROWS(game::Game("rnbqkbnr/pppppppp/8/8 w - - 0 1", 0));
+    REQUIRE_THROWS(game::Game("8/8/8/8/8/8/8/8 w - - 0 1", 0));
+    REQUIRE_THROWS(game::Game("8/8/4k3/8/8/3K4/3R4/8 x - - 0 1", 0));
+  }
+}
+
+TEST_CASE("Game Copy", "[game][copy]") {
+  game::Game original(0);
+  original.PlayTurn(original.white_->PlayMove(original.board_->At(4, 1),
+                                              original.board_->At(4, 3),
+                                              &original));
+  game::Game copy(original);
+  REQUIRE(copy.turn_ == copy.black_);
+  REQUIRE(copy.white_->kingSquare_ == copy.board_->At(4, 0));
+  REQUIRE(copy.board_->At(3, 7)->piece_->type_ == piece::PieceType::kQueen);
+  REQUIRE(copy.PlayTurn(copy.black_->PlayMove(copy.board_->At(4, 6),
+                                              copy.board_->At(4, 4), &copy)));
+  REQUIRE(original.board_->At(4, 6)->piece_ != nullptr);
+  REQUIRE(copy.board_->At(4, 6)->IsEmpty());
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/mate.h>
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// Plays the line and returns true if it is legal and ends in mate.
+auto EndsInMate(game::Game game, const std::vector<std::string>& line)
+    -> bool {
+  for (const std::string& uci : line) {
+    bool played = false;
+    for (const game::Move& m : game.LegalMoves(game.turn_)) {
+      if (game::ToUci(m) == uci) {
+        played = game.PlayTurn(m);
+        break;
+      }
+    }
+    if (!played) {
+      return false;
+    }
+  }
+  return game.LegalMoves(game.turn_).empty() && game.turn_->IsKingInCheck();
+}
+
+}  // namespace
+
+TEST_CASE("Proof-Number Mate Solver", "[mate]") {
+  mate::Solver solver;
+
+  SECTION("Back rank mate") {
+    const game::Game game("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 0);
+    const mate::Result result = solver.Solve(game, 1);
+    REQUIRE(result.mate_);
+    REQUIRE(result.solved_);
+    REQUIRE(result.pv_ == std::vector<std::string>{"a1a8"});
+  }
+
+  SECTION("Mate in three and none in two") {
+    const game::Game game("r5rk/5p1p/5R2/4B3/8/8/7P/7K w - - 0 1", 0);
+    const mate::Result two = solver.Solve(game, 2);
+    REQUIRE(two.solved_);
+    REQUIRE_FALSE(two.mate_);
+    const mate::Result three = solver.Solve(game, 3);
+    REQUIRE(three.mate_);
+    REQUIRE(three.pv_.size() <= 5);
+    REQUIRE(EndsInMate(game, three.pv_));
+    REQUIRE(solver.MateIn(game, 5) == 3);
+  }
+
+  SECTION("King and queen mate in nine") {
+    const game::Game game("8/8/8/3k4/8/8/8/KQ6 w - - 0 1", 0);
+    const mate::Result result = solver.Solve(game, 9);
+    REQUIRE(result.mate_);
+    REQUIRE(EndsInMate(game, result.pv_));
+  }
+
+  SECTION("Node limit") {
+    const game::Game game("8/8/8/3k4/8/8/8/KQ6 w - - 0 1", 0);
+    const mate::Result result = solver.Solve(game, 9, 100);
+    REQUIRE_FALSE(result.solved_);
+    REQUIRE_FALSE(result.mate_);
+  }
+
+  SECTION("A table too small for the search collects garbage") {
+    // Rook mates in seven through more positions than a megabyte holds.
+    const game::Game game("8/6k1/8/4K3/8/8/8/R7 w - - 0 1", 0);
+    mate::Solver small(1);
+    const mate::Result result = small.Solve(game, 7);
+    REQUIRE(result.mate_);
+    REQUIRE(result.collections_ > 0);
+    // The line is found again where collection dropped the proof's nodes.
+    REQUIRE(EndsInMate(game, result.pv_));
+  }
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/mcts.h>
+#include <catch2/catch.hpp>
+
+#include <string>
+
+TEST_CASE("Monte Carlo Tree Search", "[mcts]") {
+  mcts::Limits limits;
+  limits.playouts_ = 2000;
+
+  SECTION("Takes a hanging queen") {
+    mcts::Searcher searcher(
+        game::Game("4k3/8/8/3q4/8/8/3R4/4K3 w - - 0 1", 0));
+    const mcts::Result result = searcher.Search(limits);
+    REQUIRE(result.playouts_ == 2000);
+    REQUIRE(searcher.RootVisits() == 2000);
+    REQUIRE_FALSE(result.pv_.empty());
+    REQUIRE(result.pv_[0] == "d2d5");
+    REQUIRE(result.value_ > 0.5);
+    REQUIRE(result.nodes_ == searcher.Nodes());
+    REQUIRE(result.memory_bytes_ == result.nodes_ * sizeof(mcts::Node));
+  }
+
+  SECTION("Scores mate") {
+    // Back rank mate in one.
+    mcts::Searcher searcher(
+        game::Game("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 0));
+    const mcts::Result result = searcher.Search(limits);
+    REQUIRE(result.pv_[0] == "a1a8");
+    REQUIRE(result.value_ > 0.9);
+  }
+
+  SECTION("Threads share the playouts") {
+    mcts::Options options;
+    options.threads_ = 3;
+    mcts::Searcher searcher(game::Game(0), options);
+    const mcts::Result result = searcher.Search(limits);
+    REQUIRE(result.playouts_ == 2000);
+    REQUIRE(searcher.RootVisits() == 2000);
+    REQUIRE(result.pv_.size() > 1);
+  }
+
+  SECTION("The tree stays within its memory") {
+    mcts::Options options;
+    options.memory_mb_ = 1;
+    mcts::Searcher searcher(game::Game(0), options);
+    limits.playouts_ = 60000;
+    const mcts::Result result = searcher.Search(limits);
+    REQUIRE(result.memory_bytes_ <= (size_t(1) << 20));
+    REQUIRE(result.nodes_ + mcts::kMaxChildren > (size_t(1) << 20) /
+                                                     sizeof(mcts::Node));
+    REQUIRE(searcher.RootVisits() == 60000);
+  }
+
+  SECTION("Advancing keeps the subtree of the move") {
+    mcts::Searcher searcher(game::Game(0));
+    const mcts::Result result = searcher.Search(limits);
+    const size_t nodes = searcher.Nodes();
+    REQUIRE(searcher.Advance(result.pv_[0]));
+    REQUIRE(searcher.RootVisits() == result.visits_);
+    REQUIRE(searcher.Nodes() < nodes);
+    REQUIRE(searcher.Advance(result.pv_[1]));
+    // Searching again from the reused tree.
+    const mcts::Result next = searcher.Search(limits);
+    REQUIRE_FALSE(next.pv_.empty());
+    REQUIRE(searcher.RootVisits() >= 2000);
+
+    REQUIRE_THROWS(searcher.Advance("e2e5"));
+    mcts::Searcher fresh(game::Game(0));
+    REQUIRE_FALSE(fresh.Advance("e2e4"));
+    REQUIRE(fresh.Nodes() == 1);
+  }
+}
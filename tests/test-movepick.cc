@@ -0,0 +1,133 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/movepick.h>
+#include <catch2/catch.hpp>
+
+#include <set>
+
+namespace {
+
+auto MoveFromStr(game::Game& game, const std::string& str) -> game::Move {
+  return game.GetMoveFromStr(str, game.turn_);
+}
+
+}  // namespace
+
+TEST_CASE("Static Exchange Evaluation", "[movepick][see]") {
+  SECTION("Undefended piece") {
+    game::Game game("4k3/8/8/3q4/8/8/3R4/4K3 w - - 0 1", 0);
+    REQUIRE(movepick::See(game, MoveFromStr(game, "3134")) == 900);
+  }
+
+  SECTION("Defended pawn taken by a rook") {
+    game::Game game("4k3/8/2p5/3p4/8/8/3R4/4K3 w - - 0 1", 0);
+    REQUIRE(movepick::See(game, MoveFromStr(game, "3134")) == 100 - 500);
+  }
+
+  SECTION("Defended pawn taken by a pawn") {
+    game::Game game("4k3/8/2p5/3p4/4P3/8/8/4K3 w - - 0 1", 0);
+    REQUIRE(movepick::See(game, MoveFromStr(game, "4334")) == 0);
+  }
+
+  SECTION("Batteries count through x-rays") {
+    // Rxd5 cxd5 Rxd5 wins a pawn for the exchange of rooks for a pawn.
+    game::Game game("4k3/8/2p5/3p4/8/8/3R4/3RK3 w - - 0 1", 0);
+    REQUIRE(movepick::See(game, MoveFromStr(game, "3134")) == 100 - 500 + 100);
+  }
+}
+
+TEST_CASE("Move Picker Order", "[movepick]") {
+  // White can win the queen with the rook or lose it for a pawn.
+  game::Game game("4k3/8/2p5/3p4/8/1q6/1R1R4/4K3 w - - 0 1", 0);
+  const std::vector<game::Move> moves = game.LegalMoves(game.turn_);
+  movepick::Heuristics heuristics;
+  const game::Move hash = MoveFromStr(game, "4050");
+  movepick::MovePicker picker(game, moves, movepick::Pack(hash), heuristics,
+                              0);
+
+  std::vector<uint16_t> order;
+  game::Move m;
+  while (picker.Next(&m)) {
+    order.push_back(movepick::Pack(m));
+  }
+  // Every move exactly once.
+  REQUIRE(order.size() == moves.size());
+  REQUIRE(std::set<uint16_t>(order.begin(), order.end()).size() ==
+          moves.size());
+  // The hash move, then the good capture, and the losing capture last.
+  REQUIRE(order.front() == movepick::Pack(hash));
+  REQUIRE(order[1] == movepick::Pack(MoveFromStr(game, "1112")));
+  REQUIRE(order.back() == movepick::Pack(MoveFromStr(game, "3134")));
+
+  SECTION("Quiescence picker hands out only winning captures") {
+    const std::vector<game::Move> captures = game.LegalCaptures(game.turn_);
+    REQUIRE(captures.size() == 2);
+    movepick::MovePicker quiescence(game, captures, heuristics);
+    REQUIRE(quiescence.Next(&m));
+    REQUIRE(movepick::Pack(m) == movepick::Pack(MoveFromStr(game, "1112")));
+    REQUIRE(!quiescence.Next(&m));
+  }
+}
+
+TEST_CASE("Killer And History Heuristics", "[movepick]") {
+  game::Game game(0);
+  const std::vector<game::Move> moves = game.LegalMoves(game.turn_);
+  movepick::Heuristics heuristics;
+  const game::Move killer = MoveFromStr(game, "6052");
+  const game::Move tried = MoveFromStr(game, "4143");
+  heuristics.UpdateQuiet(game, killer, {tried}, 4, 3);
+  REQUIRE(heuristics.Killer(3, 0) == movepick::Pack(killer));
+  REQUIRE(heuristics.History(piece::Color::kWhite, killer) > 0);
+  REQUIRE(heuristics.History(piece::Color::kWhite, tried) < 0);
+
+  SECTION("Killers come first among quiet moves") {
+    movepick::MovePicker picker(game, moves, 0, heuristics, 3);
+    game::Move m;
+    REQUIRE(picker.Next(&m));
+    REQUIRE(movepick::Pack(m) == movepick::Pack(killer));
+  }
+
+  SECTION("History orders the other quiet moves") {
+    // At another ply the killer doesn't apply, but its history does.
+    movepick::MovePicker picker(game, moves, 0, heuristics, 5);
+    game::Move m;
+    REQUIRE(picker.Next(&m));
+    REQUIRE(movepick::Pack(m) == movepick::Pack(killer));
+    while (picker.Next(&m)) {
+      REQUIRE(movepick::Pack(m) != movepick::Pack(killer));
+    }
+    REQUIRE(movepick::Pack(m) == movepick::Pack(tried));
+  }
+
+  SECTION("History orders the quiet moves after the countermove") {
+    game::Game reply(0);
+    REQUIRE(reply.PlayTurn(MoveFromStr(reply, "4143")));
+    const game::Move preferred = MoveFromStr(reply, "7675");
+    const game::Move other = MoveFromStr(reply, "0605");
+    const game::Move counter = MoveFromStr(reply, "6755");
+    movepick::Heuristics learned;
+    learned.UpdateQuiet(reply, preferred, {}, 8, 3);
+    learned.UpdateQuiet(reply, other, {}, 2, 3);
+    // Last, so it is the countermove to e2e4.
+    learned.UpdateQuiet(reply, counter, {}, 1, 3);
+    REQUIRE(learned.Countermove(reply) == movepick::Pack(counter));
+    // No killers at this ply.
+    movepick::MovePicker picker(reply, reply.LegalMoves(reply.turn_), 0,
+                                learned, 5);
+    game::Move m;
+    REQUIRE(picker.Next(&m));
+    REQUIRE(movepick::Pack(m) == movepick::Pack(counter));
+    REQUIRE(picker.Next(&m));
+    REQUIRE(movepick::Pack(m) == movepick::Pack(preferred));
+    REQUIRE(picker.Next(&m));
+    REQUIRE(movepick::Pack(m) == movepick::Pack(other));
+  }
+
+  SECTION("History saturates") {
+    for (int i = 0; i < 1000; i++) {
+      heuristics.UpdateQuiet(game, killer, {}, 20, 3);
+    }
+    REQUIRE(heuristics.History(piece::Color::kWhite, killer) <=
+            movepick::kMaxHistory);
+  }
+}
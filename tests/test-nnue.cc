@@ -0,0 +1,106 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/engine.h>
+#include <chess/nnue.h>
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char kPath[] = "test-nnue.net";
+
+// A random network, written and mapped once. The file is removed right
+// away; the mapping outlives it.
+auto TestNetwork() -> const nnue::Network& {
+  static std::unique_ptr<nnue::Network> network = [] {
+    nnue::Network::WriteRandom(kPath, 42);
+    std::unique_ptr<nnue::Network> loaded = nnue::Network::Load(kPath);
+    std::remove(kPath);
+    return loaded;
+  }();
+  return *network;
+}
+
+auto Play(game::Game* game, const std::string& move) -> bool {
+  return game->PlayTurn(game->GetMoveFromStr(move, game->turn_));
+}
+
+auto Same(const nnue::Accumulator& a, const nnue::Accumulator& b) -> bool {
+  return std::memcmp(a.values_, b.values_, sizeof(a.values_)) == 0;
+}
+
+}  // namespace
+
+TEST_CASE("NNUE Accumulator", "[nnue]") {
+  const nnue::Network& network = TestNetwork();
+
+  SECTION("Incremental updates match a refresh") {
+    // A double push answered en passant, castling on both wings, a
+    // capture and king moves.
+    game::Game game("r3k2r/pppp1ppp/8/4P3/8/8/PPP2PPP/R3K2R b KQkq - 0 1",
+                    0);
+    std::vector<nnue::Accumulator> stack(1);
+    network.Refresh(game, &stack[0]);
+    for (const char* move : {"3634", "4435", "4767", "4020", "2635", "2010",
+                             "6777"}) {
+      REQUIRE(Play(&game, move));
+      stack.emplace_back();
+      network.Update(game, stack[stack.size() - 2], &stack.back());
+      nnue::Accumulator fresh;
+      network.Refresh(game, &fresh);
+      REQUIRE(Same(stack.back(), fresh));
+      REQUIRE(network.Evaluate(stack.back(), game.turn_->color_) ==
+              network.Evaluate(game));
+    }
+  }
+
+  SECTION("A null move keeps the accumulator") {
+    game::Game game(0);
+    nnue::Accumulator before;
+    nnue::Accumulator after;
+    network.Refresh(game, &before);
+    game.PlayNullMove();
+    network.Update(game, before, &after);
+    REQUIRE(Same(before, after));
+  }
+}
+
+TEST_CASE("NNUE Evaluation", "[nnue]") {
+  const nnue::Network& network = TestNetwork();
+
+  SECTION("Each side sees the board from its own side") {
+    const int white = network.Evaluate(game::Game(
+        "r1bqk1nr/pppp1ppp/2n5/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+        0));
+    const int black = network.Evaluate(game::Game(
+        "rnbqk2r/pppp1ppp/5n2/2b1p3/2B1P3/2N5/PPPP1PPP/R1BQK1NR b KQkq - 4 4",
+        0));
+    REQUIRE(white == black);
+  }
+
+  SECTION("Searches with the network") {
+    engine::Options options;
+    options.network_ = &network;
+    engine::Searcher searcher(game::Game(0), nullptr, options);
+    engine::Limits limits;
+    limits.depth_ = 3;
+    const engine::Result result = searcher.Search(limits);
+    REQUIRE(result.depth_ == 3);
+    REQUIRE_FALSE(result.pv_.empty());
+  }
+
+  SECTION("Files of another layout are rejected") {
+    REQUIRE_THROWS(nnue::Network::Load("missing.net"));
+    {
+      std::ofstream out(kPath, std::ios::binary);
+      out << "CHNN";
+    }
+    REQUIRE_THROWS(nnue::Network::Load(kPath));
+    std::remove(kPath);
+  }
+}
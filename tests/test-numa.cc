@@ -0,0 +1,107 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/numa.h>
+#include <chess/pool.h>
+#include <chess/tt.h>
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TEST_CASE("NUMA Placement", "[numa]") {
+  // Two sockets of four CPUs, hyperthreads numbered after the cores.
+  const numa::Topology two_sockets(
+      std::vector<numa::Node>{{0, {0, 1, 8, 9}}, {1, {2, 3, 10, 11}}});
+
+  SECTION("CPU lists") {
+    const std::vector<size_t> ranges = {0, 1, 2, 3, 8, 9, 10, 11};
+    REQUIRE(numa::ParseCpuList("0-3,8-11\n") == ranges);
+    REQUIRE(numa::ParseCpuList("5") == std::vector<size_t>(1, 5));
+    REQUIRE(numa::ParseCpuList("\n").empty());
+    REQUIRE_THROWS(numa::ParseCpuList("3-1"));
+    REQUIRE_THROWS(numa::ParseCpuList("a-b"));
+  }
+
+  SECTION("Workers go round-robin over the nodes") {
+    REQUIRE(two_sockets.Cpus() == 8);
+    std::vector<size_t> cpus;
+    for (size_t worker = 0; worker < 5; worker++) {
+      cpus.push_back(two_sockets.CpuFor(worker));
+    }
+    const std::vector<size_t> expected = {0, 2, 1, 3, 8};
+    REQUIRE(cpus == expected);
+    REQUIRE(two_sockets.NodeFor(3) == 1);
+    // Past the CPUs, workers double up.
+    REQUIRE(two_sockets.CpuFor(8) == 0);
+    const numa::Topology one_socket = two_sockets.Restrict(1);
+    REQUIRE(one_socket.Nodes().size() == 1);
+    REQUIRE(one_socket.CpuFor(1) == 1);
+  }
+
+#if defined(__unix__) || defined(__APPLE__)
+  SECTION("Nodes are read from sysfs") {
+    mkdir("numa-test", 0755);
+    mkdir("numa-test/node0", 0755);
+    mkdir("numa-test/node2", 0755);
+    mkdir("numa-test/node3", 0755);
+    std::ofstream("numa-test/online") << "0,2-3\n";
+    std::ofstream("numa-test/node0/cpulist") << "0-1\n";
+    std::ofstream("numa-test/node2/cpulist") << "2-3\n";
+    // A node of memory alone.
+    std::ofstream("numa-test/node3/cpulist") << "\n";
+    const numa::Topology read = numa::Topology::Read("numa-test");
+    REQUIRE(read.Nodes().size() == 2);
+    REQUIRE(read.Nodes()[1].id_ == 2);
+    const std::vector<size_t> node2 = {2, 3};
+    REQUIRE(read.Nodes()[1].cpus_ == node2);
+    for (const char* file :
+         {"numa-test/online", "numa-test/node0/cpulist",
+          "numa-test/node2/cpulist", "numa-test/node3/cpulist"}) {
+      std::remove(file);
+    }
+    for (const char* dir : {"numa-test/node0", "numa-test/node2",
+                            "numa-test/node3", "numa-test"}) {
+      rmdir(dir);
+    }
+    REQUIRE_THROWS(numa::Topology::Read("no-such-directory"));
+  }
+#endif
+
+  SECTION("The machine's topology is usable") {
+    const numa::Topology machine = numa::Topology::Detect();
+    REQUIRE(machine.Cpus() > 0);
+    std::atomic<size_t> ran(0);
+    {
+      pool::ThreadPool pinned(2, machine);
+      pool::TaskGroup group(&pinned);
+      for (size_t i = 0; i < 8; i++) {
+        group.Run([&ran] { ran++; });
+      }
+      group.Wait();
+    }
+    REQUIRE(ran.load() == 8);
+  }
+
+  SECTION("Tables can be cleared by a pool") {
+    tt::Table table(1);
+    tt::Entry entry;
+    entry.value_ = 7;
+    entry.depth_ = 3;
+    table.Store(42, entry);
+    REQUIRE(table.Probe(42, &entry));
+    pool::ThreadPool workers(2);
+    table.Clear(&workers);
+    REQUIRE_FALSE(table.Probe(42, &entry));
+    // A single node has nothing to interleave over.
+    const numa::Topology one_node(std::vector<numa::Node>{{0, {0}}});
+    REQUIRE_FALSE(table.Interleave(one_node));
+  }
+}
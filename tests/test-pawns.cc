@@ -0,0 +1,104 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/pawns.h>
+#include <catch2/catch.hpp>
+
+#include <string>
+
+namespace {
+
+auto Play(game::Game* game, const std::string& move) -> bool {
+  return game->PlayTurn(game->GetMoveFromStr(move, game->turn_));
+}
+
+auto Structure(const std::string& fen) -> eval::Score {
+  return pawns::Compute(game::Game(fen, 0)).score_;
+}
+
+}  // namespace
+
+TEST_CASE("Pawn Key", "[pawns][zobrist]") {
+  game::Game game(0);
+  REQUIRE(game.pawn_key_ == game.ComputePawnKey());
+  const uint64_t start = game.pawn_key_;
+
+  SECTION("Only pawn moves change it") {
+    REQUIRE(Play(&game, "6052"));
+    REQUIRE(game.pawn_key_ == start);
+    REQUIRE(Play(&game, "4644"));
+    REQUIRE(game.pawn_key_ != start);
+    REQUIRE(game.pawn_key_ == game.ComputePawnKey());
+    game.UndoTurn();
+    REQUIRE(game.pawn_key_ == start);
+  }
+
+  SECTION("Captures of pawns update it") {
+    for (const char* move : {"4143", "3634", "4334"}) {
+      REQUIRE(Play(&game, move));
+      REQUIRE(game.pawn_key_ == game.ComputePawnKey());
+    }
+  }
+}
+
+TEST_CASE("Pawn Structure", "[pawns]") {
+  SECTION("Symmetric structures cancel out") {
+    const eval::Score score = Structure(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    REQUIRE(score.mg_ == 0);
+    REQUIRE(score.eg_ == 0);
+  }
+
+  SECTION("Passed pawns gain as they advance") {
+    const eval::Score far = Structure("4k3/8/1P6/8/8/8/8/4K3 w - - 0 1");
+    const eval::Score near = Structure("4k3/8/8/8/1P6/8/8/4K3 w - - 0 1");
+    REQUIRE(far.eg_ > near.eg_);
+    REQUIRE(near.eg_ > 0);
+    // An enemy pawn on a neighbouring file ahead stops it being passed.
+    const eval::Score stopped =
+        Structure("4k3/2p5/8/8/1P6/8/8/4K3 w - - 0 1");
+    REQUIRE(stopped.eg_ < near.eg_);
+  }
+
+  SECTION("Doubled and isolated pawns are penalised") {
+    const eval::Score healthy =
+        Structure("4k3/pp6/8/8/8/8/PP6/4K3 w - - 0 1");
+    const eval::Score doubled =
+        Structure("4k3/pp6/8/8/8/1P6/1P6/4K3 w - - 0 1");
+    const eval::Score isolated =
+        Structure("4k3/pp6/8/8/8/8/P6P/4K3 w - - 0 1");
+    REQUIRE(healthy.mg_ == 0);
+    REQUIRE(doubled.mg_ < healthy.mg_);
+    REQUIRE(isolated.mg_ < healthy.mg_);
+  }
+
+  SECTION("Backward pawns are penalised") {
+    // d3 can't be supported by c4 or e4, and e5 covers d4.
+    const eval::Score backward =
+        Structure("4k3/8/8/4p3/2P1P3/3P4/8/4K3 w - - 0 1");
+    const eval::Score supported =
+        Structure("4k3/8/8/4p3/2P1P3/8/3P4/4K3 w - - 0 1");
+    REQUIRE(backward.mg_ < supported.mg_);
+  }
+
+  SECTION("King shelter") {
+    const game::Game sheltered(
+        "6k1/5ppp/8/8/8/8/5PPP/6K1 w - - 0 1", 0);
+    const game::Game exposed("6k1/5ppp/8/8/8/8/8/6K1 w - - 0 1", 0);
+    REQUIRE(pawns::Shelter(pawns::Compute(sheltered), sheltered).mg_ == 0);
+    REQUIRE(pawns::Shelter(pawns::Compute(exposed), exposed).mg_ < 0);
+  }
+}
+
+TEST_CASE("Pawn Hash Table", "[pawns]") {
+  game::Game game(0);
+  pawns::Table table(64);
+  const eval::Score first = pawns::Evaluate(game, &table);
+  REQUIRE(table.hits_ == 0);
+  // Piece moves keep the pawn key, so the entry is reused.
+  REQUIRE(Play(&game, "6052"));
+  const eval::Score second = pawns::Evaluate(game, &table);
+  REQUIRE(table.probes_ == 2);
+  REQUIRE(table.hits_ == 1);
+  REQUIRE(second.mg_ == first.mg_);
+  REQUIRE(table.Probe(game).score_.eg_ == pawns::Compute(game).score_.eg_);
+}
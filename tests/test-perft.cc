@@ -0,0 +1,48 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/perft.h>
+#include <catch2/catch.hpp>
+
+// Reference counts from https://www.chessprogramming.org/Perft_Results
+TEST_CASE("Perft Start Position", "[perft]") {
+  game::Game game(0);
+  REQUIRE(perft::Perft(game, 1) == 20);
+  REQUIRE(perft::Perft(game, 2) == 400);
+  REQUIRE(perft::Perft(game, 3) == 8902);
+}
+
+TEST_CASE("Perft Kiwipete", "[perft][castling][en-passant]") {
+  game::Game game(
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      0);
+  REQUIRE(perft::Perft(game, 1) == 48);
+  REQUIRE(perft::Perft(game, 2) == 2039);
+}
+
+TEST_CASE("Perft Position 3", "[perft][en-passant]") {
+  game::Game game("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 0);
+  REQUIRE(perft::Perft(game, 1) == 14);
+  REQUIRE(perft::Perft(game, 2) == 191);
+  REQUIRE(perft::Perft(game, 3) == 2812);
+}
+
+TEST_CASE("Perft With Table", "[perft][tt]") {
+  game::Game game(0);
+  tt::Table table(1);
+  REQUIRE(perft::Perft(game, 3, &table) == 8902);
+  // Served from the table the second time.
+  REQUIRE(perft::Perft(game, 3, &table) == 8902);
+  REQUIRE(perft::Perft(game, 4, &table) == 197281);
+}
+
+TEST_CASE("Perft Divide", "[perft]") {
+  game::Game game(0);
+  auto counts = perft::Divide(game, 2);
+  REQUIRE(counts.size() == 20);
+  uint64_t total = 0;
+  for (const auto& count : counts) {
+    REQUIRE(count.second == 20);
+    total += count.second;
+  }
+  REQUIRE(total == 400);
+}
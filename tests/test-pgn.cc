@@ -0,0 +1,71 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/pgn.h>
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The move the SAN names in UCI notation, or "" if none.
+auto Uci(game::Game* game, const std::string& san) -> std::string {
+  game::Move move;
+  return pgn::ParseSan(game, san, &move) ? game::ToUci(move) : "";
+}
+
+}  // namespace
+
+TEST_CASE("Portable Game Notation", "[pgn]") {
+  SECTION("Games are read one at a time") {
+    std::istringstream in(
+        "[Event \"Casual \\\"blitz\\\"\"]\n"
+        "[Result \"1-0\"]\n"
+        "\n"
+        "1. e4 {best by test} e5 2.Nf3 (2. f4 exf4 (2... d5)) 2... Nc6 $1\n"
+        "3. Bb5 a6! ; the Morphy\n"
+        "4. Ba4 1-0\n"
+        "\n"
+        "[Result \"0-1\"]\n"
+        "1. f3 e5 2. g4 Qh4#\n"
+        "[Result \"*\"]\n"
+        "1. d4 *\n");
+    pgn::Reader reader(&in);
+    pgn::Record record;
+    REQUIRE(reader.Next(&record));
+    REQUIRE(record.tags_["Event"] == "Casual \"blitz\"");
+    REQUIRE(record.result_ == "1-0");
+    const std::vector<std::string> ruy_lopez = {"e4",  "e5",  "Nf3", "Nc6",
+                                                "Bb5", "a6!", "Ba4"};
+    REQUIRE(record.moves_ == ruy_lopez);
+    // No termination marker: the Result tag stands in.
+    REQUIRE(reader.Next(&record));
+    REQUIRE(record.result_ == "0-1");
+    REQUIRE(record.moves_.size() == 4);
+    REQUIRE(reader.Next(&record));
+    REQUIRE(record.result_ == "*");
+    REQUIRE(record.moves_.size() == 1);
+    REQUIRE(record.moves_[0] == "d4");
+    REQUIRE_FALSE(reader.Next(&record));
+  }
+
+  SECTION("SAN names one legal move") {
+    game::Game game("4k3/8/8/8/8/5N2/8/RN2K2R w KQ - 0 1", 0);
+    REQUIRE(Uci(&game, "Nd2").empty());
+    REQUIRE(Uci(&game, "Nbd2") == "b1d2");
+    REQUIRE(Uci(&game, "Nfd2+") == "f3d2");
+    REQUIRE(Uci(&game, "O-O") == "e1g1");
+    REQUIRE(Uci(&game, "O-O-O").empty());
+    REQUIRE(Uci(&game, "Ra1").empty());
+    REQUIRE(Uci(&game, "Nxe5") == "f3e5");
+    REQUIRE(Uci(&game, "e4").empty());
+    // A pinned knight can't move, so the other needs no disambiguation.
+    game::Game pinned("k3r3/8/8/8/8/2N1N3/8/4K3 w - - 0 1", 0);
+    REQUIRE(Uci(&pinned, "Nd5") == "c3d5");
+    game::Game pawns("4k3/1P6/8/3p4/4P3/8/8/4K3 w - - 0 1", 0);
+    REQUIRE(Uci(&pawns, "exd5") == "e4d5");
+    REQUIRE(Uci(&pawns, "e5") == "e4e5");
+    REQUIRE(Uci(&pawns, "b8=Q").empty());
+  }
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/polyglot.h>
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Plays the moves, given in UCI notation. Returns false if one is illegal.
+auto Play(game::Game* game, const std::vector<std::string>& line) -> bool {
+  for (const std::string& uci : line) {
+    bool played = false;
+    for (const game::Move& m : game->LegalMoves(game->turn_)) {
+      if (game::ToUci(m) == uci) {
+        played = game->PlayTurn(m);
+        break;
+      }
+    }
+    if (!played) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto Find(game::Game* game, const std::string& uci) -> game::Move {
+  for (const game::Move& m : game->LegalMoves(game->turn_)) {
+    if (game::ToUci(m) == uci) {
+      return m;
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
+TEST_CASE("Polyglot Opening Books", "[polyglot]") {
+  SECTION("Keys follow the position, not the move order") {
+    game::Game start(0);
+    game::Game knights(0);
+    REQUIRE(Play(&knights, {"g1f3", "g8f6", "f3g1", "f6g8"}));
+    REQUIRE(polyglot::Key(knights) == polyglot::Key(start));
+    game::Game e4(0);
+    REQUIRE(Play(&e4, {"e2e4"}));
+    REQUIRE(polyglot::Key(e4) != polyglot::Key(start));
+    // Moving the king loses castling though it comes back.
+    game::Game king(0);
+    REQUIRE(Play(&king, {"e2e4", "e7e5", "e1e2", "e8e7", "e2e1", "e7e8"}));
+    game::Game pawns(0);
+    REQUIRE(Play(&pawns, {"e2e4", "e7e5"}));
+    REQUIRE(polyglot::Key(king) != polyglot::Key(pawns));
+  }
+
+  SECTION("En passant counts only when a capture is possible") {
+    // A game set up from a FEN has no last move to take en passant.
+    game::Game can_take(0);
+    REQUIRE(Play(&can_take, {"e2e4", "g8f6", "e4e5", "f6g8", "g1f3", "d7d5"}));
+    const game::Game same_pieces(
+        "rnbqkbnr/ppp1pppp/8/3pP3/8/5N2/PPPP1PPP/RNBQKB1R w KQkq - 0 4", 0);
+    REQUIRE(polyglot::Key(can_take) != polyglot::Key(same_pieces));
+    game::Game cannot_take(0);
+    REQUIRE(Play(&cannot_take, {"e2e4", "d7d5"}));
+    const game::Game set_up(
+        "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2", 0);
+    REQUIRE(polyglot::Key(cannot_take) == polyglot::Key(set_up));
+  }
+
+  SECTION("Moves pack and unpack") {
+    game::Game game("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", 0);
+    const game::Move castle = Find(&game, "e1g1");
+    REQUIRE(castle.IsCastling_);
+    // Castling is packed as the king taking its rook.
+    REQUIRE(polyglot::Encode(castle) == (7 | 0 << 3 | 4 << 6 | 0 << 9));
+    REQUIRE(polyglot::Decode(polyglot::Encode(castle), game) == "e1g1");
+    REQUIRE(polyglot::Decode(polyglot::Encode(Find(&game, "e1c1")), game) ==
+            "e1c1");
+    REQUIRE(polyglot::Decode(polyglot::Encode(Find(&game, "a1a8")), game) ==
+            "a1a8");
+  }
+
+  SECTION("Books are probed by key and picked by weight") {
+    game::Game start(0);
+    game::Game after(0);
+    REQUIRE(Play(&after, {"e2e4"}));
+    const uint64_t key = polyglot::Key(start);
+    const std::vector<polyglot::Entry> entries = {
+        {polyglot::Key(after), polyglot::Encode(Find(&after, "c7c5")), 5, 0},
+        {key, polyglot::Encode(Find(&start, "e2e4")), 3, 0},
+        {key, polyglot::Encode(Find(&start, "d2d4")), 1, 0},
+        // Illegal here: never picked.
+        {key, polyglot::Encode(Find(&after, "c7c5")), 100, 0},
+        {1, 0, 1, 0},
+    };
+    polyglot::Book::Write("test.bin", entries);
+    std::unique_ptr<polyglot::Book> book = polyglot::Book::Open("test.bin");
+    std::remove("test.bin");
+    REQUIRE(book->Size() == entries.size());
+    REQUIRE(book->Probe(key).size() == 3);
+    REQUIRE(book->Probe(after).size() == 1);
+    REQUIRE(book->Probe(after)[0].weight_ == 5);
+    REQUIRE(book->Probe(key + 1).empty());
+
+    std::mt19937_64 random(3);
+    size_t e4 = 0;
+    for (size_t i = 0; i < 400; i++) {
+      game::Move move;
+      REQUIRE(book->Pick(&start, &random, &move));
+      REQUIRE((game::ToUci(move) == "e2e4" || game::ToUci(move) == "d2d4"));
+      e4 += game::ToUci(move) == "e2e4";
+    }
+    // Three in four, give or take.
+    REQUIRE(e4 > 250);
+    REQUIRE(e4 < 350);
+    game::Game elsewhere(0);
+    REQUIRE(Play(&elsewhere, {"a2a3"}));
+    game::Move move;
+    REQUIRE_FALSE(book->Pick(&elsewhere, &random, &move));
+  }
+
+  SECTION("Bad files are refused") {
+    std::ofstream("odd.bin") << "not a book";
+    REQUIRE_THROWS(polyglot::Book::Open("odd.bin"));
+    std::remove("odd.bin");
+    REQUIRE_THROWS(polyglot::Book::Open("no-such-book.bin"));
+  }
+
+  SECTION("Keys match Polyglot's published ones") {
+    game::Game game(0);
+    REQUIRE(polyglot::Key(game) == polyglot::kStartKey);
+    // Each key after the moves so far; en passant files count only when
+    // the capture is possible.
+    const std::vector<std::pair<std::string, uint64_t>> line = {
+        {"e2e4", 0x823C9B50FD114196ULL},
+        {"d7d5", 0x0756B94461C50FB0ULL},
+        {"e4e5", 0x662FAFB965DB29D4ULL},
+        {"f7f5", 0x22A48B5A8E47FF78ULL},
+        // White's castling rights are lost, then Black's.
+        {"e1e2", 0x652A607CA3F242C1ULL},
+        {"e8f7", 0x00FDD303C946BDD9ULL},
+    };
+    for (const std::pair<std::string, uint64_t>& step : line) {
+      REQUIRE(Play(&game, {step.first}));
+      REQUIRE(polyglot::Key(game) == step.second);
+    }
+    game::Game other(0);
+    REQUIRE(Play(&other, {"a2a4", "b7b5", "h2h4", "b5b4", "c2c4"}));
+    REQUIRE(polyglot::Key(other) == 0x3C8123EA7B067637ULL);
+    // Taking en passant, then the queen's rook losing its castling right.
+    REQUIRE(Play(&other, {"b4c3", "a1a3"}));
+    REQUIRE(polyglot::Key(other) == 0x5C3F9B829B279560ULL);
+  }
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/ponder.h>
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Waits for the ponderer to complete an iteration to the depth, or gives up
+// after ten seconds.
+void WaitForDepth(const ponder::Ponderer& ponderer, size_t depth) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (ponderer.Depth() < depth &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+auto IsLegal(game::Game* game, const std::string& uci) -> bool {
+  for (const game::Move& m : game->LegalMoves(game->turn_)) {
+    if (game::ToUci(m) == uci) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto Play(game::Game* game, const std::string& uci) -> bool {
+  for (const game::Move& m : game->LegalMoves(game->turn_)) {
+    if (game::ToUci(m) == uci) {
+      return game->PlayTurn(m);
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST_CASE("Pondering", "[ponder]") {
+  tt::Table table(1);
+
+  SECTION("Predicted replies have legal answers") {
+    ponder::Ponderer ponderer(&table, engine::Options(), 3);
+    game::Game game(0);
+    REQUIRE(Play(&game, "e2e4"));
+    ponderer.Start(game);
+    WaitForDepth(ponderer, 4);
+    ponderer.Stop();
+    REQUIRE(ponderer.Depth() >= 4);
+    const std::vector<std::string> replies = ponderer.Replies();
+    REQUIRE(replies.size() == 3);
+    for (const std::string& reply : replies) {
+      ponder::Answer answer;
+      REQUIRE(ponderer.Lookup(reply, &answer));
+      REQUIRE(answer.depth_ + 1 == ponderer.Depth());
+      game::Game after = game;
+      REQUIRE(Play(&after, reply));
+      REQUIRE(IsLegal(&after, answer.move_));
+    }
+    ponder::Answer answer;
+    REQUIRE_FALSE(ponderer.Lookup("a7a5", &answer));
+  }
+
+  SECTION("Starting again forgets the last answers") {
+    ponder::Ponderer ponderer(&table);
+    ponderer.Start(game::Game(0));
+    WaitForDepth(ponderer, 2);
+    ponderer.Start(game::Game(
+        "r1bqk1nr/pppp1ppp/2n5/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+        0));
+    ponder::Answer answer;
+    REQUIRE_FALSE(ponderer.Lookup("e2e4", &answer));
+    // Destroying a ponderer stops its search.
+  }
+}
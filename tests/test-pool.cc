@@ -0,0 +1,146 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/perft.h>
+#include <chess/pool.h>
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Work Stealing Deque", "[pool][deque]") {
+  pool::WorkStealingDeque<int*> deque(2);
+  int items[100];
+
+  SECTION("Owner pops last in first out, thieves steal first in") {
+    deque.Push(&items[0]);
+    deque.Push(&items[1]);
+    deque.Push(&items[2]);
+    REQUIRE(deque.Pop() == &items[2]);
+    REQUIRE(deque.Steal() == &items[0]);
+    REQUIRE(deque.Pop() == &items[1]);
+    REQUIRE(deque.Pop() == nullptr);
+    REQUIRE(deque.Steal() == nullptr);
+    REQUIRE(deque.Empty());
+  }
+
+  SECTION("Grows past its capacity") {
+    for (int& item : items) {
+      deque.Push(&item);
+    }
+    for (int i = 99; i >= 0; i--) {
+      REQUIRE(deque.Pop() == &items[i]);
+    }
+  }
+
+  SECTION("Every item is taken exactly once under contention") {
+    const int kItems = 100000;
+    std::vector<int> values(kItems);
+    std::vector<std::atomic<int>> taken(kItems);
+    for (std::atomic<int>& t : taken) {
+      t.store(0);
+    }
+    pool::WorkStealingDeque<int*> shared;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; t++) {
+      thieves.emplace_back([&] {
+        while (!done.load() || !shared.Empty()) {
+          if (int* item = shared.Steal()) {
+            taken[item - values.data()]++;
+          }
+        }
+      });
+    }
+    for (int i = 0; i < kItems; i++) {
+      shared.Push(&values[i]);
+      if (i % 3 == 0) {
+        if (int* item = shared.Pop()) {
+          taken[item - values.data()]++;
+        }
+      }
+    }
+    while (int* item = shared.Pop()) {
+      taken[item - values.data()]++;
+    }
+    done.store(true);
+    for (std::thread& thief : thieves) {
+      thief.join();
+    }
+    for (std::atomic<int>& t : taken) {
+      REQUIRE(t.load() == 1);
+    }
+  }
+}
+
+TEST_CASE("Thread Pool", "[pool]") {
+  pool::ThreadPool threads(4);
+  REQUIRE(threads.Size() == 4);
+  REQUIRE(threads.WorkerIndex() == -1);
+
+  SECTION("Task group runs every task") {
+    std::atomic<int> sum(0);
+    pool::TaskGroup group(&threads);
+    for (int i = 1; i <= 1000; i++) {
+      group.Run([&sum, i] { sum += i; });
+    }
+    group.Wait();
+    REQUIRE(sum.load() == 500500);
+  }
+
+  SECTION("Nested groups don't deadlock") {
+    // More nested waits than workers: waiting tasks must help.
+    std::atomic<int> leaves(0);
+    pool::TaskGroup outer(&threads);
+    for (int i = 0; i < 16; i++) {
+      outer.Run([&threads, &leaves] {
+        pool::TaskGroup inner(&threads);
+        for (int j = 0; j < 16; j++) {
+          inner.Run([&leaves] { leaves++; });
+        }
+        inner.Wait();
+      });
+    }
+    outer.Wait();
+    REQUIRE(leaves.load() == 256);
+  }
+
+  SECTION("Cancelled tasks are skipped") {
+    std::atomic<int> ran(0);
+    pool::TaskGroup group(&threads);
+    group.Cancel();
+    for (int i = 0; i < 100; i++) {
+      group.Run([&ran] { ran++; });
+    }
+    group.Wait();
+    REQUIRE(ran.load() == 0);
+    REQUIRE(group.Cancelled());
+  }
+
+  SECTION("Exceptions reach Wait") {
+    pool::TaskGroup group(&threads);
+    group.Run([] { throw std::runtime_error("task failed"); });
+    REQUIRE_THROWS(group.Wait());
+  }
+
+  SECTION("Parallel perft matches serial perft") {
+    game::Game game(0);
+    REQUIRE(perft::ParallelPerft(game, 3, &threads) == 8902);
+    game::Game kiwipete(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        0);
+    REQUIRE(perft::ParallelPerft(kiwipete, 3, &threads) == 97862);
+  }
+}
+
+TEST_CASE("Pinned Thread Pool", "[pool]") {
+  pool::ThreadPool threads(2, true);
+  std::atomic<int> ran(0);
+  pool::TaskGroup group(&threads);
+  for (int i = 0; i < 10; i++) {
+    group.Run([&ran] { ran++; });
+  }
+  group.Wait();
+  REQUIRE(ran.load() == 10);
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/engine.h>
+#include <chess/stats.h>
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <sstream>
+#include <string>
+
+TEST_CASE("Search Statistics", "[stats]") {
+  SECTION("Effective branching factor") {
+    stats::SearchStats s;
+    REQUIRE(s.EffectiveBranchingFactor() == Approx(0));
+    for (size_t depth = 1; depth <= 4; depth++) {
+      stats::Iteration it;
+      it.depth_ = depth;
+      it.nodes_ = static_cast<uint64_t>(std::pow(3, depth));
+      s.iterations_.push_back(it);
+    }
+    REQUIRE(s.EffectiveBranchingFactor() == Approx(3));
+  }
+
+  SECTION("Threads add up") {
+    stats::SearchStats a;
+    a.nodes_ = 10;
+    a.cutoffs_[0] = 3;
+    a.cutoffs_[stats::kMoveIndices - 1] = 1;
+    stats::SearchStats b = a;
+    b.null_move_tries_ = 4;
+    b.null_move_cutoffs_ = 1;
+    a.Add(b);
+    REQUIRE(a.threads_ == 2);
+    REQUIRE(a.nodes_ == 20);
+    REQUIRE(a.Cutoffs() == 8);
+    REQUIRE(std::abs(a.FirstMoveCutoffRate() - 0.75) < 1e-9);
+    REQUIRE(std::abs(a.NullMoveSuccessRate() - 0.25) < 1e-9);
+  }
+
+  SECTION("A search counts its work") {
+    tt::Table table(1);
+    engine::Searcher searcher(
+        game::Game("r1bqk1nr/pppp1ppp/2n5/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R "
+                   "w KQkq - 4 4", 0),
+        &table);
+    engine::Limits limits;
+    limits.depth_ = 4;
+    size_t reports = 0;
+    limits.on_stats_ = [&reports](const stats::SearchStats&) { reports++; };
+    const engine::Result result = searcher.Search(limits);
+    const stats::SearchStats& s = result.stats_;
+    REQUIRE(reports >= 4);
+    REQUIRE(s.nodes_ == result.nodes_);
+    REQUIRE(s.Cutoffs() == result.cutoffs_);
+    REQUIRE(s.hash_probes_ > 0);
+    REQUIRE(s.hash_hits_ <= s.hash_probes_);
+    REQUIRE(s.iterations_.size() == 4);
+    uint64_t nodes = 0;
+    for (const stats::Iteration& it : s.iterations_) {
+      nodes += it.nodes_;
+    }
+    REQUIRE(nodes == s.nodes_);
+    REQUIRE(s.EffectiveBranchingFactor() > 1);
+
+    std::stringstream json;
+    s.WriteJson(json);
+    REQUIRE(json.str().front() == '{');
+    REQUIRE(json.str().find("\"effective_branching_factor\":") !=
+            std::string::npos);
+    REQUIRE(json.str().find("\"iterations\":[{\"depth\":1,") !=
+            std::string::npos);
+  }
+
+  SECTION("A parallel search adds up its threads") {
+    tt::Table table(1);
+    engine::ParallelSearcher searcher(game::Game(0), 2, &table);
+    engine::Limits limits;
+    limits.depth_ = 4;
+    const engine::Result result = searcher.Search(limits);
+    REQUIRE(result.stats_.threads_ == 2);
+    REQUIRE(result.stats_.nodes_ == result.nodes_);
+    REQUIRE(searcher.Stats().nodes_ == result.nodes_);
+  }
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/engine.h>
+#include <chess/timeman.h>
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <thread>
+
+TEST_CASE("Time Allocation", "[timeman]") {
+  SECTION("Sudden death spreads the clock over the game") {
+    timeman::TimeControl control;
+    control.time_ms_ = 60000;
+    control.overhead_ms_ = 0;
+    timeman::TimeManager time(control);
+    REQUIRE(time.SoftLimitMs() == 2000);
+    REQUIRE(time.HardLimitMs() == 8000);
+  }
+
+  SECTION("Increment and moves to go") {
+    timeman::TimeControl control;
+    control.time_ms_ = 10000;
+    control.increment_ms_ = 1000;
+    control.moves_to_go_ = 10;
+    control.overhead_ms_ = 0;
+    timeman::TimeManager time(control);
+    REQUIRE(time.SoftLimitMs() == 1000 + 750);
+  }
+
+  SECTION("Limits never exceed the time left") {
+    timeman::TimeControl control;
+    control.time_ms_ = 100;
+    control.increment_ms_ = 5000;
+    timeman::TimeManager time(control);
+    // The overhead is kept in reserve once, not twice.
+    REQUIRE(time.HardLimitMs() == 100 - control.overhead_ms_);
+    REQUIRE(time.SoftLimitMs() <= time.HardLimitMs());
+  }
+
+  SECTION("A fixed time is spent in full") {
+    timeman::TimeManager time = timeman::TimeManager::FixedTime(50);
+    REQUIRE(time.SoftLimitMs() == 50);
+    REQUIRE(time.HardLimitMs() == 50);
+    REQUIRE(time.StartIteration(1));
+    REQUIRE(time.StartIteration(1));
+    REQUIRE(!time.HardLimitReached());
+  }
+
+  SECTION("A settled best move stops sooner") {
+    timeman::TimeControl control;
+    control.time_ms_ = 1000;
+    control.moves_to_go_ = 1;
+    control.overhead_ms_ = 0;
+    timeman::TimeManager changing(control);
+    timeman::TimeManager stable(control);
+    for (uint16_t i = 1; i <= 6; i++) {
+      changing.StartIteration(i);
+      stable.StartIteration(1);
+    }
+    // After 0.4 of the soft limit, more than a settled search allows.
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    REQUIRE(changing.StartIteration(7));
+    REQUIRE(!stable.StartIteration(1));
+  }
+}
+
+TEST_CASE("Timed Search", "[timeman][engine]") {
+  game::Game game(0);
+  engine::Searcher searcher(game);
+
+  SECTION("Move time") {
+    engine::Limits limits;
+    limits.move_time_ms_ = 100;
+    const engine::Result result = searcher.Search(limits);
+    REQUIRE(!result.pv_.empty());
+    // Generous, as the machine running the tests may be loaded.
+    REQUIRE(result.seconds_ < 0.1 + 0.05);
+    REQUIRE(result.seconds_ >= 0.1);
+  }
+
+  SECTION("Clock") {
+    engine::Limits limits;
+    limits.clock_.time_ms_ = 3000;
+    const engine::Result result = searcher.Search(limits);
+    REQUIRE(!result.pv_.empty());
+    REQUIRE(result.seconds_ < 0.4 + 0.05);
+  }
+
+  SECTION("A tight hard limit cuts the first iteration short") {
+    game::Game kiwipete("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/"
+                        "R3K2R w KQkq - 0 1", 0);
+    engine::Options options;
+    options.multi_pv_ = 3;
+    engine::Searcher busy(kiwipete, nullptr, options);
+    engine::Limits limits;
+    limits.move_time_ms_ = 5;
+    const engine::Result result = busy.Search(limits);
+    REQUIRE(result.seconds_ < 0.005 + 0.005);
+    // Still a legal move to play.
+    REQUIRE(!result.pv_.empty());
+    const game::Move move =
+        kiwipete.GetMoveFromStr(result.pv_[0], kiwipete.turn_);
+    REQUIRE(kiwipete.PlayTurn(move));
+  }
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/game.h>
+#include <chess/tt.h>
+#include <catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+auto Play(game::Game* game, const std::string& move) -> bool {
+  return game->PlayTurn(game->GetMoveFromStr(move, game->turn_));
+}
+
+}  // namespace
+
+TEST_CASE("Zobrist Keys", "[tt][zobrist]") {
+  game::Game game(0);
+  const uint64_t start = game.key_;
+  REQUIRE(start == game.ComputeKey());
+
+  SECTION("Incremental key matches a full computation") {
+    // An en passant capture, a capture and castling on both sides.
+    for (const char* move :
+         {"4143", "0605", "4344", "5654", "4455", "6755", "6052", "4645",
+          "5023", "5746", "4060", "4767"}) {
+      REQUIRE(Play(&game, move));
+      REQUIRE(game.key_ == game.ComputeKey());
+    }
+  }
+
+  SECTION("Undo restores the key") {
+    REQUIRE(Play(&game, "6052"));
+    REQUIRE(game.key_ != start);
+    game.UndoTurn();
+    REQUIRE(game.key_ == start);
+  }
+
+  SECTION("Null moves flip the side to move in the key") {
+    REQUIRE(Play(&game, "4143"));
+    game.PlayNullMove();
+    REQUIRE(game.turn_ == game.white_);
+    // The en passant file is gone, only the side to move changed.
+    REQUIRE(game.key_ == game.ComputeKey());
+    REQUIRE(Play(&game, "3133"));
+    game.UndoTurn();
+    game.UndoTurn();
+    REQUIRE(game.turn_ == game.black_);
+    REQUIRE(game.key_ == game.ComputeKey());
+  }
+
+  SECTION("Transpositions share a key") {
+    game::Game other(0);
+    REQUIRE(Play(&game, "6052"));
+    REQUIRE(Play(&game, "6755"));
+    REQUIRE(Play(&game, "1022"));
+    REQUIRE(Play(&other, "1022"));
+    REQUIRE(Play(&other, "6755"));
+    REQUIRE(Play(&other, "6052"));
+    REQUIRE(game.key_ == other.key_);
+    REQUIRE(game.key_ == game::Game(
+        "rnbqkb1r/pppppppp/5n2/8/8/2N2N2/PPPPPPPP/R1BQKB1R b KQkq - 0 1", 0)
+        .key_);
+  }
+
+  SECTION("Side to move and castling rights change the key") {
+    game::Game black(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1", 0);
+    game::Game no_castling(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1", 0);
+    REQUIRE(black.key_ != start);
+    REQUIRE(no_castling.key_ != start);
+  }
+}
+
+TEST_CASE("Transposition Table", "[tt]") {
+  tt::Table table(1);
+  REQUIRE(table.Bytes() == 1 << 20);
+  REQUIRE(table.Hashfull() == 0);
+
+  SECTION("Store and probe") {
+    tt::Entry entry;
+    entry.value_ = 12345;
+    entry.depth_ = 7;
+    entry.bound_ = tt::Bound::kLower;
+    table.Store(42, entry);
+    tt::Entry found;
+    REQUIRE(table.Probe(42, &found));
+    REQUIRE(found.value_ == 12345);
+    REQUIRE(found.depth_ == 7);
+    REQUIRE(found.bound_ == tt::Bound::kLower);
+    // Same bucket, different key.
+    REQUIRE_FALSE(table.Probe(42 + (uint64_t{1} << 40), &found));
+  }
+
+  SECTION("Search values round trip") {
+    tt::SearchValue value;
+    value.move_ = tt::PackMove(4, 1, 4, 3);
+    value.score_ = -31990;
+    value.eval_ = 25;
+    tt::SearchValue back = tt::UnpackSearch(tt::PackSearch(value));
+    REQUIRE(back.move_ == value.move_);
+    REQUIRE(back.score_ == value.score_);
+    REQUIRE(back.eval_ == value.eval_);
+  }
+
+  SECTION("Replacement prefers depth and current entries") {
+    // Five keys into one four entry bucket.
+    const uint64_t stride = uint64_t{1} << 32;
+    tt::Entry entry;
+    for (uint64_t i = 0; i < 4; i++) {
+      entry.depth_ = static_cast<uint8_t>(10 + i);
+      table.Store(i * stride, entry);
+    }
+    entry.depth_ = 1;
+    table.Store(4 * stride, entry);
+    tt::Entry found;
+    REQUIRE_FALSE(table.Probe(0, &found));
+    REQUIRE(table.Probe(4 * stride, &found));
+    // Old deep entries go before current shallow ones.
+    table.NewSearch();
+    table.NewSearch();
+    table.Store(4 * stride, entry);
+    table.Store(5 * stride, entry);
+    REQUIRE(table.Probe(4 * stride, &found));
+    REQUIRE(table.Probe(5 * stride, &found));
+  }
+
+  SECTION("Hashfull counts current entries") {
+    tt::Entry entry;
+    for (uint64_t key = 1; key < 20000; key++) {
+      table.Store(key * 0x9E3779B97F4A7C15ULL, entry);
+    }
+    REQUIRE(table.Hashfull() > 0);
+    table.NewSearch();
+    REQUIRE(table.Hashfull() == 0);
+  }
+
+  SECTION("Concurrent stores never return another key's data") {
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; t++) {
+      threads.emplace_back([&table, t] {
+        tt::Entry entry;
+        tt::Entry found;
+        for (uint64_t i = 0; i < 100000; i++) {
+          const uint64_t key = (i * 4 + t) * 0x9E3779B97F4A7C15ULL;
+          entry.value_ = key & tt::kMaxValue;
+          table.Store(key, entry);
+          const uint64_t probe = (i * 4 + 3 - t) * 0x9E3779B97F4A7C15ULL;
+          if (table.Probe(probe, &found)) {
+            REQUIRE(found.value_ == (probe & tt::kMaxValue));
+          }
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+}
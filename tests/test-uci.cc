@@ -0,0 +1,123 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/uci.h>
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+
+namespace {
+
+auto Count(const std::string& text, const std::string& word) -> size_t {
+  size_t n = 0;
+  for (size_t at = text.find(word); at != std::string::npos;
+       at = text.find(word, at + 1)) {
+    n++;
+  }
+  return n;
+}
+
+}  // namespace
+
+TEST_CASE("UCI Protocol", "[uci]") {
+  std::ostringstream out;
+
+  SECTION("The handshake lists the options") {
+    uci::Engine engine(&out);
+    REQUIRE(engine.Handle("uci"));
+    REQUIRE(engine.Handle("isready"));
+    REQUIRE(out.str().find("id name ") == 0);
+    REQUIRE(out.str().find("option name Hash type spin") !=
+            std::string::npos);
+    REQUIRE(out.str().find("uciok\nreadyok\n") != std::string::npos);
+    REQUIRE_FALSE(engine.Handle("quit"));
+  }
+
+  SECTION("A search to a depth sends info and its best move") {
+    uci::Engine engine(&out);
+    engine.Handle("position startpos moves e2e4 e7e5");
+    engine.Handle("go depth 3");
+    engine.Wait();
+    REQUIRE(out.str().find("info depth 3 score cp ") != std::string::npos);
+    REQUIRE(Count(out.str(), "bestmove ") == 1);
+    REQUIRE(out.str().find(" ponder ") != std::string::npos);
+  }
+
+  SECTION("Mates are scored in moves") {
+    REQUIRE(uci::FormatScore(-42) == "cp -42");
+    REQUIRE(uci::FormatScore(32000 - 3) == "mate 2");
+    REQUIRE(uci::FormatScore(-(32000 - 2)) == "mate -1");
+    uci::Engine engine(&out);
+    engine.Handle("position fen 6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    engine.Handle("go depth 3");
+    engine.Wait();
+    REQUIRE(out.str().find("score mate 1 ") != std::string::npos);
+    REQUIRE(out.str().find("bestmove a1a8") != std::string::npos);
+  }
+
+  SECTION("A search without limits runs until stopped") {
+    uci::Engine engine(&out);
+    engine.Handle("setoption name Threads value 2");
+    engine.Handle("go infinite");
+    engine.Handle("stop");
+    REQUIRE(Count(out.str(), "bestmove ") == 1);
+  }
+
+  SECTION("Pondering sends its best move after the ponder hit only") {
+    uci::Engine engine(&out);
+    engine.Handle("position startpos moves d2d4 d7d5");
+    engine.Handle("go ponder depth 2");
+    engine.Handle("ponderhit");
+    engine.Wait();
+    REQUIRE(Count(out.str(), "bestmove ") == 1);
+    // A ponder miss is stopped and answered, then the real search runs.
+    engine.Handle("go ponder wtime 1000 btime 1000");
+    engine.Handle("stop");
+    engine.Handle("position startpos moves d2d4 d7d5 c2c4");
+    engine.Handle("go movetime 50");
+    engine.Wait();
+    REQUIRE(Count(out.str(), "bestmove ") == 3);
+  }
+
+  SECTION("Bad input is reported, not fatal") {
+    uci::Engine engine(&out);
+    engine.Handle("position startpos moves e2e5");
+    engine.Handle("position fen not-a-fen");
+    engine.Handle("setoption name MultiPV value many");
+    engine.Handle("setoption name Hash value 1");
+    engine.Handle("setoption name MultiPV value 2");
+    engine.Handle("launch");
+    REQUIRE(out.str().find("illegal move e2e5") != std::string::npos);
+    REQUIRE(Count(out.str(), "info string") == 4);
+    engine.Handle("go depth 2");
+    engine.Wait();
+    REQUIRE(out.str().find("multipv 2") != std::string::npos);
+  }
+
+  SECTION("Promotions are refused in positions and sent for pawns") {
+    uci::Engine engine(&out);
+    engine.Handle("position fen 8/4P3/8/8/8/8/7r/K1k5 w - - 0 1 "
+                  "moves e7e8q");
+    engine.Handle("go depth 2");
+    engine.Wait();
+    REQUIRE(out.str().find("promotion unsupported: e7e8q") !=
+            std::string::npos);
+    REQUIRE(out.str().find("bestmove 0000") != std::string::npos);
+    // The pawn's only move: it stays a pawn in the game, but the GUI is
+    // told of a queen.
+    engine.Handle("position fen 8/4P3/8/8/8/8/7r/K1k5 w - - 0 1");
+    engine.Handle("go depth 2");
+    engine.Wait();
+    REQUIRE(out.str().find("bestmove e7e8q\n") != std::string::npos);
+    REQUIRE(out.str().find(" pv e7e8q\n") != std::string::npos);
+  }
+
+  SECTION("Commands are read until quit") {
+    std::istringstream in("uci\nposition startpos\ngo depth 2\n"
+                          "quit\nisready\n");
+    uci::Engine engine(&out);
+    engine.Run(&in);
+    REQUIRE(Count(out.str(), "bestmove ") == 1);
+    REQUIRE(out.str().find("readyok") == std::string::npos);
+  }
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/bookmaker.h>
+#include <gflags/gflags.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+DEFINE_string(pgn, "", "comma-separated PGN files to build the book from.");
+DEFINE_string(out, "book.bin", "the Polyglot book file to write.");
+DEFINE_uint32(plies, 24, "plies of each game put in the book.");
+DEFINE_uint32(min_games, 1, "leave out moves played in fewer games.");
+DEFINE_uint64(memory_mb, 256, "memory for counts before they are spilled "
+              "to run files, in megabytes.");
+DEFINE_string(temp_dir, ".", "the directory run files are made in.");
+DEFINE_uint32(threads, 0, "threads replaying games, 0 for the hardware "
+              "thread count.");
+
+// Streams the PGN files through a bookmaker::Builder and writes the book.
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Build a Polyglot opening book from PGN files. "
+                          "Pass --helpshort for options.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_pgn.empty()) {
+    std::cerr << "no --pgn files given\n";
+    return 1;
+  }
+
+  bookmaker::Options options;
+  options.max_plies_ = FLAGS_plies;
+  options.min_games_ = FLAGS_min_games;
+  options.memory_mb_ = FLAGS_memory_mb;
+  options.temp_dir_ = FLAGS_temp_dir;
+  try {
+    pool::ThreadPool pool(FLAGS_threads);
+    bookmaker::Builder builder(options);
+    const auto start = std::chrono::steady_clock::now();
+    std::stringstream files(FLAGS_pgn);
+    std::string file;
+    while (std::getline(files, file, ',')) {
+      std::ifstream in(file);
+      if (!in) {
+        std::cerr << "can't open " << file << "\n";
+        return 1;
+      }
+      builder.Read(&in, &pool);
+      std::cout << "read " << file << "\n";
+    }
+    const bookmaker::Report report = builder.Write(FLAGS_out);
+    const double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << report.games_ << " games (" << report.skipped_
+              << " skipped, " << report.truncated_ << " cut short), "
+              << report.moves_ << " moves, " << report.runs_ << " runs\n"
+              << report.entries_ << " entries written to " << FLAGS_out
+              << " in " << std::fixed << std::setprecision(2) << seconds
+              << " s\n";
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
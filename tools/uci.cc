@@ -0,0 +1,13 @@
+// Copyright (c) 2020 Andrea Roy. All rights reserved.
+
+#include <chess/uci.h>
+
+#include <iostream>
+
+// Speaks UCI on standard input and output, for tournament managers and
+// GUIs. Built against the chess library alone.
+int main() {
+  uci::Engine engine(&std::cout);
+  engine.Run(&std::cin);
+  return 0;
+}